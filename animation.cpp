@@ -1,47 +1,68 @@
 #include <assert.h>
+#include <float.h>
 #include "texture.h"
 #include "animation.h"
 
-Animation AnimationBuild(int xCount, int yCount, int uvCount, float framerate, bool loop)
+static AnimationClip clips[MAX_ANIMATION_CLIPS];
+static int clipCount = 0;
+
+AnimationClipId AnimationBuild(int xCount, int yCount, int uvCount, float framerate, bool loop)
 {
-	Animation animation = { 0 };
-	animation.framerate = framerate;
-	animation.loop = loop;
-	animation.uvCount = uvCount;
-	assert(animation.uvCount  <= MAX_UVRECTS_ANIM);
+	assert(clipCount < MAX_ANIMATION_CLIPS);
+	assert(uvCount > 0 && uvCount <= MAX_UVRECTS_ANIM && uvCount <= xCount * yCount);
+
+	AnimationClip* clip_p = &clips[clipCount];
+	clip_p->framerate = framerate;
+	clip_p->loop = loop;
+	clip_p->uvCount = uvCount;
 
 	Vector2 uvSize = V2(1.0f / xCount, 1.0f / yCount);
 	for (int y = 0; y < yCount; y++)
 	{
-		for (int x = 0; x < xCount; x++)
+		for (int x = 0; x < xCount && y * xCount + x < uvCount; x++)
 		{
-			animation.uvRectsAnim[y * xCount + x] = NewRect(V2(x*uvSize.x, uvSize.y * (yCount - 1) - y*uvSize.y), uvSize);
+			clip_p->uvRects[y * xCount + x] = NewRect(V2(x*uvSize.x, uvSize.y * (yCount - 1) - y*uvSize.y), uvSize);
 		}
 	}
 
-	animation.uvRectCurrent = 0;
+	return clipCount++;
+}
 
+const AnimationClip* AnimationGetClip(AnimationClipId clip)
+{
+	assert(clip >= 0 && clip < clipCount);
+	return &clips[clip];
+}
+
+Animation AnimationPlay(AnimationClipId clip, double time)
+{
+	assert(clip >= 0 && clip < clipCount);
+	Animation animation = { clip, time };
 	return animation;
 }
 
-bool AnimationUpdate(Animation* animation_p, double time)
+static inline int AnimationFrame(const AnimationClip* clip_p, double tStart, double time)
 {
-	bool animationEnded = false;
-	float frameDuration = 1.0f / animation_p->framerate;
-	float tNext = animation_p->tStart + (animation_p->uvRectCurrent + 1) * frameDuration;
-	if (time >= tNext)
-	{
-		animation_p->uvRectCurrent = (animation_p->uvRectCurrent + 1) % animation_p->uvCount;
-		if (animation_p->uvRectCurrent == 0)
-		{
-			animation_p->tStart = time;
-			if (!animation_p->loop) animationEnded = true;
-		}
-	}
-	return animationEnded;
+	double elapsed = time - tStart;
+	return elapsed > 0 ? (int)(elapsed * clip_p->framerate) : 0;
+}
+
+bool AnimationEnded(const Animation* animation_p, double time)
+{
+	const AnimationClip* clip_p = AnimationGetClip(animation_p->clip);
+	return !clip_p->loop && AnimationFrame(clip_p, animation_p->tStart, time) >= clip_p->uvCount;
 }
 
-Rect AnimationGetCurrentUv(Animation* animation_p)
+double AnimationEndTime(const Animation* animation_p)
 {
-	return animation_p->uvRectsAnim[animation_p->uvRectCurrent];
-}
\ No newline at end of file
+	const AnimationClip* clip_p = AnimationGetClip(animation_p->clip);
+	return clip_p->loop ? DBL_MAX : animation_p->tStart + clip_p->uvCount / (double)clip_p->framerate;
+}
+
+Rect AnimationGetCurrentUv(const Animation* animation_p, double time)
+{
+	const AnimationClip* clip_p = AnimationGetClip(animation_p->clip);
+	int frame = AnimationFrame(clip_p, animation_p->tStart, time);
+	frame = clip_p->loop ? frame % clip_p->uvCount : (frame < clip_p->uvCount ? frame : clip_p->uvCount - 1);
+	return clip_p->uvRects[frame];
+}
@@ -2,21 +2,36 @@
 
 #include "rect.h"
 
-#define MAX_UVRECTS_ANIM 16
+#define MAX_UVRECTS_ANIM    16
+#define MAX_ANIMATION_CLIPS 16
+#define ANIMATION_CLIP_NONE -1
 
-struct Animation
+typedef int AnimationClipId;
+
+// Immutable flipbook over a sprite sheet, registered once and shared by every instance playing it.
+struct AnimationClip
 {
-	float tStart;
 	float framerate;
 	bool loop;
-
-	int uvRectCurrent;
 	int uvCount;
-	Rect uvRectsAnim[MAX_UVRECTS_ANIM];
+	Rect uvRects[MAX_UVRECTS_ANIM];
+};
+
+// A playing clip. Nothing is advanced per frame, the current frame is evaluated from time.
+struct Animation
+{
+	AnimationClipId clip;
+	double tStart;
 };
 
-Animation AnimationBuild(int xCount, int yCount, int uvCount, float framerate = 24, bool loop = true);
+// Registers a clip, call once at init.
+AnimationClipId AnimationBuild(int xCount, int yCount, int uvCount, float framerate = 24, bool loop = true);
+const AnimationClip* AnimationGetClip(AnimationClipId clip);
+
+Animation AnimationPlay(AnimationClipId clip, double time);
 
-bool AnimationUpdate(Animation* animation_p, double time);
+// Only non looping clips end, after their last frame was shown for a full frame duration.
+bool AnimationEnded(const Animation* animation_p, double time);
+double AnimationEndTime(const Animation* animation_p); // DBL_MAX for looping clips.
 
-Rect AnimationGetCurrentUv(Animation* animation_p);
+Rect AnimationGetCurrentUv(const Animation* animation_p, double time);
@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "assetpack.h"
+
+#define ASSET_PACK_MAGIC     0x4B415041 // "APAK"
+#define ASSET_PACK_VERSION   1
+#define ASSET_PACK_ALIGNMENT 16
+#define ASSET_PACK_ATLAS     "atlas"
+
+// Followed by the entries, the sources and then the entry data.
+struct AssetPackHeader
+{
+	U32 magic;
+	U32 version;
+	U32 entryCount;
+	U32 sourceCount;
+};
+
+// Start of the atlas entry, the RGBA8 pixels follow at the next ASSET_PACK_ALIGNMENT boundary.
+struct AssetPackAtlas
+{
+	int width;
+	int height;
+	int textureCount;
+	Rect uvRects[TEXTURES_COUNT];
+};
+
+static const AssetPack* MountedPack = nullptr;
+static int LoosePathCount = 0;
+static char LoosePaths[MAX_ASSET_PACK_ENTRIES][ASSET_PATH_SIZE];
+
+static inline U64 AssetPackAlign(U64 size)
+{
+	return (size + ASSET_PACK_ALIGNMENT - 1) & ~(U64)(ASSET_PACK_ALIGNMENT - 1);
+}
+
+static bool StampSource(const char* path, AssetPackSource* source_p)
+{
+	struct stat st;
+	if (strlen(path) >= ASSET_PATH_SIZE || stat(path, &st) != 0) return false;
+
+	memset(source_p, 0, sizeof(*source_p));
+	strcpy(source_p->path, path);
+	source_p->size = (U64)st.st_size;
+	source_p->modifiedTime = (S64)st.st_mtime;
+	return true;
+}
+
+static const AssetPackEntry* FindEntry(const AssetPack* pack_p, const char* path)
+{
+	for (U32 i = 0; i < pack_p->entryCount; i++)
+	{
+		if (strcmp(pack_p->entries_p[i].path, path) == 0) return &pack_p->entries_p[i];
+	}
+	return nullptr;
+}
+
+bool AssetPackOpen(AssetPack* pack_p, const char* path)
+{
+	memset(pack_p, 0, sizeof(*pack_p));
+	if (!FileMapOpen(&pack_p->map, path)) return false;
+
+	const U8* data_p = pack_p->map.data_p;
+	U64 size = pack_p->map.size;
+	const AssetPackHeader* header_p = (const AssetPackHeader*)data_p;
+	bool valid = size >= sizeof(AssetPackHeader) && header_p->magic == ASSET_PACK_MAGIC && header_p->version == ASSET_PACK_VERSION &&
+		header_p->entryCount <= MAX_ASSET_PACK_ENTRIES && header_p->sourceCount <= MAX_ASSET_PACK_SOURCES &&
+		size >= sizeof(AssetPackHeader) + header_p->entryCount * sizeof(AssetPackEntry) + header_p->sourceCount * sizeof(AssetPackSource);
+	if (valid)
+	{
+		pack_p->entryCount = header_p->entryCount;
+		pack_p->entries_p = (const AssetPackEntry*)(data_p + sizeof(AssetPackHeader));
+		for (U32 i = 0; valid && i < pack_p->entryCount; i++)
+		{
+			const AssetPackEntry* entry_p = &pack_p->entries_p[i];
+			valid = entry_p->offset <= size && entry_p->size <= size - entry_p->offset && memchr(entry_p->path, 0, ASSET_PATH_SIZE);
+		}
+	}
+	if (!valid) printf("WARNING: Asset pack %s is invalid\n", path);
+
+	const AssetPackSource* sources_p = (const AssetPackSource*)(pack_p->entries_p + pack_p->entryCount);
+	for (U32 i = 0; valid && i < header_p->sourceCount; i++)
+	{
+		AssetPackSource source;
+		if (!StampSource(sources_p[i].path, &source)) continue;
+		valid = source.size == sources_p[i].size && source.modifiedTime == sources_p[i].modifiedTime;
+		if (!valid) printf("WARNING: Asset pack %s is stale, %s changed\n", path, source.path);
+	}
+
+	if (!valid) AssetPackClose(pack_p);
+	return valid;
+}
+
+void AssetPackClose(AssetPack* pack_p)
+{
+	if (MountedPack == pack_p) MountedPack = nullptr;
+	FileMapClose(&pack_p->map);
+	memset(pack_p, 0, sizeof(*pack_p));
+}
+
+bool AssetPackGetAtlas(const AssetPack* pack_p, TextureAtlas* atlas_p)
+{
+	const AssetPackEntry* entry_p = FindEntry(pack_p, ASSET_PACK_ATLAS);
+	if (!entry_p || entry_p->size < sizeof(AssetPackAtlas)) return false;
+
+	const U8* data_p = pack_p->map.data_p + entry_p->offset;
+	const AssetPackAtlas* packed_p = (const AssetPackAtlas*)data_p;
+	if (packed_p->textureCount != TEXTURES_COUNT) return false;
+	if (entry_p->size != AssetPackAlign(sizeof(AssetPackAtlas)) + (U64)packed_p->width * packed_p->height * 4) return false;
+
+	memset(atlas_p, 0, sizeof(*atlas_p));
+	atlas_p->texture.width = packed_p->width;
+	atlas_p->texture.height = packed_p->height;
+	atlas_p->texture.nrChannels = 4;
+	atlas_p->texture.data_p = (U8*)(data_p + AssetPackAlign(sizeof(AssetPackAtlas)));
+	atlas_p->textureCount = packed_p->textureCount;
+	memcpy(atlas_p->uvRects, packed_p->uvRects, sizeof(atlas_p->uvRects));
+	return true;
+}
+
+void AssetPackMount(const AssetPack* pack_p)
+{
+	MountedPack = pack_p;
+}
+
+const U8* AssetPackFind(const char* path, U64* size_p)
+{
+	const AssetPackEntry* entry_p = MountedPack ? FindEntry(MountedPack, path) : nullptr;
+	if (entry_p)
+	{
+		*size_p = entry_p->size;
+		return MountedPack->map.data_p + entry_p->offset;
+	}
+
+	for (int i = 0; i < LoosePathCount; i++)
+	{
+		if (strcmp(LoosePaths[i], path) == 0) return nullptr;
+	}
+	if (MountedPack) printf("WARNING: %s is not in the asset pack, it is read loose\n", path);
+	if (LoosePathCount < MAX_ASSET_PACK_ENTRIES && strlen(path) < ASSET_PATH_SIZE) strcpy(LoosePaths[LoosePathCount++], path);
+	return nullptr;
+}
+
+static void WritePadding(FILE* file, U64 size)
+{
+	static const U8 padding[ASSET_PACK_ALIGNMENT] = { 0 };
+	U64 aligned = AssetPackAlign(size);
+	if (aligned != size) fwrite(padding, 1, (size_t)(aligned - size), file);
+}
+
+bool AssetPackWrite(const char* path, const TextureAtlas* atlas_p, const char* const texturePaths[], int textureCount)
+{
+	assert(!MountedPack);
+	assert(atlas_p->texture.nrChannels == 4 && atlas_p->textureCount == TEXTURES_COUNT);
+
+	AssetPackHeader header = { ASSET_PACK_MAGIC, ASSET_PACK_VERSION, 0, 0 };
+	AssetPackEntry entries[MAX_ASSET_PACK_ENTRIES] = { 0 };
+	AssetPackSource sources[MAX_ASSET_PACK_SOURCES] = { 0 };
+	FileMap looseMaps[MAX_ASSET_PACK_ENTRIES] = { 0 };
+
+	AssetPackAtlas packedAtlas = { atlas_p->texture.width, atlas_p->texture.height, atlas_p->textureCount };
+	memcpy(packedAtlas.uvRects, atlas_p->uvRects, sizeof(packedAtlas.uvRects));
+	U64 atlasPixelBytes = (U64)atlas_p->texture.width * atlas_p->texture.height * 4;
+	AssetPackEntry* atlasEntry_p = &entries[header.entryCount++];
+	strcpy(atlasEntry_p->path, ASSET_PACK_ATLAS);
+	atlasEntry_p->size = AssetPackAlign(sizeof(AssetPackAtlas)) + atlasPixelBytes;
+	for (int i = 0; i < textureCount && header.sourceCount < MAX_ASSET_PACK_SOURCES; i++)
+	{
+		if (StampSource(texturePaths[i], &sources[header.sourceCount])) header.sourceCount++;
+	}
+
+	// Loose files go in as they are, each one is also a source.
+	for (int i = 0; i < LoosePathCount && header.entryCount < MAX_ASSET_PACK_ENTRIES; i++)
+	{
+		FileMap* map_p = &looseMaps[header.entryCount];
+		if (!FileMapOpen(map_p, LoosePaths[i])) continue;
+		AssetPackEntry* entry_p = &entries[header.entryCount++];
+		strcpy(entry_p->path, LoosePaths[i]);
+		entry_p->size = map_p->size;
+		if (header.sourceCount < MAX_ASSET_PACK_SOURCES && StampSource(LoosePaths[i], &sources[header.sourceCount])) header.sourceCount++;
+	}
+
+	U64 offset = AssetPackAlign(sizeof(header) + header.entryCount * sizeof(AssetPackEntry) + header.sourceCount * sizeof(AssetPackSource));
+	for (U32 i = 0; i < header.entryCount; i++)
+	{
+		entries[i].offset = offset;
+		offset += AssetPackAlign(entries[i].size);
+	}
+
+	bool written = false;
+	FILE* file = fopen(path, "wb");
+	if (file)
+	{
+		fwrite(&header, sizeof(header), 1, file);
+		fwrite(entries, sizeof(AssetPackEntry), header.entryCount, file);
+		fwrite(sources, sizeof(AssetPackSource), header.sourceCount, file);
+		WritePadding(file, sizeof(header) + header.entryCount * sizeof(AssetPackEntry) + header.sourceCount * sizeof(AssetPackSource));
+
+		fwrite(&packedAtlas, sizeof(packedAtlas), 1, file);
+		WritePadding(file, sizeof(packedAtlas));
+		fwrite(atlas_p->texture.data_p, 1, (size_t)atlasPixelBytes, file);
+		WritePadding(file, atlasEntry_p->size);
+		for (U32 i = 1; i < header.entryCount; i++)
+		{
+			fwrite(looseMaps[i].data_p, 1, (size_t)looseMaps[i].size, file);
+			WritePadding(file, looseMaps[i].size);
+		}
+		written = !ferror(file);
+		fclose(file);
+	}
+	if (!written) printf("WARNING: Could not write asset pack %s\n", path);
+
+	for (U32 i = 1; i < header.entryCount; i++) FileMapClose(&looseMaps[i]);
+	return written;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "common.h"
+#include "filemap.h"
+#include "atlas.h"
+
+#define ASSET_PACK_PATH        "../assets/assets.pack"
+#define MAX_ASSET_PACK_ENTRIES 64
+#define MAX_ASSET_PACK_SOURCES 64
+#define ASSET_PATH_SIZE        64
+
+// Everything startup loads, cooked into one file: the texture atlas as flipped RGBA8 pixels ready for
+// upload, plus the shader sources and the font blob as they were read from disk. A table of contents
+// up front, every entry 16 byte aligned behind it. The pack is memory mapped and used in place.
+//
+// The pack remembers size and modification time of every loose file it was cooked from. When one of
+// them changed on disk it is stale, startup reads the loose files instead and cooks a new one. Sources
+// that don't exist are fine, that is a build shipping only the pack.
+struct AssetPackEntry
+{
+	char path[ASSET_PATH_SIZE]; // Loose file path the entry replaces, or the name of a cooked asset.
+	U64 offset;
+	U64 size;
+};
+
+struct AssetPackSource
+{
+	char path[ASSET_PATH_SIZE];
+	U64 size;
+	S64 modifiedTime;
+};
+
+struct AssetPack
+{
+	FileMap map;
+	U32 entryCount;
+	const AssetPackEntry* entries_p;
+};
+
+// False when the pack is missing, invalid or stale, with the map already closed.
+bool AssetPackOpen(AssetPack* pack_p, const char* path);
+void AssetPackClose(AssetPack* pack_p);
+bool AssetPackGetAtlas(const AssetPack* pack_p, TextureAtlas* atlas_p); // Pixels point into the pack.
+
+// AssetPackFind looks loose file paths up in the mounted pack. Paths it doesn't have are remembered,
+// they are what the game read loose and what AssetPackWrite cooks besides the atlas.
+void AssetPackMount(const AssetPack* pack_p); // nullptr to read everything loose.
+const U8* AssetPackFind(const char* path, U64* size_p); // nullptr when the path isn't in the mounted pack.
+
+// Cooks the atlas and every loose file read so far. Call once startup is done, with no pack mounted.
+bool AssetPackWrite(const char* path, const TextureAtlas* atlas_p, const char* const texturePaths[], int textureCount);
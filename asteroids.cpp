@@ -10,6 +10,11 @@
 #include "color.h"
 #include "utils.h"
 #include "animation.h"
+#include "broadphase.h"
+#include "entity.h"
+#include "pool.h"
+#include "particles.h"
+#include "asteroids.h"
 
 #define SHIP_ROTATION_SPEED    360 * 1.5f // Degrees per second.
 #define SHIP_ACCELERATION      1000.0f
@@ -26,23 +31,22 @@
 #define SHIP_DEATH_DURATION    3
 #define ASTEROID_ROT_SPEED_MIN 10
 #define ASTEROID_ROT_SPEED_MAX 20
-#define ASTEROID_SIZE_MIN      80
-#define ASTEROID_SIZE_MAX      280
 #define ASTEROID_BIG           (ASTEROID_SIZE_MIN + (ASTEROID_SIZE_MAX - ASTEROID_SIZE_MIN) / 2)
 #define ASTEROID_SPEED_MIN     50
 #define ASTEROID_SPEED_MAX     60
-#define PARTICLE_DEBRIS_LIFETIME      3.0f
-#define PARTICLE_EXHAUST_LIFETIME     0.3f
-#define MAX_PARTICLES_DEBRIS   100
-#define MAX_PARTICLES_EXHAUST  200
 #define MAX_CHARGEDBULLETS     8
 #define CHARGEDBULLET_SPEED    2000.0f
 #define EXHAUST_FREQUENCY      10.0f
-#define COLOR_EXHAUST          Col(0.6f, 0.8f, 1.0f, 1.0f);
-#define COLOR_EXHAUST_BOOST    Col(0.957f, 1.0f, 0.475f, 1.0f);
+#define SIM_HZ                 120
+#define SIM_DELTAT             (1.0f / SIM_HZ)
+#define MAX_SIM_STEPS_PER_FRAME 8 // Past this the game slows down instead of spiraling.
+#define COLOR_EXHAUST          Col(0.6f, 0.8f, 1.0f, 1.0f)
+#define COLOR_EXHAUST_BOOST    Col(0.957f, 1.0f, 0.475f, 1.0f)
 #define MAX_EXPLOSIONS_SMALL   16
+#define MAX_EXPLOSIONS_SMALL_GROWN 4096 // Explosions own no entity slots and are a clip plus a start time, their pool may grow.
 #define MAX_TURRETS            2
 #define SPEED_DESTROY          2000.0f
+#define BROADPHASE_CELL_SIZE   ASTEROID_SIZE_MAX // Largest collider diameter, see broadphase.h.
 
 enum SceneE : U8
 {
@@ -76,20 +80,27 @@ struct Turret
 	int prevAngle;
 };
 
-struct Entity
+// One packed list of live entities per kind, in the order they are fed to the collision passes.
+enum EntityListE : U8
+{
+	LIST_SHIP,
+	LIST_BULLETS,
+	LIST_ASTEROIDS,
+	LIST_TURRETS,
+	LIST_ENEMYBULLETS,
+	LIST_CHARGEDBULLETS,
+	LIST_COUNT,
+};
+
+// The per entity data the tick passes don't touch, indexed by the same EntityId as the EntityStore arrays.
+struct EntityInfo
 {
 	EntityTypeE type;
-	bool enabled;
-	double tEnabled;
 	double tInvisibility;
 	double tTakingDamage;
 	float size;
-	Vector2 pos;
-	Vector2 facingV;
-	Vector2 vel;
-	float rotSpeed;
-	float colliderRadius;
 	float health;
+	PoolHandle handle; // In the pool of its kind, if the kind has one.
 
 	union
 	{
@@ -109,20 +120,10 @@ struct Entity
 	Rect uv;
 };
 
-struct Particle
-{
-	bool enabled;
-	double tEnabled;
-
-	Vector2 pos;
-	Vector2 vel;
-	Color color;
-};
-
 struct CollisionEntities
 {
 	int count;
-	Entity* entities_p[MAX_ENTITIES];
+	EntityId ids[MAX_ENTITIES];
 };
 
 struct Camera
@@ -142,12 +143,6 @@ struct Level
 	int asteroidsCount;
 };
 
-struct ParticleSystem
-{
-	int index;
-	Particle* particles_p;
-};
-
 struct AnimationObject
 {
 	bool enabled;
@@ -160,30 +155,40 @@ extern Vector2 ScreenDim;
 static SceneE scene;
 static Camera camera;
 static Solid solid;
-static Entity ship;
-static Entity asteroids[MAX_ASTEROIDS];
+static StaticMeshHandleT solidMesh = STATIC_MESH_NONE;
+static EntityStore entities;
+static EntityInfo entityInfos[MAX_ENTITIES];
+static EntityId ship;
+static Pool<EntityId> asteroidPool;
 static CollisionEntities entityCollisions;
-static int bulletIdx;
-static Entity bullets[MAX_BULLETS];
-static int enemyBulletIdx;
-static Entity enemyBullets[MAX_BULLETS];
-static int chargedBulletIdx;
-static Entity chargedBullets[MAX_CHARGEDBULLETS];
-static Entity* chargedBulletHolding_p = nullptr;
+static Broadphase broadphase;
+static Pool<EntityId> bulletPool;
+static Pool<EntityId> enemyBulletPool;
+static Pool<EntityId> chargedBulletPool;
+static PoolHandle chargedBulletHolding = POOL_HANDLE_NONE;
 static bool paused;
 static MenuScreenE mainMenuScreen;
 static double time;
 static int score;
 static int asteroidsRemaining = 0;
 static Level level;
-static ParticleSystem psExhaust;
-static ParticleSystem psDebris;
+static ParticleSystem particles;
+static int emitterDebris;
+static int emitterExhaust;
+static int emitterExhaustBoost;
 static AnimationObject explosionCharged;
-static int explosionsSmallIdx;
-static AnimationObject explosionsSmall[MAX_EXPLOSIONS_SMALL];
+static Pool<AnimationObject> explosionSmallPool;
+static double explosionSmallNextEnd; // Earliest end of a live small explosion, the tick only sweeps the pool then.
+static AnimationClipId explosionSmallClip;
+static AnimationClipId explosionChargedClip;
+static AnimationClipId explosionShipClip;
 static AnimationObject explosionShip;
-static Entity turrets[MAX_TURRETS];
+static EntityId turrets[MAX_TURRETS];
 static double levelCountdown;
+static float shipAcceleration;
+static bool fireRequested; // Latched per rendered frame so a click isn't lost or repeated by the fixed step.
+static double simAccumulator;
+static GameSimStats simStats;
 
 static bool PausedMenu();
 
@@ -193,13 +198,25 @@ void GameInit()
 	mainMenuScreen = MENU_MAIN;
 	time = 0;
 
-	memset(&psDebris, 0, sizeof(psDebris));
-	psDebris.index = 0;
-	psDebris.particles_p = (Particle*)malloc(MAX_PARTICLES_DEBRIS * sizeof(Particle));
-
-	memset(&psExhaust, 0, sizeof(psExhaust));
-	psExhaust.index = 0;
-	psExhaust.particles_p = (Particle*)malloc(MAX_PARTICLES_EXHAUST * sizeof(Particle));
+	// Particle effects:                rate    lifetime  speed min/max  cone    spawn radius  size  color start          color end
+	ParticleEmitter debris =         { 0.0f,   3.0f,     30.0f, 30.0f,  360.0f, 20.0f,        2.0f, COLOR_WHITE,         Col(1.0f, 1.0f, 1.0f, 0.0f) };
+	ParticleEmitter exhaust =        { SIM_HZ, 0.3f,     80.0f, 80.0f,  270.0f, 0.0f,         2.0f, COLOR_EXHAUST,       Col(0.6f, 0.8f, 1.0f, 0.0f) };
+	ParticleEmitter exhaustBoost =   { SIM_HZ, 0.3f,     80.0f, 80.0f,  270.0f, 0.0f,         2.0f, COLOR_EXHAUST_BOOST, Col(0.957f, 1.0f, 0.475f, 0.0f) };
+	ParticlesInit(&particles, PARTICLES_MAX);
+	emitterDebris = ParticlesAddEmitter(&particles, &debris);
+	emitterExhaust = ParticlesAddEmitter(&particles, &exhaust);
+	emitterExhaustBoost = ParticlesAddEmitter(&particles, &exhaustBoost);
+
+	EntityStoreInit(&entities, MAX_ENTITIES, LIST_COUNT);
+	PoolInit(&asteroidPool, MAX_ASTEROIDS);
+	PoolInit(&bulletPool, MAX_BULLETS);
+	PoolInit(&enemyBulletPool, MAX_BULLETS);
+	PoolInit(&chargedBulletPool, MAX_CHARGEDBULLETS);
+	PoolInit(&explosionSmallPool, MAX_EXPLOSIONS_SMALL, MAX_EXPLOSIONS_SMALL_GROWN);
+	explosionShipClip = AnimationBuild(5, 2, 10, 24.0f, false);
+	explosionChargedClip = AnimationBuild(2, 2, 4, 24.0f, false);
+	explosionSmallClip = AnimationBuild(3, 3, 8, 24.0f, false);
+	BroadphaseInit(&broadphase, MAX_ENTITIES, BROADPHASE_CELL_SIZE);
 }
 
 static void BuildSolid(Solid* solid_p)
@@ -243,44 +260,99 @@ static Vector2 FindRandomPositionForAsteroid(float colliderRadius)
 	{
 		found = true;
 		pos = V2(GetRandomValue(-3000, 3000), GetRandomValue(-3000, 3000));
-		for (int i = 0; i < MAX_ASTEROIDS; i++)
+		EntityList* asteroidList_p = &entities.lists_p[LIST_ASTEROIDS];
+		for (int i = 0; i < asteroidList_p->count; i++)
 		{
-			Entity* asteroid_p = &asteroids[i];
-			float distCollision = colliderRadius + asteroid_p->colliderRadius;
+			EntityId asteroid = asteroidList_p->ids_p[i];
+			float distCollision = colliderRadius + entities.colliderRadius_p[asteroid];
 			float distCollisionSq = distCollision * distCollision;
-			float distSq = MagnitudeSq(pos - asteroid_p->pos);
+			float distSq = MagnitudeSq(pos - entities.pos_p[asteroid]);
 			if (distSq <= distCollisionSq) { found = false; break; }
 		}
 	}
 	return pos;
 }
 
-static Level AdvanceLevel(Level prevLevel)
+static Pool<EntityId>* EntityPool(EntityTypeE type)
 {
-	Level level = { 0 };
-	level.level = prevLevel.level + 1;
-	level.asteroidsCount = prevLevel.asteroidsCount * 2;
+	switch (type)
+	{
+	case ENTITY_ASTEROID:      return &asteroidPool;
+	case ENTITY_BULLET:        return &bulletPool;
+	case ENTITY_ENEMYBULLET:   return &enemyBulletPool;
+	case ENTITY_CHARGEDBULLET: return &chargedBulletPool;
+	default:                   return nullptr;
+	}
+}
+
+// Takes a free entity of the pool's kind and makes it live, ENTITY_INVALID when the pool is exhausted.
+static EntityId SpawnEntity(Pool<EntityId>* pool_p)
+{
+	PoolHandle handle = PoolAlloc(pool_p);
+	if (handle == POOL_HANDLE_NONE) return ENTITY_INVALID;
+
+	EntityId entity = *PoolGet(pool_p, handle);
+	entityInfos[entity].handle = handle;
+	EntitySpawn(&entities, entity);
+	return entity;
+}
+
+// Safe to call more than once for the same entity in a tick, e.g. a bullet overlapping two asteroids.
+static void DestroyEntity(EntityId entity)
+{
+	EntityKill(&entities, entity);
+	Pool<EntityId>* pool_p = EntityPool(entityInfos[entity].type);
+	if (pool_p) PoolFree(pool_p, entityInfos[entity].handle);
+}
 
-	for (int i = 0; i < level.asteroidsCount; i++)
+// Returns how many fit in the asteroid pool.
+static int SpawnLevelAsteroids(int count)
+{
+	int spawned = 0;
+	for (; spawned < count; spawned++)
 	{
-		Entity* asteroid_p = &asteroids[i];
-		asteroid_p->enabled = true;
-		asteroid_p->tEnabled = time;
-		asteroid_p->tInvisibility = time + INVISIBILITY_DURATION;
-		asteroid_p->size = GetRandomValue(ASTEROID_SIZE_MIN, ASTEROID_SIZE_MAX);
-		asteroid_p->colliderRadius = 0.7f * (asteroid_p->size / 2);
-		asteroid_p->uv = NewRect(GetRandomUvPos(V2(0.25f, 0.25f)), V2(0.25f, 0.25f));
-		asteroid_p->pos = FindRandomPositionForAsteroid(asteroid_p->colliderRadius);
-		asteroid_p->rotSpeed = GetRandomSign() * GetRandomValue(ASTEROID_ROT_SPEED_MIN, ASTEROID_ROT_SPEED_MAX);
-		asteroid_p->vel = GetRandomValue(ASTEROID_SPEED_MIN, ASTEROID_SPEED_MAX) * RotateDeg(VECTOR2_UP, GetRandomValue(0, 360));
+		EntityId asteroid = SpawnEntity(&asteroidPool);
+		if (asteroid == ENTITY_INVALID) break;
+
+		EntityInfo* asteroidInfo_p = &entityInfos[asteroid];
+		entities.tEnabled_p[asteroid] = time;
+		asteroidInfo_p->tInvisibility = time + INVISIBILITY_DURATION;
+		asteroidInfo_p->size = GetRandomValue(ASTEROID_SIZE_MIN, ASTEROID_SIZE_MAX);
+		entities.colliderRadius_p[asteroid] = 0.7f * (asteroidInfo_p->size / 2);
+		asteroidInfo_p->uv = NewRect(GetRandomUvPos(V2(0.25f, 0.25f)), V2(0.25f, 0.25f));
+		entities.pos_p[asteroid] = FindRandomPositionForAsteroid(entities.colliderRadius_p[asteroid]);
+		entities.rotSpeed_p[asteroid] = GetRandomSign() * GetRandomValue(ASTEROID_ROT_SPEED_MIN, ASTEROID_ROT_SPEED_MAX);
+		entities.vel_p[asteroid] = GetRandomValue(ASTEROID_SPEED_MIN, ASTEROID_SPEED_MAX) * RotateDeg(VECTOR2_UP, GetRandomValue(0, 360));
 	}
+	return spawned;
+}
+
+static Level AdvanceLevel(Level prevLevel)
+{
+	Level level = { 0 };
+	level.level = prevLevel.level + 1;
+	level.asteroidsCount = SpawnLevelAsteroids(prevLevel.asteroidsCount * 2);
 
 	levelCountdown = 60.0f;
 
 	return level;
 }
 
-static void GameStart()
+// New slot with the settings shared by every entity of a kind, not live until spawned.
+static EntityId CreateEntity(EntityListE list, EntityTypeE type, float size, TextureHandleT textureHandle)
+{
+	EntityId id = EntityCreate(&entities, list);
+	entities.facingV_p[id] = VECTOR2_UP;
+	entities.colliderRadius_p[id] = size / 2;
+	entityInfos[id].type = type;
+	entityInfos[id].size = size;
+	entityInfos[id].textureHandle = textureHandle;
+	entityInfos[id].uv = RECT_ONE;
+	return id;
+}
+
+// Later levels start with the asteroid count they'd reach by clearing the ones before, as far as the pool allows.
+static void GameStart(int startLevel = 1)
 {
 	memset(&camera, 0, sizeof(camera));
 	camera.rect = NewRectCenterPos(VECTOR2_ZERO, 4.0f*ScreenDim);
@@ -288,138 +360,78 @@ static void GameStart()
 	memset(&solid, 0, sizeof(solid));
 	BuildSolid(&solid);
 
-	level.level = 1;
-	level.asteroidsCount = 5;
-	asteroidsRemaining = level.asteroidsCount;
-
-	memset(&ship, 0, sizeof(ship));
-	ship.type = ENTITY_PLAYERSPACESHIP;
-	ship.size = 85.0f;
-	ship.colliderRadius = 0.8f * (ship.size / 2);
-	ship.facingV = VECTOR2_UP;
-	ship.enabled = true;
-	ship.tEnabled = time;
-	ship.tInvisibility = time + INVISIBILITY_DURATION;
-	ship.textureHandle = TEXTURE_SPACECRAFT;
-	ship.uv = RECT_ONE;
-	ship.health = 100.0f;
-
-	memset(&bullets, 0, sizeof(bullets));
+	EntityStoreReset(&entities);
+	PoolClear(&asteroidPool);
+	PoolClear(&bulletPool);
+	PoolClear(&enemyBulletPool);
+	PoolClear(&chargedBulletPool);
+	PoolClear(&explosionSmallPool);
+	explosionSmallNextEnd = DBL_MAX;
+	memset(entityInfos, 0, sizeof(entityInfos));
+
+	ship = CreateEntity(LIST_SHIP, ENTITY_PLAYERSPACESHIP, 85.0f, TEXTURE_SPACECRAFT);
+	entities.colliderRadius_p[ship] = 0.8f * (entityInfos[ship].size / 2);
+	entities.tEnabled_p[ship] = time;
+	entityInfos[ship].tInvisibility = time + INVISIBILITY_DURATION;
+	entityInfos[ship].health = 100.0f;
+	EntitySpawn(&entities, ship);
+
+	// Every pooled entity gets its store slot up front, the pools only hand them out.
 	for (int i = 0; i < MAX_BULLETS; i++)
 	{
-		bullets[i].type = ENTITY_BULLET;
-		bullets[i].size = 50.0f;
-		bullets[i].colliderRadius = bullets[i].size / 2;
-		bullets[i].facingV = VECTOR2_UP;
-		bullets[i].textureHandle = TEXTURE_REDSHOT;
+		bulletPool.items_p[i] = CreateEntity(LIST_BULLETS, ENTITY_BULLET, 50.0f, TEXTURE_REDSHOT);
 	}
 
-	memset(&enemyBullets, 0, sizeof(enemyBullets));
 	for (int i = 0; i < MAX_BULLETS; i++)
 	{
-		enemyBullets[i].type = ENTITY_ENEMYBULLET;
-		enemyBullets[i].size = 50.0f;
-		enemyBullets[i].colliderRadius = enemyBullets[i].size / 2;
-		enemyBullets[i].facingV = VECTOR2_UP;
-		enemyBullets[i].textureHandle = TEXTURE_REDSHOT;
+		enemyBulletPool.items_p[i] = CreateEntity(LIST_ENEMYBULLETS, ENTITY_ENEMYBULLET, 50.0f, TEXTURE_REDSHOT);
 	}
 
-	memset(&asteroids, 0, sizeof(asteroids));
 	for (int i = 0; i < MAX_ASTEROIDS; i++)
 	{
-		asteroids[i].type = ENTITY_ASTEROID;
-		asteroids[i].size = 100.0f;
-		asteroids[i].colliderRadius = 0.7f * (asteroids[i].size / 2);
-		asteroids[i].facingV = VECTOR2_UP;
-		asteroids[i].enabled = false;
-		asteroids[i].textureHandle = TEXTURE_ASTEROID;
-		asteroids[i].pos = VECTOR2_ZERO;
-		asteroids[i].uv = RECT_ONE;
-		asteroids[i].rotSpeed = 0;
-	}
-	for (int i = 0; i < level.asteroidsCount; i++)
-	{
-		asteroids[i].enabled = true;
-		asteroids[i].tEnabled = time;
-		asteroids[i].tInvisibility = time + INVISIBILITY_DURATION;
-		asteroids[i].size = GetRandomValue(ASTEROID_SIZE_MIN, ASTEROID_SIZE_MAX);
-		asteroids[i].colliderRadius = 0.7 * (asteroids[i].size / 2);
-		asteroids[i].uv = NewRect(GetRandomUvPos(V2(0.25f, 0.25f)), V2(0.25f, 0.25f));
-		asteroids[i].rotSpeed = GetRandomSign() * GetRandomValue(ASTEROID_ROT_SPEED_MIN, ASTEROID_ROT_SPEED_MAX);
-		asteroids[i].pos = FindRandomPositionForAsteroid(asteroids[i].colliderRadius);
-		asteroids[i].vel = GetRandomValue(ASTEROID_SPEED_MIN, ASTEROID_SPEED_MAX) * RotateDeg(VECTOR2_UP, GetRandomValue(0, 360));
+		asteroidPool.items_p[i] = CreateEntity(LIST_ASTEROIDS, ENTITY_ASTEROID, 100.0f, TEXTURE_ASTEROID);
 	}
 
-	memset(turrets, 0, sizeof(turrets));
+	int asteroidsCount = 5;
+	for (int l = 1; l < startLevel && asteroidsCount < MAX_ASTEROIDS; l++) asteroidsCount *= 2;
+	level.level = startLevel > 1 ? startLevel : 1;
+	level.asteroidsCount = SpawnLevelAsteroids(asteroidsCount);
+	asteroidsRemaining = level.asteroidsCount;
+
 	for (int i = 0; i < MAX_TURRETS; i++)
 	{
-		turrets[i].type = ENTITY_TURRET;
-		turrets[i].size = 150.0f;
-		turrets[i].colliderRadius = turrets[i].size / 2;
-		turrets[i].facingV = VECTOR2_UP;
-		turrets[i].uv = RECT_ONE;
-		turrets[i].pos = VECTOR2_ZERO;
-		turrets[i].health = 100.0f;
-		turrets[i].textureHandle = TEXTURE_TURRET;
-		turrets[i].rotSpeed = 180.0f;
-		turrets[i].e.tNextMove = F32_MAX;
-		turrets[i].e.nextAngle = 45;
-		turrets[i].e.prevAngle = 0;
+		EntityId turret = CreateEntity(LIST_TURRETS, ENTITY_TURRET, 150.0f, TEXTURE_TURRET);
+		EntityInfo* turretInfo_p = &entityInfos[turret];
+		entities.tEnabled_p[turret] = time;
+		entities.rotSpeed_p[turret] = 180.0f;
+		turretInfo_p->tInvisibility = time + INVISIBILITY_DURATION;
+		turretInfo_p->health = 100.0f;
+		turretInfo_p->e.tNextMove = F32_MAX;
+		turretInfo_p->e.nextAngle = 45;
+		turretInfo_p->e.prevAngle = 0;
+		EntitySpawn(&entities, turret);
+		turrets[i] = turret;
 	}
-	turrets[0].enabled = true;
-	turrets[0].tEnabled = time;
-	turrets[0].tInvisibility = time + INVISIBILITY_DURATION;
-	turrets[0].pos = V2(800.0f, -500.0f);
-	turrets[1].enabled = true;
-	turrets[1].tEnabled = time;
-	turrets[1].tInvisibility = time + INVISIBILITY_DURATION;
-	turrets[1].pos = V2(-600.0f, 800.0f);
-
+	entities.pos_p[turrets[0]] = V2(800.0f, -500.0f);
+	entities.pos_p[turrets[1]] = V2(-600.0f, 800.0f);
 
-	memset(chargedBullets, 0, sizeof(chargedBullets));
 	for (int i = 0; i < MAX_CHARGEDBULLETS; i++)
 	{
-		chargedBullets[i].type = ENTITY_CHARGEDBULLET;
-		chargedBullets[i].size = 60.0f;
-		chargedBullets[i].colliderRadius = chargedBullets[i].size / 2;
-		chargedBullets[i].facingV = VECTOR2_UP;
-		chargedBullets[i].textureHandle = TEXTURE_CHARGEDBULLET;
+		chargedBulletPool.items_p[i] = CreateEntity(LIST_CHARGEDBULLETS, ENTITY_CHARGEDBULLET, 60.0f, TEXTURE_CHARGEDBULLET);
 	}
-	chargedBulletHolding_p = nullptr;
+	chargedBulletHolding = POOL_HANDLE_NONE;
 
-	psDebris.index = 0;
-	assert(psDebris.particles_p != nullptr);
-	for (int i = 0; i < MAX_PARTICLES_DEBRIS; i++)
-	{
-		psDebris.particles_p[i].enabled = false;
-		psDebris.particles_p[i].color = COLOR_WHITE;
-	}
-
-	psExhaust.index = 0;
-	assert(psExhaust.particles_p != nullptr);
-	for (int i = 0; i < MAX_PARTICLES_EXHAUST; i++)
-	{
-		psExhaust.particles_p[i].enabled = false;
-		psExhaust.particles_p[i].color = COLOR_EXHAUST;
-	}
+	ParticlesClear(&particles);
 
 	memset(&explosionShip, 0, sizeof(explosionShip));
 	explosionShip.enabled = false;
 	explosionShip.textureHandle = TEXTURE_EXPLOSIONBIG;
-	explosionShip.animation = AnimationBuild(5, 2, 10, 24.0f, false);
+	explosionShip.animation = AnimationPlay(explosionShipClip, time);
 
 	memset(&explosionCharged, 0, sizeof(explosionCharged));
 	explosionCharged.enabled = false;
 	explosionCharged.textureHandle = TEXTURE_EXPLOSION5;
-	explosionCharged.animation = AnimationBuild(2, 2, 4, 24.0f, false);
-
-	memset(&explosionsSmall, 0, sizeof(explosionsSmall));
-	for (int i = 0; i < MAX_EXPLOSIONS_SMALL; i++)
-	{
-		explosionsSmall[i].enabled = false;
-		explosionsSmall[i].textureHandle = TEXTURE_EXPLOSIONSMALL;
-		explosionsSmall[i].animation = AnimationBuild(3, 3, 8, 24.0f, false);
-	}
+	explosionCharged.animation = AnimationPlay(explosionChargedClip, time);
 
 	memset(&entityCollisions, 0, sizeof(entityCollisions));
 
@@ -428,359 +440,375 @@ static void GameStart()
 	levelCountdown = 60.0f;
 
 	paused = false;
+	simAccumulator = 0;
+	fireRequested = false;
 }
 
-static void AddToCollisions(CollisionEntities* collisions_p, Entity* entity_p)
+static void AddToCollisions(CollisionEntities* collisions_p, EntityId entity)
 {
-	collisions_p->entities_p[collisions_p->count++] = entity_p;
+	collisions_p->ids[collisions_p->count++] = entity;
 }
 
+// Returns how many children fit in the asteroid pool.
 static int SpawnChildrenAsteroids(Vector2 pos)
 {
-	Entity* childrenAsteroids[4] = { 0 };
-	int found = 0;
-	int j = MAX_ASTEROIDS - 1;
-	while (found < 4 && j >= 0)
-	{
-		if (!asteroids[j].enabled)
-		{
-			childrenAsteroids[found++] = &asteroids[j];
-		}
-		j--;
-	}
-	assert(found == 4);
+	int spawned = 0;
 	for (int i = 0; i < 4; i++)
 	{
-		Entity* child_p = childrenAsteroids[i];
-		child_p->size = GetRandomValue(ASTEROID_SIZE_MIN, ASTEROID_SIZE_MIN + 10);
-		child_p->colliderRadius = 0.7f * (child_p->size / 2);
-		child_p->uv = NewRect(GetRandomUvPos(V2(0.25f, 0.25f)), V2(0.25f, 0.25f));
-		child_p->pos = pos + (ASTEROID_SIZE_MIN/2) * RotateDeg(VECTOR2_ONE, 90*i);
-		child_p->rotSpeed = GetRandomSign() * GetRandomValue(ASTEROID_ROT_SPEED_MIN, ASTEROID_ROT_SPEED_MAX);
-		child_p->vel = 4 * GetRandomValue(ASTEROID_SPEED_MIN, ASTEROID_SPEED_MAX) * RotateDeg(VECTOR2_UP, GetRandomValue(0, 360));
-		child_p->enabled = true;
-		child_p->tEnabled = time;
+		EntityId child = SpawnEntity(&asteroidPool);
+		if (child == ENTITY_INVALID) break;
+
+		EntityInfo* childInfo_p = &entityInfos[child];
+		childInfo_p->size = GetRandomValue(ASTEROID_SIZE_MIN, ASTEROID_SIZE_MIN + 10);
+		childInfo_p->uv = NewRect(GetRandomUvPos(V2(0.25f, 0.25f)), V2(0.25f, 0.25f));
+		entities.colliderRadius_p[child] = 0.7f * (childInfo_p->size / 2);
+		entities.pos_p[child] = pos + (ASTEROID_SIZE_MIN/2) * RotateDeg(VECTOR2_ONE, 90*i);
+		entities.rotSpeed_p[child] = GetRandomSign() * GetRandomValue(ASTEROID_ROT_SPEED_MIN, ASTEROID_ROT_SPEED_MAX);
+		entities.vel_p[child] = 4 * GetRandomValue(ASTEROID_SPEED_MIN, ASTEROID_SPEED_MAX) * RotateDeg(VECTOR2_UP, GetRandomValue(0, 360));
+		entities.tEnabled_p[child] = time;
+		spawned++;
 	}
-	return found;
+	return spawned;
 }
 
-static void SpawnDebrisParticles(Vector2 pos, int count)
+// Frees the small explosions that played out. Ticks where none ended yet don't walk the pool.
+static void FreeEndedExplosions()
 {
-	Particle* particles = psDebris.particles_p;
-	for (int i = 0; i < count; i++)
+	if (time < explosionSmallNextEnd) return;
+
+	explosionSmallNextEnd = DBL_MAX;
+	for (U32 i = 0; i < explosionSmallPool.used; i++)
 	{
-		Particle* particle_p = &particles[psDebris.index++ % MAX_PARTICLES_DEBRIS];
-		particle_p->enabled = true;
-		particle_p->pos = pos + 20.0f * RotateDeg(VECTOR2_UP, GetRandomValue(0, 360));
-		particle_p->tEnabled = time;
-		particle_p->vel = 30.0f * RotateDeg(VECTOR2_UP, GetRandomValue(0, 360));
+		PoolHandle handle = PoolHandleAt(&explosionSmallPool, i);
+		if (handle == POOL_HANDLE_NONE) continue;
+		const Animation* animation_p = &explosionSmallPool.items_p[i].animation;
+		if (AnimationEnded(animation_p, time)) PoolFree(&explosionSmallPool, handle);
+		else explosionSmallNextEnd = fmin(explosionSmallNextEnd, AnimationEndTime(animation_p));
 	}
 }
 
-static void SpawnExhaustParticles(Vector2 pos, Vector2 facingV, Color colorParticle)
+static void SpawnExplosionSmall(Vector2 pos)
 {
-	Particle* particles = psExhaust.particles_p;
-	for (int i = 0; i < 1; i++)
-	{
-		Particle* particle_p = &particles[psExhaust.index++ % MAX_PARTICLES_EXHAUST];
-		particle_p->enabled = true;
-		particle_p->pos = pos;
-		particle_p->tEnabled = time;
-		particle_p->vel = RotateDeg(80.0f * facingV, GetRandomValue(-135, 135));
-		particle_p->color = colorParticle;
-	}
+	PoolHandle handle = PoolAlloc(&explosionSmallPool);
+	if (handle == POOL_HANDLE_NONE) return;
+
+	AnimationObject* explosionSmall_p = PoolGet(&explosionSmallPool, handle);
+	explosionSmall_p->enabled = true;
+	explosionSmall_p->pos = pos;
+	explosionSmall_p->textureHandle = TEXTURE_EXPLOSIONSMALL;
+	explosionSmall_p->animation = AnimationPlay(explosionSmallClip, time);
+	explosionSmallNextEnd = fmin(explosionSmallNextEnd, AnimationEndTime(&explosionSmall_p->animation));
+}
+
+static void SpawnDebrisParticles(Vector2 pos, int count)
+{
+	ParticlesBurst(&particles, emitterDebris, pos, VECTOR2_UP, count);
 }
 
-static void EllasticCollision(Entity* entityA_p, Entity* entityB_p)
+static void EllasticCollision(EntityId entityA, EntityId entityB)
 {
 	// See https://en.wikipedia.org/wiki/Elastic_collision
-	Vector2 v1 = entityA_p->vel;
-	Vector2 v2 = entityB_p->vel;
-	float m1 = entityA_p->size;
-	float m2 = entityB_p->size;
-	Vector2 x1 = entityA_p->pos;
-	Vector2 x2 = entityB_p->pos;
-	entityA_p->vel = v1 - (2 * m2 / (m1 + m2)) * (Dot(v1 - v2, x1 - x2) / MagnitudeSq(x1 - x2)) * (x1 - x2);
-	entityB_p->vel = v2 - (2 * m1 / (m1 + m2)) * (Dot(v2 - v1, x2 - x1) / MagnitudeSq(x2 - x1)) * (x2 - x1);
+	Vector2 v1 = entities.vel_p[entityA];
+	Vector2 v2 = entities.vel_p[entityB];
+	float m1 = entityInfos[entityA].size;
+	float m2 = entityInfos[entityB].size;
+	Vector2 x1 = entities.pos_p[entityA];
+	Vector2 x2 = entities.pos_p[entityB];
+	entities.vel_p[entityA] = v1 - (2 * m2 / (m1 + m2)) * (Dot(v1 - v2, x1 - x2) / MagnitudeSq(x1 - x2)) * (x1 - x2);
+	entities.vel_p[entityB] = v2 - (2 * m1 / (m1 + m2)) * (Dot(v2 - v1, x2 - x1) / MagnitudeSq(x2 - x1)) * (x2 - x1);
 }
 
-static void EntityEntityCollisions(CollisionEntities* collisions_p)
+// Types each entity type interacts with, pairs not in here (e.g. bullet vs bullet) never reach the narrow phase.
+static U32 CollisionMask(EntityTypeE type)
 {
-	for (int i = 0; i < collisions_p->count; i++)
+	switch (type)
+	{
+	case ENTITY_PLAYERSPACESHIP: return ENTITY_ASTEROID | ENTITY_ENEMYBULLET | ENTITY_TURRET;
+	case ENTITY_BULLET:          return ENTITY_ASTEROID | ENTITY_TURRET;
+	case ENTITY_ASTEROID:        return ENTITY_ASTEROID | ENTITY_BULLET | ENTITY_CHARGEDBULLET | ENTITY_PLAYERSPACESHIP;
+	case ENTITY_ENEMYBULLET:     return ENTITY_PLAYERSPACESHIP;
+	case ENTITY_CHARGEDBULLET:   return ENTITY_ASTEROID | ENTITY_TURRET;
+	case ENTITY_TURRET:          return ENTITY_BULLET | ENTITY_CHARGEDBULLET | ENTITY_PLAYERSPACESHIP;
+	default:                     return 0;
+	}
+}
+
+static void EntityEntityCollision(EntityId entityA, EntityId entityB)
+{
+	float distCollision = entities.colliderRadius_p[entityA] + entities.colliderRadius_p[entityB];
+	float distCollisionSq = distCollision * distCollision;
+	float distSq = MagnitudeSq(entities.pos_p[entityA] - entities.pos_p[entityB]);
+	if (distSq > distCollisionSq) return;
+
+	EntityTypeE typeA = entityInfos[entityA].type;
+	U32 collision = (U32)typeA | (U32)entityInfos[entityB].type;
+	switch (collision)
 	{
-		Entity* entityA_p = collisions_p->entities_p[i];
-		for (int j = i+1; j < collisions_p->count; j++)
+	case ENTITY_BULLET | ENTITY_ASTEROID:
+	{
+		EntityId bullet = entityA;
+		EntityId asteroid = entityB;
+		if (typeA == ENTITY_ASTEROID)
 		{
-			Entity* entityB_p = collisions_p->entities_p[j];
-			float distCollision = entityA_p->colliderRadius + entityB_p->colliderRadius;
-			float distCollisionSq = distCollision * distCollision;
-			float distSq = MagnitudeSq(entityA_p->pos - entityB_p->pos);
-			if (distSq <= distCollisionSq)
-			{
-				U32 collision = (U32)entityA_p->type | (U32)entityB_p->type;
-				switch (collision)
-				{
-				case ENTITY_BULLET | ENTITY_ASTEROID:
-				{
-					Entity* bullet_p = entityA_p;
-					Entity* asteroid_p = entityB_p;
-					if (entityA_p->type == ENTITY_ASTEROID)
-					{
-						bullet_p = entityB_p;
-						asteroid_p = entityA_p;
-					}
+			bullet = entityB;
+			asteroid = entityA;
+		}
+		Vector2 bulletPos = entities.pos_p[bullet];
+		Vector2 asteroidPos = entities.pos_p[asteroid];
+		float asteroidSize = entityInfos[asteroid].size;
 
-					if (asteroid_p->size >= ASTEROID_BIG)
-					{
-						asteroidsRemaining += SpawnChildrenAsteroids(asteroid_p->pos);
+		if (asteroidSize >= ASTEROID_BIG)
+		{
+			asteroidsRemaining += SpawnChildrenAsteroids(asteroidPos);
 
-					}
+		}
 
-					AnimationObject* explosionSmall_p = &explosionsSmall[(explosionsSmallIdx++) % MAX_EXPLOSIONS_SMALL];
-					explosionSmall_p->enabled = true;
-					explosionSmall_p->pos = bullet_p->pos + bullet_p->colliderRadius * Normalize(asteroid_p->pos - bullet_p->pos);
-					explosionSmall_p->animation.tStart = time;
+		SpawnExplosionSmall(bulletPos + entities.colliderRadius_p[bullet] * Normalize(asteroidPos - bulletPos));
 
-					float sizePerc = (asteroid_p->size - ASTEROID_SIZE_MIN) / (ASTEROID_SIZE_MAX - ASTEROID_SIZE_MIN);
-					int particleCount = (int)(20 * sizePerc + 10);
-					SpawnDebrisParticles(asteroid_p->pos, particleCount);
+		float sizePerc = (asteroidSize - ASTEROID_SIZE_MIN) / (ASTEROID_SIZE_MAX - ASTEROID_SIZE_MIN);
+		int particleCount = (int)(20 * sizePerc + 10);
+		SpawnDebrisParticles(asteroidPos, particleCount);
 
-					bullet_p->enabled = false;
-					asteroid_p->enabled = false;
-					asteroidsRemaining--;
-					score++;
-				}
-				break;
-				case ENTITY_CHARGEDBULLET | ENTITY_ASTEROID:
-				{
-					Entity* chargedBullet_p = entityA_p;
-					Entity* asteroid_p = entityB_p;
-					if (entityA_p->type == ENTITY_ASTEROID)
-					{
-						chargedBullet_p = entityB_p;
-						asteroid_p = entityA_p;
-					}
+		DestroyEntity(bullet);
+		DestroyEntity(asteroid);
+		asteroidsRemaining--;
+		score++;
+	}
+	break;
+	case ENTITY_CHARGEDBULLET | ENTITY_ASTEROID:
+	{
+		EntityId asteroid = (typeA == ENTITY_ASTEROID) ? entityA : entityB;
+		Vector2 asteroidPos = entities.pos_p[asteroid];
+		float asteroidSize = entityInfos[asteroid].size;
 
-					if (asteroid_p->size >= ASTEROID_BIG)
-					{
-						asteroidsRemaining += SpawnChildrenAsteroids(asteroid_p->pos);
-					}
+		if (asteroidSize >= ASTEROID_BIG)
+		{
+			asteroidsRemaining += SpawnChildrenAsteroids(asteroidPos);
+		}
 
-					float sizePerc = (asteroid_p->size - ASTEROID_SIZE_MIN) / (ASTEROID_SIZE_MAX - ASTEROID_SIZE_MIN);
-					int particleCount = (int)(20 * sizePerc + 10);
-					SpawnDebrisParticles(asteroid_p->pos, particleCount);
+		float sizePerc = (asteroidSize - ASTEROID_SIZE_MIN) / (ASTEROID_SIZE_MAX - ASTEROID_SIZE_MIN);
+		int particleCount = (int)(20 * sizePerc + 10);
+		SpawnDebrisParticles(asteroidPos, particleCount);
 
-					asteroid_p->enabled = false;
-					asteroidsRemaining--;
-					score++;
-				}
-				break;
-				case ENTITY_PLAYERSPACESHIP | ENTITY_ASTEROID:
-				{
-					Entity* asteroid_p = entityA_p;
-					Entity* ship_p = entityB_p;					
-					if (entityA_p->type == ENTITY_PLAYERSPACESHIP)
-					{
-						asteroid_p = entityB_p;
-						ship_p = entityA_p;
-					}
+		DestroyEntity(asteroid);
+		asteroidsRemaining--;
+		score++;
+	}
+	break;
+	case ENTITY_PLAYERSPACESHIP | ENTITY_ASTEROID:
+	{
+		EntityId asteroid = entityA;
+		EntityId spaceship = entityB;
+		if (typeA == ENTITY_PLAYERSPACESHIP)
+		{
+			asteroid = entityB;
+			spaceship = entityA;
+		}
+		EntityInfo* shipInfo_p = &entityInfos[spaceship];
 
-					ship_p->tTakingDamage = time + TAKINGDAMAGE_DURATION;
-					ship_p->health -= 20.0f;
-					ship_p->health = Clampf(ship_p->health, 0, 100.0f);
+		shipInfo_p->tTakingDamage = time + TAKINGDAMAGE_DURATION;
+		shipInfo_p->health -= 20.0f;
+		shipInfo_p->health = Clampf(shipInfo_p->health, 0, 100.0f);
 
-					EllasticCollision(ship_p, asteroid_p);
+		EllasticCollision(spaceship, asteroid);
 
-					if (Magnitude(ship_p->vel) >= SPEED_DESTROY)
-					{
-						ship_p->health = 0;
-						ship_p->vel = VECTOR2_ZERO; // Zero so that the camera doesn't continue following.
-					}
-				}
-				break;
-				case ENTITY_PLAYERSPACESHIP | ENTITY_ENEMYBULLET:
-				{
-					Entity* bullet_p = entityA_p;
-					Entity* ship_p = entityB_p;
-					if (entityA_p->type == ENTITY_PLAYERSPACESHIP)
-					{
-						bullet_p = entityB_p;
-						ship_p = entityA_p;
-					}
+		if (Magnitude(entities.vel_p[spaceship]) >= SPEED_DESTROY)
+		{
+			shipInfo_p->health = 0;
+			entities.vel_p[spaceship] = VECTOR2_ZERO; // Zero so that the camera doesn't continue following.
+		}
+	}
+	break;
+	case ENTITY_PLAYERSPACESHIP | ENTITY_ENEMYBULLET:
+	{
+		EntityId bullet = entityA;
+		EntityId spaceship = entityB;
+		if (typeA == ENTITY_PLAYERSPACESHIP)
+		{
+			bullet = entityB;
+			spaceship = entityA;
+		}
+		EntityInfo* shipInfo_p = &entityInfos[spaceship];
+		Vector2 bulletPos = entities.pos_p[bullet];
 
-					SpawnDebrisParticles(bullet_p->pos, 5);
+		SpawnDebrisParticles(bulletPos, 5);
 
-					bullet_p->enabled = false;
-					AnimationObject* explosionSmall_p = &explosionsSmall[(explosionsSmallIdx++) % MAX_EXPLOSIONS_SMALL];
-					explosionSmall_p->enabled = true;
-					explosionSmall_p->pos = bullet_p->pos + bullet_p->colliderRadius * Normalize(ship_p->pos - bullet_p->pos);
-					explosionSmall_p->animation.tStart = time;
+		DestroyEntity(bullet);
+		SpawnExplosionSmall(bulletPos + entities.colliderRadius_p[bullet] * Normalize(entities.pos_p[spaceship] - bulletPos));
 
-					ship_p->tTakingDamage = time + TAKINGDAMAGE_DURATION;
-					ship_p->health -= 20.0f;
-					ship_p->health = Clampf(ship_p->health, 0, 100.0f);
-				}
-				break;
-				case ENTITY_ASTEROID | ENTITY_ASTEROID:
-				{
-					Entity* asteroidA_p = entityA_p;
-					Entity* asteroidB_p = entityB_p;
+		shipInfo_p->tTakingDamage = time + TAKINGDAMAGE_DURATION;
+		shipInfo_p->health -= 20.0f;
+		shipInfo_p->health = Clampf(shipInfo_p->health, 0, 100.0f);
+	}
+	break;
+	case ENTITY_ASTEROID | ENTITY_ASTEROID:
+	{
+		EntityId asteroidA = entityA;
+		EntityId asteroidB = entityB;
+		Vector2 asteroidAPos = entities.pos_p[asteroidA];
 
-					Vector2 collisionP = asteroidA_p->pos + (asteroidA_p->size / 2) * Normalize(asteroidB_p->pos - asteroidA_p->pos);
-					SpawnDebrisParticles(collisionP, 5);
-					EllasticCollision(asteroidA_p, asteroidB_p);
-				}
-				break;
-				case ENTITY_TURRET | ENTITY_BULLET:
-				{
-					Entity* bullet_p = entityA_p;
-					Entity* turret_p = entityB_p;
-					if (entityA_p->type == ENTITY_TURRET)
-					{
-						bullet_p = entityB_p;
-						turret_p = entityA_p;
-					}
+		Vector2 collisionP = asteroidAPos + (entityInfos[asteroidA].size / 2) * Normalize(entities.pos_p[asteroidB] - asteroidAPos);
+		SpawnDebrisParticles(collisionP, 5);
+		EllasticCollision(asteroidA, asteroidB);
+	}
+	break;
+	case ENTITY_TURRET | ENTITY_BULLET:
+	{
+		EntityId bullet = entityA;
+		EntityId turret = entityB;
+		if (typeA == ENTITY_TURRET)
+		{
+			bullet = entityB;
+			turret = entityA;
+		}
+		EntityInfo* turretInfo_p = &entityInfos[turret];
+		Vector2 bulletPos = entities.pos_p[bullet];
 
-					turret_p->health -= 25.0f;
-					turret_p->health = Clampf(turret_p->health, 0, 100.0f);
+		turretInfo_p->health -= 25.0f;
+		turretInfo_p->health = Clampf(turretInfo_p->health, 0, 100.0f);
 
-					if (turret_p->health == 0)
-					{
-						explosionShip.enabled = true;
-						explosionShip.pos = turret_p->pos;
-						explosionShip.animation.tStart = time;
+		if (turretInfo_p->health == 0)
+		{
+			explosionShip.enabled = true;
+			explosionShip.pos = entities.pos_p[turret];
+			explosionShip.animation = AnimationPlay(explosionShipClip, time);
 
-						turret_p->enabled = false;
-					}
+			DestroyEntity(turret);
+		}
 
-					bullet_p->enabled = false;
-					AnimationObject* explosionSmall_p = &explosionsSmall[(explosionsSmallIdx++) % MAX_EXPLOSIONS_SMALL];
-					explosionSmall_p->enabled = true;
-					explosionSmall_p->pos = bullet_p->pos + bullet_p->colliderRadius * Normalize(turret_p->pos - bullet_p->pos);
-					explosionSmall_p->animation.tStart = time;
+		DestroyEntity(bullet);
+		SpawnExplosionSmall(bulletPos + entities.colliderRadius_p[bullet] * Normalize(entities.pos_p[turret] - bulletPos));
 
-					score++;
+		score++;
 
-				}
-				break;
-				case ENTITY_TURRET | ENTITY_CHARGEDBULLET:
-				{
-					Entity* chargedBullet_p = entityA_p;
-					Entity* turret_p = entityB_p;
-					if (entityA_p->type == ENTITY_TURRET)
-					{
-						chargedBullet_p = entityB_p;
-						turret_p = entityA_p;
-					}
+	}
+	break;
+	case ENTITY_TURRET | ENTITY_CHARGEDBULLET:
+	{
+		EntityId chargedBullet = entityA;
+		EntityId turret = entityB;
+		if (typeA == ENTITY_TURRET)
+		{
+			chargedBullet = entityB;
+			turret = entityA;
+		}
 
-					turret_p->health = 0;
-					turret_p->enabled = false;
-					explosionShip.enabled = true;
-					explosionShip.pos = turret_p->pos;
-					explosionShip.animation.tStart = time;
+		entityInfos[turret].health = 0;
+		DestroyEntity(turret);
+		explosionShip.enabled = true;
+		explosionShip.pos = entities.pos_p[turret];
+		explosionShip.animation = AnimationPlay(explosionShipClip, time);
 
-					chargedBullet_p->enabled = false;
-					explosionCharged.enabled = true;
-					explosionCharged.pos = chargedBullet_p->pos;
-					explosionCharged.animation.tStart = time;
+		DestroyEntity(chargedBullet);
+		explosionCharged.enabled = true;
+		explosionCharged.pos = entities.pos_p[chargedBullet];
+		explosionCharged.animation = AnimationPlay(explosionChargedClip, time);
 
-					score++;
-				}
-				break;
-				case ENTITY_TURRET | ENTITY_PLAYERSPACESHIP:
-				{
-					Entity* turret_p = entityA_p;
-					Entity* ship_p = entityB_p;
-					if (entityA_p->type == ENTITY_PLAYERSPACESHIP)
-					{
-						turret_p = entityB_p;
-						ship_p = entityA_p;
-					}
+		score++;
+	}
+	break;
+	case ENTITY_TURRET | ENTITY_PLAYERSPACESHIP:
+	{
+		EntityId spaceship = (typeA == ENTITY_PLAYERSPACESHIP) ? entityA : entityB;
+		EntityInfo* shipInfo_p = &entityInfos[spaceship];
 
-					ship_p->tInvisibility = time + INVISIBILITY_DURATION;
-					ship_p->tTakingDamage = time + TAKINGDAMAGE_DURATION;
-					ship_p->health -= 75.0f;
-					ship_p->health = Clampf(ship_p->health, 0, 100.0f);
-				}
-				break;
-				default:
-					break;
-				}
-			}
-		}
+		shipInfo_p->tInvisibility = time + INVISIBILITY_DURATION;
+		shipInfo_p->tTakingDamage = time + TAKINGDAMAGE_DURATION;
+		shipInfo_p->health -= 75.0f;
+		shipInfo_p->health = Clampf(shipInfo_p->health, 0, 100.0f);
+	}
+	break;
+	default:
+		break;
+	}
+}
+
+static void EntityEntityCollisions(CollisionEntities* collisions_p)
+{
+	BroadphaseClear(&broadphase);
+	for (int i = 0; i < collisions_p->count; i++)
+	{
+		EntityId entity = collisions_p->ids[i];
+		EntityTypeE type = entityInfos[entity].type;
+		BroadphaseAdd(&broadphase, entities.pos_p[entity], entities.colliderRadius_p[entity], type, CollisionMask(type));
+	}
+	BroadphaseFindPairs(&broadphase);
+
+	// Pairs come sorted, same order as testing every pair so the outcome doesn't change.
+	for (U32 i = 0; i < broadphase.pairCount; i++)
+	{
+		BroadphasePair pair = broadphase.pairs_p[i];
+		EntityEntityCollision(collisions_p->ids[pair.a], collisions_p->ids[pair.b]);
 	}
 }
 
-static void AddForce(Entity* entity_p, Vector2 force, float deltaT)
+static void AddForce(EntityId entity, Vector2 force, float deltaT)
 {
 	const float mass = 1.0f;
-	entity_p->vel = (deltaT/mass) * force;
+	entities.vel_p[entity] = (deltaT/mass) * force;
 }
 
-static void EntitySolidCollisions(CollisionEntities* entities_p, float deltaT, Solid* solid_p)
+static void EntitySolidCollisions(CollisionEntities* collisions_p, float deltaT, Solid* solid_p)
 {
-	for (int i = 0; i < entities_p->count; i++)
+	for (int i = 0; i < collisions_p->count; i++)
 	{
-		Entity* entity_p = entities_p->entities_p[i];
+		EntityId entity = collisions_p->ids[i];
 
 		for (int s = 0; s < solid_p->solidLinesCount; s++)
 		{
 			LineSegment solidLine = solid_p->solidLines[s];
 			Vector2 p;
-			if (LineCircleIntersect(solidLine, entity_p->pos, entity_p->colliderRadius, p))
+			if (LineCircleIntersect(solidLine, entities.pos_p[entity], entities.colliderRadius_p[entity], p))
 			{
-				switch (entity_p->type)
+				switch (entityInfos[entity].type)
 				{
 				case ENTITY_BULLET:
 				{
-					Entity* bullet_p = entity_p;
-					Vector2 normal = GetNormal(solidLine, bullet_p->pos);
-					float angle = AngleDegRel(-bullet_p->vel, normal);
-					bullet_p->vel = RotateDeg(-bullet_p->vel, 2 * angle);
-					bullet_p->facingV = Normalize(bullet_p->vel);
+					EntityId bullet = entity;
+					Vector2 normal = GetNormal(solidLine, entities.pos_p[bullet]);
+					float angle = AngleDegRel(-entities.vel_p[bullet], normal);
+					entities.vel_p[bullet] = RotateDeg(-entities.vel_p[bullet], 2 * angle);
+					entities.facingV_p[bullet] = Normalize(entities.vel_p[bullet]);
 				}
 				break;
 				case ENTITY_CHARGEDBULLET:
 				{
-					Entity* chargedBullet_p = entity_p;
-					chargedBullet_p->enabled = false;
+					EntityId chargedBullet = entity;
+					DestroyEntity(chargedBullet);
 
 					explosionCharged.enabled = true;
 					explosionCharged.pos = p;
-					explosionCharged.animation.tStart = time;
+					explosionCharged.animation = AnimationPlay(explosionChargedClip, time);
 				}
 				break;
 				case ENTITY_ENEMYBULLET:
 				{
-					Entity* bullet_p = entity_p;
-					bullet_p->enabled = false;
+					EntityId bullet = entity;
+					DestroyEntity(bullet);
 
-					AnimationObject* explosionSmall_p = &explosionsSmall[(explosionsSmallIdx++) % MAX_EXPLOSIONS_SMALL];
-					explosionSmall_p->enabled = true;
-					explosionSmall_p->pos = p;
-					explosionSmall_p->animation.tStart = time;
+					SpawnExplosionSmall(p);
 				}
 				break;
 				case ENTITY_PLAYERSPACESHIP:
 				{
-					Entity* ship_p = entity_p;
-					Vector2 normal = GetNormal(solidLine, ship_p->pos);
-					float angle = AngleDegRel(-ship_p->vel, normal);
-					ship_p->vel = RotateDeg(-ship_p->vel, 2 * angle);
+					EntityId spaceship = entity;
+					Vector2 normal = GetNormal(solidLine, entities.pos_p[spaceship]);
+					float angle = AngleDegRel(-entities.vel_p[spaceship], normal);
+					entities.vel_p[spaceship] = RotateDeg(-entities.vel_p[spaceship], 2 * angle);
 
-					if (Magnitude(ship_p->vel) >= SPEED_DESTROY)
+					if (Magnitude(entities.vel_p[spaceship]) >= SPEED_DESTROY)
 					{
-						ship_p->health = 0;
-						ship_p->vel = VECTOR2_ZERO; // Zero so that the camera doesn't continue following.
+						entityInfos[spaceship].health = 0;
+						entities.vel_p[spaceship] = VECTOR2_ZERO; // Zero so that the camera doesn't continue following.
 					}
 				}
 				break;
 				case ENTITY_ASTEROID:
 				{
-					Entity* asteroid_p = entity_p;
-					Vector2 normal = GetNormal(solidLine, asteroid_p->pos);
-					float angle = AngleDegRel(-asteroid_p->vel, normal);
-					asteroid_p->vel = RotateDeg(-asteroid_p->vel, 2 * angle);
+					EntityId asteroid = entity;
+					Vector2 normal = GetNormal(solidLine, entities.pos_p[asteroid]);
+					float angle = AngleDegRel(-entities.vel_p[asteroid], normal);
+					entities.vel_p[asteroid] = RotateDeg(-entities.vel_p[asteroid], 2 * angle);
 					break;
 				}
 				default:
@@ -809,103 +837,143 @@ static bool Blink(double tStartBlink)
 	return show;
 }
 
-static void Game(float deltaT, Renderer* renderer_p)
+static Vector2 RenderPos(EntityId entity, float alpha)
 {
-	float shipAcceleration = 0.0f;
-	Vector2 shipAccelerationV = VECTOR2_ZERO;
+	Vector2 pos = entities.pos_p[entity];
+	if (!entities.interpolate_p[entity]) return pos;
+	Vector2 prevPos = entities.prevPos_p[entity];
+	return prevPos + alpha * (pos - prevPos);
+}
+
+static Vector2 RenderFacingV(EntityId entity, float alpha)
+{
+	Vector2 facingV = entities.facingV_p[entity];
+	if (!entities.interpolate_p[entity]) return facingV;
+	Vector2 prevFacingV = entities.prevFacingV_p[entity];
+	Vector2 result = Normalize(prevFacingV + alpha * (facingV - prevFacingV));
+	return (result == VECTOR2_ZERO) ? facingV : result;
+}
 
-	if (paused) goto GAMEUPDATE_END;
+static void DestroyExpired(EntityListE list, double lifetime)
+{
+	EntityId expired[MAX_ENTITIES];
+	int count = EntitiesFindExpired(&entities, &entities.lists_p[list], time, lifetime, expired);
+	for (int i = 0; i < count; i++) DestroyEntity(expired[i]);
+}
+
+// The shot is dropped when the pool is exhausted, the failure shows up in the pool stats.
+static EntityId SpawnProjectile(Pool<EntityId>* pool_p, Vector2 pos, Vector2 facingV, Vector2 vel)
+{
+	EntityId projectile = SpawnEntity(pool_p);
+	if (projectile == ENTITY_INVALID) return ENTITY_INVALID;
+
+	entities.interpolate_p[projectile] = false;
+	entities.pos_p[projectile] = pos;
+	entities.facingV_p[projectile] = facingV;
+	entities.vel_p[projectile] = vel;
+	entities.tEnabled_p[projectile] = time;
+	return projectile;
+}
+
+// One fixed simulation step, doesn't touch the renderer.
+static void GameUpdate(float deltaT)
+{
+	EntitiesSavePrevState(&entities);
+
+	shipAcceleration = 0.0f;
+	Vector2 shipAccelerationV = VECTOR2_ZERO;
 
 	time += deltaT;
 	levelCountdown = fmax(0, levelCountdown - deltaT);
 
 	Mouse mouse = GameInput_GetMouse();
 	mouse.pos = MouseToWorldPos(mouse.pos);
+
+	EntityInfo* shipInfo_p = &entityInfos[ship];
+	bool shipEnabled = EntityIsLive(&entities, ship);
+	Vector2 shipPos = entities.pos_p[ship];
+	Vector2 shipFacingV = Normalize(mouse.pos - shipPos);
+	entities.facingV_p[ship] = shipFacingV;
 	
-	ship.facingV = Normalize(mouse.pos - ship.pos);
-	
-	if (ship.enabled)
+	if (shipEnabled)
 	{
 		if (GameInput_Button(BUTTON_W))
 		{
 			shipAcceleration = SHIP_ACCELERATION;
 			if (GameInput_Button(BUTTON_LSHIFT)) shipAcceleration = SHIP_BOOST;
-			shipAccelerationV = ship.facingV;
+			shipAccelerationV = shipFacingV;
 		}
-		if (GameInput_Button(BUTTON_S) && Magnitude(ship.vel) > 0.1f)
+		if (GameInput_Button(BUTTON_S) && Magnitude(entities.vel_p[ship]) > 0.1f)
 		{
 			shipAcceleration = -2 * SHIP_BOOST;
-			shipAccelerationV = Normalize(ship.vel);
+			shipAccelerationV = Normalize(entities.vel_p[ship]);
 		}
 		if (GameInput_Button(BUTTON_A))
 		{
 			shipAcceleration = SHIP_ACCELERATION;
-			Vector2 leftFacingV = RotateDeg(ship.facingV, 90);
+			Vector2 leftFacingV = RotateDeg(shipFacingV, 90);
 			shipAccelerationV = leftFacingV;
 		}
 		if (GameInput_Button(BUTTON_D))
 		{
 			shipAcceleration = SHIP_ACCELERATION;
-			Vector2 rightFacingV = RotateDeg(ship.facingV, -90);
+			Vector2 rightFacingV = RotateDeg(shipFacingV, -90);
 			shipAccelerationV = rightFacingV;
 		}
 
-		if (mouse.leftButton == MOUSE_PRESSED || mouse.leftButton == MOUSE_DOUBLECLICK)
+		if (fireRequested)
 		{
-			Entity* bullet_p = &bullets[(bulletIdx++) % MAX_BULLETS];
-			bullet_p->pos = ship.pos;
-			bullet_p->facingV = ship.facingV;
-			bullet_p->vel = ship.vel + BULLET_SPEED * Normalize(ship.facingV);
-			bullet_p->enabled = true;
-			bullet_p->tEnabled = time;
+			SpawnProjectile(&bulletPool, shipPos, shipFacingV, entities.vel_p[ship] + BULLET_SPEED * Normalize(shipFacingV));
 		}
 
-		if ((mouse.leftButton == MOUSE_PRESSED_HOLD) && (GetMouseHoldTime(mouse) > 0.5f) && !chargedBulletHolding_p)
+		if ((mouse.leftButton == MOUSE_PRESSED_HOLD) && (GetMouseHoldTime(mouse) > 0.5f) && (chargedBulletHolding == POOL_HANDLE_NONE))
 		{
-			Entity* bullet_p = &chargedBullets[(chargedBulletIdx++) % MAX_CHARGEDBULLETS];
-			bullet_p->pos = ship.pos + 20.0f * ship.facingV;
-			bullet_p->facingV = ship.facingV;
-			bullet_p->vel = VECTOR2_ZERO;
-			bullet_p->enabled = true;
-			bullet_p->tEnabled = time;
-			chargedBulletHolding_p = bullet_p;
+			EntityId chargedBullet = SpawnProjectile(&chargedBulletPool, shipPos + 20.0f * shipFacingV, shipFacingV, VECTOR2_ZERO);
+			if (chargedBullet != ENTITY_INVALID) chargedBulletHolding = entityInfos[chargedBullet].handle;
 		}
 	}
 
-	ship.vel += shipAcceleration * deltaT * Normalize(shipAccelerationV);
+	fireRequested = false;
+
+	Vector2* shipVel_p = &entities.vel_p[ship];
+	*shipVel_p += shipAcceleration * deltaT * Normalize(shipAccelerationV);
 	if (shipAcceleration == 0.0f)
 	{
-		ship.vel = 0.97f * ship.vel;
+		*shipVel_p = 0.97f * *shipVel_p;
 	}
 
-	if (chargedBulletHolding_p)
+	if (chargedBulletHolding != POOL_HANDLE_NONE)
 	{
-		chargedBulletHolding_p->facingV = ship.facingV;
-		chargedBulletHolding_p->pos = ship.pos + 20.0f * ship.facingV;
-		chargedBulletHolding_p->tEnabled = time;
+		// Null when the held bullet was destroyed before release, e.g. by touching a turret.
+		EntityId* chargedBullet_p = PoolGet(&chargedBulletPool, chargedBulletHolding);
+		if (chargedBullet_p)
+		{
+			entities.facingV_p[*chargedBullet_p] = shipFacingV;
+			entities.pos_p[*chargedBullet_p] = shipPos + 20.0f * shipFacingV;
+			entities.tEnabled_p[*chargedBullet_p] = time;
+		}
 		if (mouse.leftButton == MOUSE_RELEASED)
 		{
-			chargedBulletHolding_p->vel = ship.vel + BULLET_SPEED * Normalize(ship.facingV);
+			if (chargedBullet_p) entities.vel_p[*chargedBullet_p] = *shipVel_p + BULLET_SPEED * Normalize(shipFacingV);
 			for (int i = 0; i < 2; i++)
 			{
-				Entity* bullet1_p = &bullets[(bulletIdx++) % MAX_BULLETS];
-				bullet1_p->pos = ship.pos;
-				bullet1_p->facingV = RotateDeg(ship.facingV, 3 * (i + 1));
-				bullet1_p->vel = ship.vel + BULLET_SPEED * Normalize(bullet1_p->facingV);
-				bullet1_p->enabled = true;
-				bullet1_p->tEnabled = time;
-
-				Entity* bullet2_p = &bullets[(bulletIdx++) % MAX_BULLETS];
-				bullet2_p->pos = ship.pos;
-				bullet2_p->facingV = RotateDeg(ship.facingV, -3 * (i + 1));
-				bullet2_p->vel = ship.vel + BULLET_SPEED * Normalize(bullet2_p->facingV);
-				bullet2_p->enabled = true;
-				bullet2_p->tEnabled = time;
+				Vector2 facingV1 = RotateDeg(shipFacingV, 3 * (i + 1));
+				SpawnProjectile(&bulletPool, shipPos, facingV1, *shipVel_p + BULLET_SPEED * Normalize(facingV1));
+
+				Vector2 facingV2 = RotateDeg(shipFacingV, -3 * (i + 1));
+				SpawnProjectile(&bulletPool, shipPos, facingV2, *shipVel_p + BULLET_SPEED * Normalize(facingV2));
 			}
-			chargedBulletHolding_p = nullptr;
+			chargedBulletHolding = POOL_HANDLE_NONE;
 		}
 	}
 
+	if (shipEnabled && shipAcceleration > 0.0f)
+	{
+		Vector2 posExhaust = shipPos - 0.77f * shipInfo_p->size * shipFacingV;
+		int emitter = (shipAcceleration >= SHIP_BOOST) ? emitterExhaustBoost : emitterExhaust;
+		ParticlesEmit(&particles, emitter, posExhaust, -shipFacingV, deltaT);
+	}
+
 	entityCollisions.count = 0;
 	if (asteroidsRemaining == 0)
 	{
@@ -913,287 +981,233 @@ static void Game(float deltaT, Renderer* renderer_p)
 		asteroidsRemaining = level.asteroidsCount;
 	}
 
-	ship.pos += deltaT * ship.vel;
-	if (ship.enabled && (time > ship.tInvisibility)) AddToCollisions(&entityCollisions, &ship);
-	//PushVector(renderer_p, ship.pos + 50.0f * Normalize(asteroid.pos - ship.pos), 20.0f*Normalize(asteroid.pos - ship.pos));
+	entities.pos_p[ship] += deltaT * *shipVel_p;
+	if (shipEnabled && (time > shipInfo_p->tInvisibility)) AddToCollisions(&entityCollisions, ship);
 
-	for (int i = 0; i < MAX_BULLETS; i++)
-	{
-		Entity* bullet_p = &bullets[i];
-		if (bullet_p->enabled)
-		{
-			bullet_p->pos += deltaT * bullet_p->vel;
-			AddToCollisions(&entityCollisions, bullet_p);
-			if ((time - bullet_p->tEnabled) > BULLET_LIFETIME) bullet_p->enabled = false;
-		}
-	}
+	EntityList* bulletList_p = &entities.lists_p[LIST_BULLETS];
+	EntitiesIntegrate(&entities, bulletList_p, deltaT);
+	for (int i = 0; i < bulletList_p->count; i++) AddToCollisions(&entityCollisions, bulletList_p->ids_p[i]);
 
-	for (int i = 0; i < MAX_ASTEROIDS; i++)
+	// Asteroids still invisible after spawning hold still, the rest move in one batch.
+	EntityList* asteroidList_p = &entities.lists_p[LIST_ASTEROIDS];
+	EntityId movingAsteroids[MAX_ASTEROIDS];
+	EntityList movingAsteroidList = { 0, movingAsteroids };
+	for (int i = 0; i < asteroidList_p->count; i++)
 	{
-		Entity* asteroid_p = &asteroids[i];
-		if (asteroid_p->enabled && (time > asteroid_p->tInvisibility))
+		EntityId asteroid = asteroidList_p->ids_p[i];
+		if (time > entityInfos[asteroid].tInvisibility)
 		{
-			asteroid_p->facingV = RotateDeg(asteroid_p->facingV, asteroid_p->rotSpeed * deltaT);
-			asteroid_p->pos += deltaT * asteroid_p->vel;
-			AddToCollisions(&entityCollisions, asteroid_p);
+			movingAsteroidList.ids_p[movingAsteroidList.count++] = asteroid;
+			AddToCollisions(&entityCollisions, asteroid);
 		}
 	}
+	EntitiesRotate(&entities, &movingAsteroidList, deltaT);
+	EntitiesIntegrate(&entities, &movingAsteroidList, deltaT);
 
-	for (int i = 0; i < MAX_TURRETS; i++)
+	EntityList* turretList_p = &entities.lists_p[LIST_TURRETS];
+	for (int i = 0; i < turretList_p->count; i++)
 	{
-		Entity* turret_p = &turrets[i];
-		if (turret_p->enabled && (time > turret_p->tInvisibility))
+		EntityId turret = turretList_p->ids_p[i];
+		EntityInfo* turretInfo_p = &entityInfos[turret];
+		if (time > turretInfo_p->tInvisibility)
 		{
-			int nextAngle = turret_p->e.nextAngle;
-			int prevAngle = turret_p->e.prevAngle;
-			float angle = AngleDeg360(VECTOR2_UP, turret_p->facingV);
+			int nextAngle = turretInfo_p->e.nextAngle;
+			int prevAngle = turretInfo_p->e.prevAngle;
+			float angle = AngleDeg360(VECTOR2_UP, entities.facingV_p[turret]);
 			
 			if (((nextAngle > prevAngle) && (angle >= nextAngle)) || ((nextAngle < prevAngle) && (angle < prevAngle && angle >= nextAngle)))
 			{
-				turret_p->facingV = RotateDeg(VECTOR2_UP, nextAngle);
-				turret_p->rotSpeed = 0.0f;
-				turret_p->e.tNextMove = time + 1.0f;
-				turret_p->e.prevAngle = turret_p->e.nextAngle;
-				turret_p->e.nextAngle = (turret_p->e.nextAngle + 45) % 360;
+				entities.facingV_p[turret] = RotateDeg(VECTOR2_UP, nextAngle);
+				entities.rotSpeed_p[turret] = 0.0f;
+				turretInfo_p->e.tNextMove = time + 1.0f;
+				turretInfo_p->e.prevAngle = turretInfo_p->e.nextAngle;
+				turretInfo_p->e.nextAngle = (turretInfo_p->e.nextAngle + 45) % 360;
 
-				Vector2 facingV = turret_p->facingV;
+				Vector2 facingV = entities.facingV_p[turret];
 				for (size_t i = 0; i < 4; i++)
 				{
-					Entity* bullet_p = &enemyBullets[(enemyBulletIdx++) % MAX_BULLETS];
-					bullet_p->pos = turret_p->pos;
-					bullet_p->vel = BULLET_SPEED * facingV;
-					bullet_p->facingV = facingV;
-					bullet_p->enabled = true;
-					bullet_p->tEnabled = time;
+					SpawnProjectile(&enemyBulletPool, entities.pos_p[turret], facingV, BULLET_SPEED * facingV);
 
 					facingV = RotateDeg(facingV, 90);
 				}				
 			}
 
-			if (time >= turret_p->e.tNextMove)
+			if (time >= turretInfo_p->e.tNextMove)
 			{
-				turret_p->rotSpeed = 180.0f;
+				entities.rotSpeed_p[turret] = 180.0f;
 			}
 
-			turret_p->facingV = RotateDeg(turret_p->facingV, turret_p->rotSpeed * deltaT);
+			entities.facingV_p[turret] = RotateDeg(entities.facingV_p[turret], entities.rotSpeed_p[turret] * deltaT);
 
-			AddToCollisions(&entityCollisions, turret_p);
+			AddToCollisions(&entityCollisions, turret);
 		}
 	}
 
-	for (int i = 0; i < MAX_BULLETS; i++)
-	{
-		Entity* bullet_p = &enemyBullets[i];
-		if (bullet_p->enabled)
-		{
-			bullet_p->pos += deltaT * bullet_p->vel;
-			AddToCollisions(&entityCollisions, bullet_p);
-			if ((time - bullet_p->tEnabled) > BULLET_LIFETIME) bullet_p->enabled = false;
-		}
-	}
+	EntityList* enemyBulletList_p = &entities.lists_p[LIST_ENEMYBULLETS];
+	EntitiesIntegrate(&entities, enemyBulletList_p, deltaT);
+	for (int i = 0; i < enemyBulletList_p->count; i++) AddToCollisions(&entityCollisions, enemyBulletList_p->ids_p[i]);
 
-	for (int i = 0; i < MAX_PARTICLES_DEBRIS; i++)
-	{
-		Particle* particle_p = &psDebris.particles_p[i];
-		if (particle_p->enabled)
-		{
-			particle_p->pos += deltaT * particle_p->vel;
-			if ((time - particle_p->tEnabled) > PARTICLE_DEBRIS_LIFETIME) particle_p->enabled = false;
-		}
-	}
+	ParticlesUpdate(&particles, deltaT);
 
-	for (int i = 0; i < MAX_PARTICLES_EXHAUST; i++)
-	{
-		Particle* particle_p = &psExhaust.particles_p[i];
-		if (particle_p->enabled)
-		{
-			particle_p->pos += deltaT * particle_p->vel;
-			if ((time - particle_p->tEnabled) > PARTICLE_EXHAUST_LIFETIME) particle_p->enabled = false;
-		}
-	}
-
-	for (int i = 0; i < MAX_CHARGEDBULLETS; i++)
-	{
-		Entity* chargedBullet_p = &chargedBullets[i];
-		if (chargedBullet_p->enabled)
-		{
-			chargedBullet_p->pos += deltaT * chargedBullet_p->vel;
-			AddToCollisions(&entityCollisions, chargedBullet_p);
-			if ((time - chargedBullet_p->tEnabled) > BULLET_LIFETIME) chargedBullet_p->enabled = false;
-		}
-	}
-
-	if (explosionCharged.enabled)
-	{
-		explosionCharged.enabled = !AnimationUpdate(&explosionCharged.animation, time);
-	}
+	EntityList* chargedBulletList_p = &entities.lists_p[LIST_CHARGEDBULLETS];
+	EntitiesIntegrate(&entities, chargedBulletList_p, deltaT);
+	for (int i = 0; i < chargedBulletList_p->count; i++) AddToCollisions(&entityCollisions, chargedBulletList_p->ids_p[i]);
 
-	if (explosionShip.enabled)
-	{
-		explosionShip.enabled = !AnimationUpdate(&explosionShip.animation, time);
-	}
+	FreeEndedExplosions();
 
-	for (int i = 0; i < MAX_EXPLOSIONS_SMALL; i++)
-	{
-		AnimationObject* explosionSmall_p = &explosionsSmall[i];
-		if (explosionSmall_p->enabled)
-		{
-			explosionSmall_p->enabled = !AnimationUpdate(&explosionSmall_p->animation, time);
-		}
-	}
+	// Expired projectiles still take part in this tick's collisions, they were added above.
+	DestroyExpired(LIST_BULLETS, BULLET_LIFETIME);
+	DestroyExpired(LIST_ENEMYBULLETS, BULLET_LIFETIME);
+	DestroyExpired(LIST_CHARGEDBULLETS, BULLET_LIFETIME);
 
-	if (levelCountdown <= 0) ship.health = 0;
+	if (levelCountdown <= 0) shipInfo_p->health = 0;
 
-	if (!ship.enabled && time >= ship.e.tRespawn)
+	if (!EntityIsLive(&entities, ship) && time >= shipInfo_p->e.tRespawn)
 	{
-		ship.enabled = true;
-		ship.facingV = VECTOR2_UP;
-		ship.pos = VECTOR2_ZERO;
-		ship.tEnabled = time;
-		ship.tInvisibility = time + INVISIBILITY_DURATION;
-		ship.health = 100.0f;
+		entities.facingV_p[ship] = VECTOR2_UP;
+		entities.pos_p[ship] = VECTOR2_ZERO;
+		entities.tEnabled_p[ship] = time;
+		shipInfo_p->tInvisibility = time + INVISIBILITY_DURATION;
+		shipInfo_p->health = 100.0f;
+		EntitySpawn(&entities, ship);
 
 		if (levelCountdown <= 0) levelCountdown = 60.0f;
 	}
 
-	if (ship.health == 0 && ship.enabled)
+	if (shipInfo_p->health == 0 && EntityIsLive(&entities, ship))
 	{
 		explosionShip.enabled = true;
-		explosionShip.pos = ship.pos;
-		explosionShip.animation.tStart = time;
+		explosionShip.pos = entities.pos_p[ship];
+		explosionShip.animation = AnimationPlay(explosionShipClip, time);
 
-		ship.enabled = false;
-		ship.e.tRespawn = time + SHIP_DEATH_DURATION;
+		DestroyEntity(ship);
+		shipInfo_p->e.tRespawn = time + SHIP_DEATH_DURATION;
 	}
 
 	EntityEntityCollisions(&entityCollisions);
 	EntitySolidCollisions(&entityCollisions, deltaT, &solid);
+}
 
-	camera.rect = NewRectCenterPos(ship.pos, camera.rect.size);
+// Draws the state between the last two simulation ticks, alpha in [0, 1).
+static void GameRender(Renderer* renderer_p, float alpha)
+{
+	Vector2 shipPos = RenderPos(ship, alpha);
+	Vector2 shipFacingV = RenderFacingV(ship, alpha);
+	EntityInfo* shipInfo_p = &entityInfos[ship];
+
+	camera.rect = NewRectCenterPos(shipPos, camera.rect.size);
 	SetSpritesOrtographicProj(renderer_p, camera.rect);
 	SetWireframeOrtographicProj(renderer_p, camera.rect);
+	SetParticlesOrtographicProj(renderer_p, camera.rect);
 
-	PushXCross(renderer_p, mouse.pos, COLOR_YELLOW);
-
-GAMEUPDATE_END:
+	if (!paused) PushXCross(renderer_p, MouseToWorldPos(GameInput_GetMouse().pos), COLOR_YELLOW);
 
-	for (int i = 0; i < MAX_SOLIDS; i++)
+	// Every level builds the same solids, so their mesh is built on the first frame and kept.
+	if (solidMesh == STATIC_MESH_NONE)
 	{
-		LineSegment solidLine = solid.solidLines[i];
-		PushLine(renderer_p, solidLine.p1, solidLine.p2, COLOR_GREEN);
+		StaticMeshBegin(renderer_p);
+		for (int i = 0; i < solid.solidLinesCount; i++)
+		{
+			LineSegment solidLine = solid.solidLines[i];
+			PushLine(renderer_p, solidLine.p1, solidLine.p2, COLOR_GREEN);
+		}
+		solidMesh = StaticMeshEnd(renderer_p);
 	}
+	if (solidMesh != STATIC_MESH_NONE) PushStaticMesh(renderer_p, solidMesh);
 
-	for (int i = 0; i < MAX_BULLETS; i++)
+	EntityList* bulletList_p = &entities.lists_p[LIST_BULLETS];
+	for (int i = 0; i < bulletList_p->count; i++)
 	{
-		Entity* bullet_p = &bullets[i];
-		if (bullet_p->enabled) PushSprite(renderer_p, bullet_p->pos, bullet_p->size * VECTOR2_ONE, bullet_p->facingV, bullet_p->textureHandle);
-		bullet_p = &enemyBullets[i];
-		if (bullet_p->enabled) PushSprite(renderer_p, bullet_p->pos, bullet_p->size * VECTOR2_ONE, bullet_p->facingV, bullet_p->textureHandle, COLOR_RED);
+		EntityId bullet = bulletList_p->ids_p[i];
+		EntityInfo* bulletInfo_p = &entityInfos[bullet];
+		PushSprite(renderer_p, RenderPos(bullet, alpha), bulletInfo_p->size * VECTOR2_ONE, entities.facingV_p[bullet], bulletInfo_p->textureHandle, COLOR_WHITE, RECT_ONE, RENDER_LAYER_BACKGROUND);
 	}
 
-	for (int i = 0; i < MAX_CHARGEDBULLETS; i++)
+	EntityList* enemyBulletList_p = &entities.lists_p[LIST_ENEMYBULLETS];
+	for (int i = 0; i < enemyBulletList_p->count; i++)
 	{
-		Entity* chargedBullet_p = &chargedBullets[i];
-		if (chargedBullet_p->enabled)
-		{
-			PushSprite(renderer_p, chargedBullet_p->pos, chargedBullet_p->size * V2(1.0f, 1.7f), chargedBullet_p->facingV, chargedBullet_p->textureHandle);
-			//PushCircle(renderer_p, chargedBullet_p->pos, chargedBullet_p->colliderRadius, COLOR_GREEN);
-		}
+		EntityId bullet = enemyBulletList_p->ids_p[i];
+		EntityInfo* bulletInfo_p = &entityInfos[bullet];
+		PushSprite(renderer_p, RenderPos(bullet, alpha), bulletInfo_p->size * VECTOR2_ONE, entities.facingV_p[bullet], bulletInfo_p->textureHandle, COLOR_RED, RECT_ONE, RENDER_LAYER_BACKGROUND);
 	}
 
-	for (int i = 0; i < MAX_PARTICLES_DEBRIS; i++)
+	EntityList* chargedBulletList_p = &entities.lists_p[LIST_CHARGEDBULLETS];
+	for (int i = 0; i < chargedBulletList_p->count; i++)
 	{
-		Particle* particle_p = &psDebris.particles_p[i];
-		if (particle_p->enabled)
-		{
-			float lifePerc = (time - particle_p->tEnabled) / PARTICLE_DEBRIS_LIFETIME;
-			Color color = particle_p->color; color.a = 1.0f - lifePerc;
-			PushCircle(renderer_p, particle_p->pos, 1.0f, color, 3);
-		}
+		EntityId chargedBullet = chargedBulletList_p->ids_p[i];
+		EntityInfo* chargedBulletInfo_p = &entityInfos[chargedBullet];
+		PushSprite(renderer_p, RenderPos(chargedBullet, alpha), chargedBulletInfo_p->size * V2(1.0f, 1.7f), RenderFacingV(chargedBullet, alpha), chargedBulletInfo_p->textureHandle, COLOR_WHITE, RECT_ONE, RENDER_LAYER_BACKGROUND);
+		//PushCircle(renderer_p, entities.pos_p[chargedBullet], entities.colliderRadius_p[chargedBullet], COLOR_GREEN);
 	}
 
-	for (int i = 0; i < MAX_PARTICLES_EXHAUST; i++)
-	{
-		Particle* particle_p = &psExhaust.particles_p[i];
-		if (particle_p->enabled)
-		{
-			float lifePerc = (time - particle_p->tEnabled) / PARTICLE_EXHAUST_LIFETIME;
-			Color color = particle_p->color; color.a = 1.0f - lifePerc;
-			PushCircle(renderer_p, particle_p->pos, 1.0f, color, 3);
-		}
-	}
+	ParticlesRender(&particles, renderer_p);
 
-	if (ship.enabled)
+	if (EntityIsLive(&entities, ship))
 	{
 		if (shipAcceleration > 0.0f)
 		{
-			Vector2 posExhaust = ship.pos - 0.77f * ship.size * ship.facingV;
+			Vector2 posExhaust = shipPos - 0.77f * shipInfo_p->size * shipFacingV;
 			float exhaustYScale = 0.1f * sin(2 * PI * EXHAUST_FREQUENCY * time) + 0.9f;
 			Rect uvExhaust = NewRect(V2(0.5306, 0.35), V2(0.1361, 0.65));
 			if (shipAcceleration >= SHIP_BOOST) uvExhaust = NewRect(V2(0, 0.35), V2(0.1361, 0.65));
-			PushSprite(renderer_p, posExhaust, V2(ship.size / 2, exhaustYScale * ship.size), -ship.facingV, TEXTURE_SHIPEXHAUST, COLOR_WHITE, uvExhaust);
-
-			Color colorParticle = COLOR_EXHAUST;
-			if (shipAcceleration >= SHIP_BOOST) colorParticle = COLOR_EXHAUST_BOOST;
-			SpawnExhaustParticles(posExhaust, -ship.facingV, colorParticle);
+			PushSprite(renderer_p, posExhaust, V2(shipInfo_p->size / 2, exhaustYScale * shipInfo_p->size), -shipFacingV, TEXTURE_SHIPEXHAUST, COLOR_WHITE, uvExhaust, RENDER_LAYER_BACKGROUND);
 		}
 
 		if (shipAcceleration < 0.0f)
 		{
-			Vector2 posExhaust1 = ship.pos + (ship.size / 4) * RotateDeg(ship.facingV,  90) + (ship.size / 8) * ship.facingV;
-			Vector2 posExhaust2 = ship.pos + (ship.size / 4) * RotateDeg(ship.facingV, -90) + (ship.size / 8) * ship.facingV;
+			Vector2 posExhaust1 = shipPos + (shipInfo_p->size / 4) * RotateDeg(shipFacingV,  90) + (shipInfo_p->size / 8) * shipFacingV;
+			Vector2 posExhaust2 = shipPos + (shipInfo_p->size / 4) * RotateDeg(shipFacingV, -90) + (shipInfo_p->size / 8) * shipFacingV;
 			float exhaustYScale = 0.1f * sin(2 * PI * EXHAUST_FREQUENCY * time) + 0.9f;
 			Rect uvExhaust = NewRect(V2(0.3197, 0.35), V2(0.0816, 0.40));
-			PushSprite(renderer_p, posExhaust1, V2(ship.size / 4, exhaustYScale * (ship.size/2)), RotateDeg(ship.facingV,  10), TEXTURE_SHIPEXHAUST, COLOR_WHITE, uvExhaust);
-			PushSprite(renderer_p, posExhaust2, V2(ship.size / 4, exhaustYScale * (ship.size/2)), RotateDeg(ship.facingV, -10), TEXTURE_SHIPEXHAUST, COLOR_WHITE, uvExhaust);
+			PushSprite(renderer_p, posExhaust1, V2(shipInfo_p->size / 4, exhaustYScale * (shipInfo_p->size/2)), RotateDeg(shipFacingV,  10), TEXTURE_SHIPEXHAUST, COLOR_WHITE, uvExhaust, RENDER_LAYER_BACKGROUND);
+			PushSprite(renderer_p, posExhaust2, V2(shipInfo_p->size / 4, exhaustYScale * (shipInfo_p->size/2)), RotateDeg(shipFacingV, -10), TEXTURE_SHIPEXHAUST, COLOR_WHITE, uvExhaust, RENDER_LAYER_BACKGROUND);
 		}
 
 		Color color = COLOR_WHITE;
-		if (time < ship.tInvisibility) color.a = Blink(ship.tEnabled) ? 1.0f : 0.0f;
-		if (time < ship.tTakingDamage) color.g = Blink(ship.tEnabled) ? 1.0f : 0.0f;
-		PushSprite(renderer_p, ship.pos, ship.size* VECTOR2_ONE, ship.facingV, ship.textureHandle, color);
-		//PushCircle(renderer_p, ship.pos, ship.colliderRadius, COLOR_GREEN);
+		if (time < shipInfo_p->tInvisibility) color.a = Blink(entities.tEnabled_p[ship]) ? 1.0f : 0.0f;
+		if (time < shipInfo_p->tTakingDamage) color.g = Blink(entities.tEnabled_p[ship]) ? 1.0f : 0.0f;
+		PushSprite(renderer_p, shipPos, shipInfo_p->size* VECTOR2_ONE, shipFacingV, shipInfo_p->textureHandle, color);
+		//PushCircle(renderer_p, entities.pos_p[ship], entities.colliderRadius_p[ship], COLOR_GREEN);
 	}
-	for (int i = 0; i < MAX_ASTEROIDS; i++)
+	EntityList* asteroidList_p = &entities.lists_p[LIST_ASTEROIDS];
+	for (int i = 0; i < asteroidList_p->count; i++)
 	{
-		Entity* asteroid_p = &asteroids[i];
-		if (asteroid_p->enabled)
-		{
-			Color color = COLOR_WHITE;
-			if (time < asteroid_p->tInvisibility) color.a = Blink(ship.tEnabled) ? 1.0f : 0.0f;
-			PushSprite(renderer_p, asteroid_p->pos, asteroid_p->size * VECTOR2_ONE, asteroid_p->facingV, asteroid_p->textureHandle, color, asteroid_p->uv);
-			//PushCircle(renderer_p, asteroid_p->pos, asteroid_p->colliderRadius, COLOR_GREEN);
-		}
+		EntityId asteroid = asteroidList_p->ids_p[i];
+		EntityInfo* asteroidInfo_p = &entityInfos[asteroid];
+		Color color = COLOR_WHITE;
+		if (time < asteroidInfo_p->tInvisibility) color.a = Blink(entities.tEnabled_p[ship]) ? 1.0f : 0.0f;
+		PushSprite(renderer_p, RenderPos(asteroid, alpha), asteroidInfo_p->size * VECTOR2_ONE, RenderFacingV(asteroid, alpha), asteroidInfo_p->textureHandle, color, asteroidInfo_p->uv);
+		//PushCircle(renderer_p, entities.pos_p[asteroid], entities.colliderRadius_p[asteroid], COLOR_GREEN);
 	}
 
-	for (int i = 0; i < MAX_TURRETS; i++)
+	EntityList* turretList_p = &entities.lists_p[LIST_TURRETS];
+	for (int i = 0; i < turretList_p->count; i++)
 	{
-		Entity* turret_p = &turrets[i];
-		if (turret_p->enabled)
-		{
-			Color color = COLOR_WHITE;
-			if (time < turret_p->tInvisibility) color.a = Blink(turret_p->tEnabled) ? 1.0f : 0.0f;
-			PushSprite(renderer_p, turret_p->pos, turret_p->size * VECTOR2_ONE, turret_p->facingV, turret_p->textureHandle, color, turret_p->uv);
-			//PushCircle(renderer_p, turret_p->pos, turret_p->colliderRadius, COLOR_GREEN);
-		}
+		EntityId turret = turretList_p->ids_p[i];
+		EntityInfo* turretInfo_p = &entityInfos[turret];
+		Color color = COLOR_WHITE;
+		if (time < turretInfo_p->tInvisibility) color.a = Blink(entities.tEnabled_p[turret]) ? 1.0f : 0.0f;
+		PushSprite(renderer_p, entities.pos_p[turret], turretInfo_p->size * VECTOR2_ONE, RenderFacingV(turret, alpha), turretInfo_p->textureHandle, color, turretInfo_p->uv);
+		//PushCircle(renderer_p, entities.pos_p[turret], entities.colliderRadius_p[turret], COLOR_GREEN);
 	}
 
-	if (explosionCharged.enabled)
+	// Animation frames are evaluated from time here, explosions that played out are skipped.
+	if (explosionCharged.enabled && !AnimationEnded(&explosionCharged.animation, time))
 	{
-		PushSprite(renderer_p, explosionCharged.pos, 200.0f * VECTOR2_ONE, VECTOR2_UP, explosionCharged.textureHandle, Col(0.537f, 0.902f, 1.0f), AnimationGetCurrentUv(&explosionCharged.animation));
+		PushSprite(renderer_p, explosionCharged.pos, 200.0f * VECTOR2_ONE, VECTOR2_UP, explosionCharged.textureHandle, Col(0.537f, 0.902f, 1.0f), AnimationGetCurrentUv(&explosionCharged.animation, time), RENDER_LAYER_EFFECTS);
 	}
 
-	if (explosionShip.enabled)
+	if (explosionShip.enabled && !AnimationEnded(&explosionShip.animation, time))
 	{
-		PushSprite(renderer_p, explosionShip.pos, 200.0f * VECTOR2_ONE, VECTOR2_UP, explosionShip.textureHandle, COLOR_WHITE, AnimationGetCurrentUv(&explosionShip.animation));
+		PushSprite(renderer_p, explosionShip.pos, 200.0f * VECTOR2_ONE, VECTOR2_UP, explosionShip.textureHandle, COLOR_WHITE, AnimationGetCurrentUv(&explosionShip.animation, time), RENDER_LAYER_EFFECTS);
 	}
 
-	for (int i = 0; i < MAX_EXPLOSIONS_SMALL; i++)
+	for (U32 i = 0; i < explosionSmallPool.used; i++)
 	{
-		AnimationObject* explosionSmall_p = &explosionsSmall[i];
-		if (explosionSmall_p->enabled)
+		AnimationObject* explosionSmall_p = PoolGet(&explosionSmallPool, PoolHandleAt(&explosionSmallPool, i));
+		if (explosionSmall_p && !AnimationEnded(&explosionSmall_p->animation, time))
 		{
-			PushSprite(renderer_p, explosionSmall_p->pos, 50.0f * VECTOR2_ONE, VECTOR2_UP, explosionSmall_p->textureHandle, COLOR_WHITE, AnimationGetCurrentUv(&explosionSmall_p->animation));
+			PushSprite(renderer_p, explosionSmall_p->pos, 50.0f * VECTOR2_ONE, VECTOR2_UP, explosionSmall_p->textureHandle, COLOR_WHITE, AnimationGetCurrentUv(&explosionSmall_p->animation, time), RENDER_LAYER_EFFECTS);
 		}
 	}
 
@@ -1202,9 +1216,9 @@ GAMEUPDATE_END:
 	sprintf(buf, "Remaining: %d", asteroidsRemaining);
 	UILabel(buf, V2(0.01f, 0.01f), TEXT_ALIGN_LEFT);
 
-	sprintf(buf, "Health: %d", (int)ship.health);
+	sprintf(buf, "Health: %d", (int)shipInfo_p->health);
 	UILabel(buf, V2(0.79f, 0.02f), TEXT_ALIGN_RIGHT);
-	float healthBarWidth = 0.1880f * (ship.health / 100.0f);
+	float healthBarWidth = 0.1880f * (shipInfo_p->health / 100.0f);
 	UIRect(NewRect(V2(0.8f, 0.010f), V2(0.19f, 0.02f)), COLOR_WHITE);
 	UIRect(NewRect(V2(0.801f, 0.011f), V2(healthBarWidth, 0.018f)), Col(0.19f, 0.49f, 0.25f, 1.0f));
 
@@ -1219,6 +1233,67 @@ GAMEUPDATE_END:
 	}
 }
 
+static void Game(float deltaT, Renderer* renderer_p)
+{
+	Mouse mouse = GameInput_GetMouse();
+	if (mouse.leftButton == MOUSE_PRESSED || mouse.leftButton == MOUSE_DOUBLECLICK) fireRequested = true;
+
+	if (!paused)
+	{
+		simAccumulator += deltaT;
+		int steps = 0;
+		while (simAccumulator >= SIM_DELTAT && steps < MAX_SIM_STEPS_PER_FRAME)
+		{
+			double tStart = GetTime();
+			GameUpdate(SIM_DELTAT);
+			simStats.updateSeconds += GetTime() - tStart;
+			simStats.ticks++;
+
+			simAccumulator -= SIM_DELTAT;
+			steps++;
+		}
+		if (steps == MAX_SIM_STEPS_PER_FRAME) simAccumulator = fmod(simAccumulator, SIM_DELTAT);
+	}
+	else
+	{
+		fireRequested = false;
+	}
+
+	GameRender(renderer_p, (float)(simAccumulator / SIM_DELTAT));
+}
+
+GameSimStats GameGetSimStats()
+{
+	return simStats;
+}
+
+template <typename T>
+static GamePoolStats GetPoolStats(const char* name, const Pool<T>* pool_p)
+{
+	GamePoolStats result = { name, pool_p->capacity, pool_p->stats };
+	return result;
+}
+
+void GameGetPoolStats(GamePoolStats stats[GAME_POOL_COUNT])
+{
+	stats[0] = GetPoolStats("asteroids", &asteroidPool);
+	stats[1] = GetPoolStats("bullets", &bulletPool);
+	stats[2] = GetPoolStats("enemy bullets", &enemyBulletPool);
+	stats[3] = GetPoolStats("charged bullets", &chargedBulletPool);
+	stats[4] = GetPoolStats("small explosions", &explosionSmallPool);
+}
+
+ParticleStats GameGetParticleStats()
+{
+	return particles.stats;
+}
+
+void GameSkipMainMenu(int startLevel)
+{
+	GameStart(startLevel);
+	scene = SCENE_GAME;
+}
+
 static bool PausedMenu()
 {
 	bool paused = true;
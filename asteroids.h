@@ -1,6 +1,30 @@
 #pragma once
 #include "vector.h"
 #include "renderer.h"
+#include "pool.h"
+#include "particles.h"
+
+#define ASTEROID_SIZE_MIN 80
+#define ASTEROID_SIZE_MAX 280
+
+struct GameSimStats
+{
+	U64 ticks;            // Fixed simulation steps run so far.
+	double updateSeconds; // Wall time spent inside those steps.
+};
+
+struct GamePoolStats
+{
+	const char* name;
+	U32 capacity;
+	PoolStats stats;
+};
+
+#define GAME_POOL_COUNT 5
 
 void GameInit();
-bool GameUpdateAndRender(float deltaT, Renderer* renderer_p);
\ No newline at end of file
+void GameSkipMainMenu(int startLevel = 1); // Starts a level right away, used when running headless.
+bool GameUpdateAndRender(float deltaT, Renderer* renderer_p); // deltaT is wall clock time, simulation runs in fixed steps.
+GameSimStats GameGetSimStats();
+void GameGetPoolStats(GamePoolStats stats[GAME_POOL_COUNT]); // Accumulated over every game started since GameInit.
+ParticleStats GameGetParticleStats();
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "atlas.h"
+
+#define ATLAS_CACHE_MAGIC   0x534C5441 // "ATLS"
+#define ATLAS_CACHE_VERSION 1
+#define MAX_SKYLINE_NODES   (TEXTURES_COUNT + 1)
+
+struct AtlasPlacement
+{
+	int x;
+	int y;
+};
+
+struct AtlasCacheHeader
+{
+	U32 magic;
+	U32 version;
+	int width;
+	int height;
+	int count;
+};
+
+struct AtlasCacheEntry
+{
+	int srcWidth;
+	int srcHeight;
+	int x;
+	int y;
+};
+
+struct SkylineNode
+{
+	int x;
+	int y;
+	int width;
+};
+
+struct Skyline
+{
+	int width;
+	int height;
+	int nodeCount;
+	SkylineNode nodes[MAX_SKYLINE_NODES];
+};
+
+static void SkylineInit(Skyline* skyline_p, int width, int height)
+{
+	memset(skyline_p, 0, sizeof(*skyline_p));
+	skyline_p->width = width;
+	skyline_p->height = height;
+	skyline_p->nodeCount = 1;
+	skyline_p->nodes[0] = { 0, 0, width };
+}
+
+// Returns the y where a rect of the given width fits when its left edge sits on node nodeIdx, or -1.
+static int SkylineFit(Skyline* skyline_p, int nodeIdx, int width, int height)
+{
+	int x = skyline_p->nodes[nodeIdx].x;
+	if (x + width > skyline_p->width) return -1;
+
+	int y = 0;
+	int widthLeft = width;
+	int i = nodeIdx;
+	while (widthLeft > 0)
+	{
+		assert(i < skyline_p->nodeCount);
+		if (skyline_p->nodes[i].y > y) y = skyline_p->nodes[i].y;
+		if (y + height > skyline_p->height) return -1;
+		widthLeft -= skyline_p->nodes[i].width;
+		i++;
+	}
+	return y;
+}
+
+static void SkylineAddNode(Skyline* skyline_p, int nodeIdx, int x, int y, int width)
+{
+	assert(skyline_p->nodeCount < MAX_SKYLINE_NODES);
+	memmove(&skyline_p->nodes[nodeIdx + 1], &skyline_p->nodes[nodeIdx], (skyline_p->nodeCount - nodeIdx) * sizeof(SkylineNode));
+	skyline_p->nodes[nodeIdx] = { x, y, width };
+	skyline_p->nodeCount++;
+
+	// Shrink or remove the nodes now covered by the new one.
+	int i = nodeIdx + 1;
+	while (i < skyline_p->nodeCount)
+	{
+		SkylineNode* prev_p = &skyline_p->nodes[i - 1];
+		SkylineNode* node_p = &skyline_p->nodes[i];
+		int overlap = (prev_p->x + prev_p->width) - node_p->x;
+		if (overlap <= 0) break;
+
+		node_p->x += overlap;
+		node_p->width -= overlap;
+		if (node_p->width > 0) break;
+
+		memmove(node_p, node_p + 1, (skyline_p->nodeCount - i - 1) * sizeof(SkylineNode));
+		skyline_p->nodeCount--;
+	}
+
+	// Merge neighbours at the same height.
+	i = 0;
+	while (i < skyline_p->nodeCount - 1)
+	{
+		SkylineNode* node_p = &skyline_p->nodes[i];
+		if (node_p->y == (node_p + 1)->y)
+		{
+			node_p->width += (node_p + 1)->width;
+			memmove(node_p + 1, node_p + 2, (skyline_p->nodeCount - i - 2) * sizeof(SkylineNode));
+			skyline_p->nodeCount--;
+		}
+		else i++;
+	}
+}
+
+// Bottom-left skyline: every rect goes to the position where its top edge ends up lowest.
+static bool SkylineInsert(Skyline* skyline_p, int width, int height, AtlasPlacement* placement_p)
+{
+	int bestIdx = -1;
+	int bestTop = S32_MAX;
+	int bestY = 0;
+	for (int i = 0; i < skyline_p->nodeCount; i++)
+	{
+		int y = SkylineFit(skyline_p, i, width, height);
+		if (y >= 0 && (y + height) < bestTop)
+		{
+			bestIdx = i;
+			bestTop = y + height;
+			bestY = y;
+		}
+	}
+	if (bestIdx < 0) return false;
+
+	placement_p->x = skyline_p->nodes[bestIdx].x;
+	placement_p->y = bestY;
+	SkylineAddNode(skyline_p, bestIdx, placement_p->x, bestY + height, width);
+	return true;
+}
+
+static bool AtlasPack(const Texture textures[], int count, int width, int height, AtlasPlacement placements[])
+{
+	// Insert taller textures first, it packs noticeably tighter.
+	int order[TEXTURES_COUNT];
+	for (int i = 0; i < count; i++) order[i] = i;
+	for (int i = 1; i < count; i++)
+	{
+		int idx = order[i];
+		int j = i - 1;
+		while (j >= 0 && textures[order[j]].height < textures[idx].height) { order[j + 1] = order[j]; j--; }
+		order[j + 1] = idx;
+	}
+
+	Skyline skyline;
+	SkylineInit(&skyline, width, height);
+	for (int i = 0; i < count; i++)
+	{
+		const Texture* texture_p = &textures[order[i]];
+		AtlasPlacement placement;
+		if (!SkylineInsert(&skyline, texture_p->width + ATLAS_PADDING, texture_p->height + ATLAS_PADDING, &placement)) return false;
+		placements[order[i]] = placement;
+	}
+	return true;
+}
+
+static bool AtlasReadCache(const char* cachePath, const Texture textures[], int count, int* width_p, int* height_p, AtlasPlacement placements[])
+{
+	FILE* file = fopen(cachePath, "rb");
+	if (!file) return false;
+
+	bool valid = true;
+	AtlasCacheHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1) valid = false;
+	if (valid) valid = (header.magic == ATLAS_CACHE_MAGIC) && (header.version == ATLAS_CACHE_VERSION) && (header.count == count);
+	if (valid) valid = (header.width > 0) && (header.width <= ATLAS_MAX_SIZE) && (header.height > 0) && (header.height <= ATLAS_MAX_SIZE);
+	for (int i = 0; valid && i < count; i++)
+	{
+		AtlasCacheEntry entry;
+		if (fread(&entry, sizeof(entry), 1, file) != 1) { valid = false; break; }
+		valid = (entry.srcWidth == textures[i].width) && (entry.srcHeight == textures[i].height);
+		// A stale or corrupt placement would make AtlasBlit write past the atlas.
+		valid = valid && (entry.x >= 0) && (entry.y >= 0) &&
+			(entry.x <= header.width - entry.srcWidth) && (entry.y <= header.height - entry.srcHeight);
+		placements[i].x = entry.x;
+		placements[i].y = entry.y;
+	}
+	fclose(file);
+
+	*width_p = header.width;
+	*height_p = header.height;
+	return valid;
+}
+
+static void AtlasWriteCache(const char* cachePath, const Texture textures[], int count, int width, int height, const AtlasPlacement placements[])
+{
+	FILE* file = fopen(cachePath, "wb");
+	if (!file) { printf("WARNING: Could not write atlas cache %s\n", cachePath); return; }
+
+	AtlasCacheHeader header = { ATLAS_CACHE_MAGIC, ATLAS_CACHE_VERSION, width, height, count };
+	fwrite(&header, sizeof(header), 1, file);
+	for (int i = 0; i < count; i++)
+	{
+		AtlasCacheEntry entry = { textures[i].width, textures[i].height, placements[i].x, placements[i].y };
+		fwrite(&entry, sizeof(entry), 1, file);
+	}
+	fclose(file);
+}
+
+static void AtlasBlit(Texture* atlasTexture_p, const Texture* texture_p, AtlasPlacement placement)
+{
+	for (int y = 0; y < texture_p->height; y++)
+	{
+		U8* dst_p = &atlasTexture_p->data_p[((placement.y + y) * atlasTexture_p->width + placement.x) * 4];
+		const U8* src_p = &texture_p->data_p[y * texture_p->width * texture_p->nrChannels];
+		if (texture_p->nrChannels == 4)
+		{
+			memcpy(dst_p, src_p, texture_p->width * 4);
+		}
+		else
+		{
+			assert(texture_p->nrChannels == 3);
+			for (int x = 0; x < texture_p->width; x++)
+			{
+				dst_p[x * 4 + 0] = src_p[x * 3 + 0];
+				dst_p[x * 4 + 1] = src_p[x * 3 + 1];
+				dst_p[x * 4 + 2] = src_p[x * 3 + 2];
+				dst_p[x * 4 + 3] = 0xff;
+			}
+		}
+	}
+}
+
+TextureAtlas AtlasBuild(const Texture textures[], int count, const char* cachePath)
+{
+	assert(count <= TEXTURES_COUNT);
+
+	TextureAtlas atlas = { 0 };
+	atlas.textureCount = count;
+
+	int width = 0;
+	int height = 0;
+	AtlasPlacement placements[TEXTURES_COUNT] = { 0 };
+	if (!AtlasReadCache(cachePath, textures, count, &width, &height, placements))
+	{
+		// Try power of two sizes, a 2:1 rectangle before the square of the same width.
+		bool packed = false;
+		for (int size = 256; !packed && size <= ATLAS_MAX_SIZE; size *= 2)
+		{
+			width = size;
+			height = size / 2;
+			packed = AtlasPack(textures, count, width, height, placements);
+			if (!packed)
+			{
+				height = size;
+				packed = AtlasPack(textures, count, width, height, placements);
+			}
+		}
+		assert(packed);
+		AtlasWriteCache(cachePath, textures, count, width, height, placements);
+	}
+
+	atlas.texture.width = width;
+	atlas.texture.height = height;
+	atlas.texture.nrChannels = 4;
+	atlas.texture.data_p = (U8*)calloc(width * height, 4);
+	for (int i = 0; i < count; i++)
+	{
+		AtlasBlit(&atlas.texture, &textures[i], placements[i]);
+		Vector2 uvPos = V2((float)placements[i].x / width, (float)placements[i].y / height);
+		Vector2 uvSize = V2((float)textures[i].width / width, (float)textures[i].height / height);
+		atlas.uvRects[i] = NewRect(uvPos, uvSize);
+	}
+
+	return atlas;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "common.h"
+#include "rect.h"
+#include "texture.h"
+
+#define ATLAS_PADDING  2    // Transparent pixels between packed textures so linear filtering doesn't bleed.
+#define ATLAS_MAX_SIZE 4096
+
+struct TextureAtlas
+{
+	Texture texture;              // All packed textures as RGBA8 pixels.
+	int textureCount;
+	Rect uvRects[TEXTURES_COUNT]; // Region of each texture inside the atlas, in uv coordinates.
+};
+
+// Packs the textures into a single texture with a skyline packer. The packing result is written to cachePath
+// and reused on later startups as long as the texture dimensions haven't changed.
+TextureAtlas AtlasBuild(const Texture textures[], int count, const char* cachePath);
+
+// Maps a uv rect relative to one of the packed textures into the atlas uv space.
+static inline Rect AtlasRemapUv(Rect atlasUvRect, Rect uvRect)
+{
+	return NewRect(atlasUvRect.pos + Scale(uvRect.pos, atlasUvRect.size), Scale(uvRect.size, atlasUvRect.size));
+}
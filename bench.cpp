@@ -0,0 +1,749 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <glad/glad.h>
+#include <thread>
+#include <chrono>
+#include "bench.h"
+#include "common.h"
+#include "vector.h"
+#include "utils.h"
+#include "timing.h"
+#include "broadphase.h"
+#include "entity.h"
+#include "particles.h"
+#include "renderer.h"
+#include "nullgl.h"
+#include "asteroids.h"
+#include "opengl.h"
+#include "texturestream.h"
+#include "simd.h"
+
+#define BENCH_ARENA_HALFSIZE    3000.0f // Same as the game's outer walls.
+#define BENCH_ARENA_ASTEROIDS   100     // Asteroid count the arena above is scaled from.
+#define BENCH_MIN_SECONDS       0.25
+#define BENCH_ENTITIES          10000
+#define BENCH_ENTITY_SLOTS      16384   // Slots the live entities are scattered over, like the game's fixed arrays.
+#define BENCH_DELTAT            (1.0f / 120.0f)
+#define BENCH_PARTICLES         100000
+#define BENCH_PARTICLE_LIFETIME 2.0f
+#define BENCH_LABELS            5000
+#define BENCH_LABELS_PER_FLUSH  250     // Keeps the text group under MAX_TEXT_QUADS.
+#define BENCH_LABEL_LENGTH      32
+#define BENCH_QUADS             10000
+#define BENCH_QUADS_PER_FLUSH   2000    // Keeps the wireframe and text groups under their max quads.
+#define BENCH_QUAD_TEXT         "0123456789"
+#define BENCH_TEXTURE_FRAMES    180
+#define BENCH_TEXTURE_INTERVAL  20      // Frames between two texture loads.
+#define BENCH_FRAME_SECONDS     (1.0 / 60.0)
+#define BENCH_SIMD_MAX          100000
+#define BENCH_SIMD_SLOTS        ENTITY_INVALID // Entity kernels index slots with an EntityId, so they top out here.
+
+struct BenchCircle
+{
+	Vector2 pos;
+	float radius;
+};
+
+// The entity layout from before the SoA store, kept as the baseline for the entities benchmark.
+struct BenchAosEntity
+{
+	U32 type;
+	bool enabled;
+	double tEnabled;
+	double tInvisibility;
+	double tTakingDamage;
+	float size;
+	Vector2 pos;
+	Vector2 facingV;
+	Vector2 vel;
+	float rotSpeed;
+	float colliderRadius;
+	float health;
+	Vector2 prevPos;
+	Vector2 prevFacingV;
+	bool interpolate;
+	union
+	{
+		struct { double tNextMove; int nextAngle; int prevAngle; };
+		struct { double tRespawn; };
+	} e;
+	U32 textureHandle;
+	float uv[4];
+};
+
+// Evaluates _EXPR until BENCH_MIN_SECONDS have passed, returns the average ms per run.
+#define BENCH_TIME(_MS, _RESULT, _EXPR)                     \
+	do {                                                    \
+		int runs = 0;                                       \
+		double tStart = GetTime();                          \
+		double tNow = tStart;                               \
+		do { _RESULT = (_EXPR); runs++; tNow = GetTime(); } \
+		while (tNow - tStart < BENCH_MIN_SECONDS);          \
+		_MS = 1000.0 * (tNow - tStart) / runs;              \
+	} while (0)
+
+static U64 BruteForcePairs(const BenchCircle* circles_p, int count, U64* tests_p)
+{
+	U64 overlaps = 0;
+	U64 tests = 0;
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = i + 1; j < count; j++)
+		{
+			float dist = circles_p[i].radius + circles_p[j].radius;
+			tests++;
+			if (MagnitudeSq(circles_p[i].pos - circles_p[j].pos) <= dist * dist) overlaps++;
+		}
+	}
+	*tests_p = tests;
+	return overlaps;
+}
+
+static U64 BroadphasePairs(Broadphase* broadphase_p, const BenchCircle* circles_p, int count, U64* tests_p)
+{
+	BroadphaseClear(broadphase_p);
+	for (int i = 0; i < count; i++)
+	{
+		BroadphaseAdd(broadphase_p, circles_p[i].pos, circles_p[i].radius, 1, 1);
+	}
+	BroadphaseFindPairs(broadphase_p);
+
+	U64 overlaps = 0;
+	for (U32 i = 0; i < broadphase_p->pairCount; i++)
+	{
+		const BenchCircle* a_p = &circles_p[broadphase_p->pairs_p[i].a];
+		const BenchCircle* b_p = &circles_p[broadphase_p->pairs_p[i].b];
+		float dist = a_p->radius + b_p->radius;
+		if (MagnitudeSq(a_p->pos - b_p->pos) <= dist * dist) overlaps++;
+	}
+	*tests_p = broadphase_p->pairCount;
+	return overlaps;
+}
+
+// Asteroids spread at the density of a full level, the arena grows with the count.
+static void BenchBroadphase()
+{
+	static const int counts[] = { 100, 1000, 10000 };
+
+	printf("Broadphase: asteroid radius %.0f-%.0f, cell size %d\n", 0.35f * ASTEROID_SIZE_MIN, 0.35f * ASTEROID_SIZE_MAX, ASTEROID_SIZE_MAX);
+	printf("%8s %8s %12s %12s %9s %12s %12s\n", "count", "arena", "all pairs", "grid pairs", "overlaps", "all ms", "grid ms");
+	for (int c = 0; c < (int)ARRAY_COUNT(counts); c++)
+	{
+		int count = counts[c];
+		float halfSize = BENCH_ARENA_HALFSIZE * sqrtf((float)count / BENCH_ARENA_ASTEROIDS);
+
+		srand(1);
+		BenchCircle* circles_p = (BenchCircle*)malloc(count * sizeof(BenchCircle));
+		for (int i = 0; i < count; i++)
+		{
+			circles_p[i].pos = V2((2 * GetRandomFloat01() - 1) * halfSize, (2 * GetRandomFloat01() - 1) * halfSize);
+			circles_p[i].radius = 0.7f * (GetRandomValue(ASTEROID_SIZE_MIN, ASTEROID_SIZE_MAX) / 2);
+		}
+
+		Broadphase broadphase;
+		BroadphaseInit(&broadphase, count, ASTEROID_SIZE_MAX);
+
+		U64 bruteTests = 0, gridTests = 0;
+		U64 bruteOverlaps = 0, gridOverlaps = 0;
+		double bruteMs = 0, gridMs = 0;
+		BENCH_TIME(bruteMs, bruteOverlaps, BruteForcePairs(circles_p, count, &bruteTests));
+		BENCH_TIME(gridMs, gridOverlaps, BroadphasePairs(&broadphase, circles_p, count, &gridTests));
+		if (bruteOverlaps != gridOverlaps) printf("ERROR: Broadphase found %llu overlaps, expected %llu\n", (unsigned long long)gridOverlaps, (unsigned long long)bruteOverlaps);
+
+		printf("%8d %8.0f %12llu %12llu %9llu %12.4f %12.4f\n", count, 2 * halfSize,
+			(unsigned long long)bruteTests, (unsigned long long)gridTests, (unsigned long long)gridOverlaps, bruteMs, gridMs);
+
+		BroadphaseFree(&broadphase);
+		free(circles_p);
+	}
+}
+
+static U64 NarrowPhase(Broadphase* broadphase_p)
+{
+	U64 overlaps = 0;
+	for (U32 i = 0; i < broadphase_p->pairCount; i++)
+	{
+		const BroadphaseEntry* a_p = &broadphase_p->entries_p[broadphase_p->pairs_p[i].a];
+		const BroadphaseEntry* b_p = &broadphase_p->entries_p[broadphase_p->pairs_p[i].b];
+		float dist = a_p->radius + b_p->radius;
+		if (MagnitudeSq(a_p->pos - b_p->pos) <= dist * dist) overlaps++;
+	}
+	return overlaps;
+}
+
+// Integrate the way the game did with one struct per entity: every slot is visited and its enabled flag
+// checked, the collision set is a list of pointers back into the structs.
+static int AosIntegrate(BenchAosEntity* entities_p, BenchAosEntity** collisions_p)
+{
+	int collisionCount = 0;
+	for (int i = 0; i < BENCH_ENTITY_SLOTS; i++)
+	{
+		BenchAosEntity* entity_p = &entities_p[i];
+		if (entity_p->enabled)
+		{
+			entity_p->prevPos = entity_p->pos;
+			entity_p->prevFacingV = entity_p->facingV;
+			entity_p->facingV = RotateDeg(entity_p->facingV, entity_p->rotSpeed * BENCH_DELTAT);
+			entity_p->pos += BENCH_DELTAT * entity_p->vel;
+			collisions_p[collisionCount++] = entity_p;
+		}
+	}
+	return collisionCount;
+}
+
+static U64 AosStep(BenchAosEntity* entities_p, BenchAosEntity** collisions_p, Broadphase* broadphase_p)
+{
+	int collisionCount = AosIntegrate(entities_p, collisions_p);
+
+	BroadphaseClear(broadphase_p);
+	for (int i = 0; i < collisionCount; i++)
+	{
+		BroadphaseAdd(broadphase_p, collisions_p[i]->pos, collisions_p[i]->colliderRadius, 1, 1);
+	}
+	BroadphaseFindPairs(broadphase_p);
+	return NarrowPhase(broadphase_p);
+}
+
+static int SoaIntegrate(EntityStore* store_p)
+{
+	const EntityList* list_p = &store_p->lists_p[0];
+	EntitiesSavePrevState(store_p);
+	EntitiesRotate(store_p, list_p, BENCH_DELTAT);
+	EntitiesIntegrate(store_p, list_p, BENCH_DELTAT);
+	return list_p->count;
+}
+
+static U64 SoaStep(EntityStore* store_p, Broadphase* broadphase_p)
+{
+	const EntityList* list_p = &store_p->lists_p[0];
+	SoaIntegrate(store_p);
+
+	BroadphaseClear(broadphase_p);
+	for (int i = 0; i < list_p->count; i++)
+	{
+		EntityId id = list_p->ids_p[i];
+		BroadphaseAdd(broadphase_p, store_p->pos_p[id], store_p->colliderRadius_p[id], 1, 1);
+	}
+	BroadphaseFindPairs(broadphase_p);
+	return NarrowPhase(broadphase_p);
+}
+
+// Asteroid-like entities, live ones scattered over the slots. Both layouts start from the same state.
+static void BenchEntities()
+{
+	float halfSize = BENCH_ARENA_HALFSIZE * sqrtf((float)BENCH_ENTITIES / BENCH_ARENA_ASTEROIDS);
+
+	BenchAosEntity* aos_p = (BenchAosEntity*)calloc(BENCH_ENTITY_SLOTS, sizeof(BenchAosEntity));
+	BenchAosEntity** collisions_p = (BenchAosEntity**)malloc(BENCH_ENTITY_SLOTS * sizeof(BenchAosEntity*));
+	EntityStore store;
+	EntityStoreInit(&store, BENCH_ENTITY_SLOTS, 1);
+
+	srand(1);
+	for (int i = 0; i < BENCH_ENTITY_SLOTS; i++)
+	{
+		BenchAosEntity* entity_p = &aos_p[i];
+		entity_p->size = (float)GetRandomValue(ASTEROID_SIZE_MIN, ASTEROID_SIZE_MAX);
+		entity_p->colliderRadius = 0.7f * (entity_p->size / 2);
+		entity_p->pos = V2((2 * GetRandomFloat01() - 1) * halfSize, (2 * GetRandomFloat01() - 1) * halfSize);
+		entity_p->vel = (float)GetRandomValue(50, 60) * RotateDeg(VECTOR2_UP, (float)GetRandomValue(0, 360));
+		entity_p->facingV = VECTOR2_UP;
+		entity_p->rotSpeed = (float)GetRandomValue(10, 20);
+
+		EntityId id = EntityCreate(&store, 0);
+		store.pos_p[id] = entity_p->pos;
+		store.vel_p[id] = entity_p->vel;
+		store.facingV_p[id] = entity_p->facingV;
+		store.rotSpeed_p[id] = entity_p->rotSpeed;
+		store.colliderRadius_p[id] = entity_p->colliderRadius;
+	}
+	for (int live = 0; live < BENCH_ENTITIES;)
+	{
+		int i = GetRandomValue(0, BENCH_ENTITY_SLOTS - 1);
+		if (aos_p[i].enabled) continue;
+		aos_p[i].enabled = true;
+		EntitySpawn(&store, (EntityId)i);
+		live++;
+	}
+
+	Broadphase broadphase;
+	BroadphaseInit(&broadphase, BENCH_ENTITY_SLOTS, ASTEROID_SIZE_MAX);
+
+	int aosLive = 0, soaLive = 0;
+	U64 aosOverlaps = 0, soaOverlaps = 0;
+	double aosIntegrateMs = 0, soaIntegrateMs = 0;
+	double aosMs = 0, soaMs = 0;
+	aosOverlaps = AosStep(aos_p, collisions_p, &broadphase);
+	soaOverlaps = SoaStep(&store, &broadphase);
+	if (aosOverlaps != soaOverlaps) printf("ERROR: SoA step found %llu overlaps, AoS %llu\n", (unsigned long long)soaOverlaps, (unsigned long long)aosOverlaps);
+	BENCH_TIME(aosIntegrateMs, aosLive, AosIntegrate(aos_p, collisions_p));
+	BENCH_TIME(soaIntegrateMs, soaLive, SoaIntegrate(&store));
+	if (aosLive != soaLive) printf("ERROR: SoA integrated %d entities, AoS %d\n", soaLive, aosLive);
+	BENCH_TIME(aosMs, aosOverlaps, AosStep(aos_p, collisions_p, &broadphase));
+	BENCH_TIME(soaMs, soaOverlaps, SoaStep(&store, &broadphase));
+
+	printf("Entities: %d live in %d slots, ms per tick\n", BENCH_ENTITIES, BENCH_ENTITY_SLOTS);
+	printf("%-36s %12s %18s\n", "", "integrate", "integrate+collide");
+	printf("%-36s %12.4f %18.4f\n", "AoS, enabled flags (before)", aosIntegrateMs, aosMs);
+	printf("%-36s %12.4f %18.4f\n", "SoA, live lists (after)", soaIntegrateMs, soaMs);
+	printf("  AoS entity %d bytes, %llu overlapping pairs\n", (int)sizeof(BenchAosEntity), (unsigned long long)soaOverlaps);
+
+	BroadphaseFree(&broadphase);
+	EntityStoreFree(&store);
+	free(collisions_p);
+	free(aos_p);
+}
+
+static int ParticlesStep(ParticleSystem* system_p, int emitter)
+{
+	ParticlesEmit(system_p, emitter, VECTOR2_ZERO, VECTOR2_UP, BENCH_DELTAT);
+	ParticlesUpdate(system_p, BENCH_DELTAT);
+	return system_p->count;
+}
+
+static U32 ParticlesFill(const ParticleSystem* system_p, Renderer* renderer_p)
+{
+	ParticlesRender(system_p, renderer_p);
+	U32 count = renderer_p->renderGroups[0].renderCommands.instanceCount;
+	renderer_p->renderGroups[0].renderCommands.instanceCount = 0;
+	return count;
+}
+
+// A fountain emitting at the rate that keeps BENCH_PARTICLES alive, timed once it reached steady state.
+static void BenchParticles()
+{
+	ParticleSystem system;
+	ParticlesInit(&system, PARTICLES_MAX);
+	ParticleEmitter fountain = { BENCH_PARTICLES / BENCH_PARTICLE_LIFETIME, BENCH_PARTICLE_LIFETIME, 20.0f, 80.0f, 360.0f, 10.0f, 2.0f, COLOR_WHITE, Col(1.0f, 1.0f, 1.0f, 0.0f) };
+	int emitter = ParticlesAddEmitter(&system, &fountain);
+
+	// Only the particle group, nothing else of the renderer is touched and no GL context is needed.
+	Renderer* renderer_p = (Renderer*)calloc(1, sizeof(Renderer));
+	renderer_p->groupCnt = 1;
+	renderer_p->renderGroups[0].renderGroupType = RENDER_GROUP_PARTICLES;
+	renderer_p->renderGroups[0].renderCommands.maxInstanceCount = PARTICLES_MAX;
+	renderer_p->renderGroups[0].renderCommands.particleArray = (ParticleInstance*)malloc(PARTICLES_MAX * sizeof(ParticleInstance));
+
+	srand(1);
+	int live = 0;
+	for (int i = 0; i < (int)(1.5f * BENCH_PARTICLE_LIFETIME / BENCH_DELTAT); i++) live = ParticlesStep(&system, emitter);
+
+	U32 drawn = 0;
+	double stepMs = 0, fillMs = 0;
+	BENCH_TIME(stepMs, live, ParticlesStep(&system, emitter));
+	BENCH_TIME(fillMs, drawn, ParticlesFill(&system, renderer_p));
+
+	// A rendered frame at 60 Hz runs two 120 Hz simulation ticks.
+	printf("Particles: %d live, %d bytes per particle, %d bytes per instance\n", live,
+		(int)(6 * sizeof(float) + sizeof(U8)), (int)sizeof(ParticleInstance));
+	printf("  emit+update %.4f ms/tick, instance fill %.4f ms/frame, %.4f ms per 60 Hz frame (%u instances, 1 draw)\n",
+		stepMs, fillMs, 2 * stepMs + fillMs, drawn);
+
+	free(renderer_p->renderGroups[0].renderCommands.particleArray);
+	free(renderer_p);
+	ParticlesFree(&system);
+}
+
+// Every label is measured and then pushed centered, like UILabel does.
+static U64 PushLabels(Renderer* renderer_p, const char* labels_p, int labelCount)
+{
+	U64 quads = 0;
+	for (int i = 0; i < BENCH_LABELS; i++)
+	{
+		const char* label = &labels_p[(i % labelCount) * BENCH_LABEL_LENGTH];
+		float width = GetTextWidth(renderer_p, label);
+		PushText(renderer_p, label, V2(-0.5f * width, 0.0f), COLOR_WHITE);
+		if ((i + 1) % BENCH_LABELS_PER_FLUSH == 0 || i == BENCH_LABELS - 1)
+		{
+			for (int g = 0; g < renderer_p->groupCnt; g++) quads += renderer_p->renderGroups[g].renderCommands.indexCount / 6;
+			RendererEndFrame(renderer_p);
+		}
+	}
+	return quads;
+}
+
+// HUD-like labels: a few hundred distinct strings repeated over the frame, then every label distinct.
+static void BenchText()
+{
+	// The renderer needs a GL context for its shaders, the null backend is enough.
+	if (!gladLoadGLLoader((GLADloadproc)NullGLGetProcAddress)) { printf("ERROR: Failed to load the null GL backend\n"); return; }
+	Renderer* renderer_p = (Renderer*)malloc(sizeof(Renderer));
+	RendererInit(renderer_p);
+
+	static const int distinctCounts[] = { 200, BENCH_LABELS };
+	char* labels_p = (char*)malloc(BENCH_LABELS * BENCH_LABEL_LENGTH);
+	for (int i = 0; i < BENCH_LABELS; i++) snprintf(&labels_p[i * BENCH_LABEL_LENGTH], BENCH_LABEL_LENGTH, "Score: %d", 1000 + 37 * i);
+
+	printf("Text: %d labels per frame, layout cache of %d runs, ms per frame\n", BENCH_LABELS, TEXT_LAYOUT_CACHE_SIZE);
+	printf("%10s %12s %12s %10s %10s\n", "distinct", "uncached", "cached", "hit rate", "quads");
+	for (int c = 0; c < (int)ARRAY_COUNT(distinctCounts); c++)
+	{
+		TextLayoutCache* cache_p = &renderer_p->textRendering.layoutCache;
+		U64 uncachedQuads = 0, cachedQuads = 0;
+		double uncachedMs = 0, cachedMs = 0;
+
+		renderer_p->textRendering.useLayoutCache = false;
+		BENCH_TIME(uncachedMs, uncachedQuads, PushLabels(renderer_p, labels_p, distinctCounts[c]));
+
+		renderer_p->textRendering.useLayoutCache = true;
+		TextLayoutCacheFree(cache_p);
+		TextLayoutCacheInit(cache_p, TEXT_LAYOUT_CACHE_SIZE);
+		BENCH_TIME(cachedMs, cachedQuads, PushLabels(renderer_p, labels_p, distinctCounts[c]));
+		if (uncachedQuads != cachedQuads) printf("ERROR: Cached text pushed %llu quads, expected %llu\n", (unsigned long long)cachedQuads, (unsigned long long)uncachedQuads);
+
+		double lookups = (double)(cache_p->stats.hits + cache_p->stats.misses + cache_p->stats.skipped);
+		printf("%10d %12.4f %12.4f %9.1f%% %10llu\n", distinctCounts[c], uncachedMs, cachedMs,
+			lookups > 0 ? 100.0 * cache_p->stats.hits / lookups : 0.0, (unsigned long long)cachedQuads);
+	}
+
+	free(labels_p);
+}
+
+static RenderCommands* BenchGroupCommands(Renderer* renderer_p, RenderGroupTypeE renderGroupType)
+{
+	for (int g = 0; g < renderer_p->groupCnt; g++)
+	{
+		if (renderer_p->renderGroups[g].renderGroupType == renderGroupType) return &renderer_p->renderGroups[g].renderCommands;
+	}
+	return nullptr;
+}
+
+// BENCH_QUADS quads into one group, returns the bytes the backend would upload for them.
+static U64 PushQuads(Renderer* renderer_p, RenderGroupTypeE renderGroupType)
+{
+	RenderCommands* renderCmds_p = BenchGroupCommands(renderer_p, renderGroupType);
+	U64 bytes = 0;
+	for (int i = 0; i < BENCH_QUADS; )
+	{
+		Vector2 pos = V2((float)(i % 100), (float)(i / 100));
+		switch (renderGroupType)
+		{
+		case RENDER_GROUP_WIREFRAME:       PushRect(renderer_p, NewRect(pos, V2(0.5f, 0.5f)), COLOR_WHITE); i++; break;
+		case RENDER_GROUP_TEXT_DEFAULT:    PushText(renderer_p, BENCH_QUAD_TEXT, pos, COLOR_WHITE); i += sizeof(BENCH_QUAD_TEXT) - 1; break;
+		case RENDER_GROUP_SPRITES_DEFAULT: PushSprite(renderer_p, pos, V2(0.5f, 0.5f), VECTOR2_UP, 0); i++; break;
+		default: return 0;
+		}
+
+		U32 quads = renderCmds_p->maxInstanceCount ? renderCmds_p->instanceCount : renderCmds_p->indexCount / 6;
+		if (quads >= BENCH_QUADS_PER_FLUSH || i >= BENCH_QUADS)
+		{
+			bytes += renderCmds_p->vertexCount * RenderVertexSize(renderCmds_p) + renderCmds_p->indexCount * sizeof(U16);
+			bytes += renderCmds_p->instanceCount * sizeof(SpriteInstance);
+			RendererEndFrame(renderer_p);
+		}
+	}
+	return bytes;
+}
+
+// What the backend streams per frame for BENCH_QUADS quads in each layout, sprites are instanced for comparison.
+static void BenchVertices()
+{
+	// The renderer needs a GL context for its shaders, the null backend is enough.
+	if (!gladLoadGLLoader((GLADloadproc)NullGLGetProcAddress)) { printf("ERROR: Failed to load the null GL backend\n"); return; }
+	Renderer* renderer_p = (Renderer*)malloc(sizeof(Renderer));
+	RendererInit(renderer_p);
+
+	static const RenderGroupTypeE groups[] = { RENDER_GROUP_WIREFRAME, RENDER_GROUP_TEXT_DEFAULT };
+	static const VertexLayoutE layouts[] = { VERTEX_LAYOUT_FLOAT, VERTEX_LAYOUT_PACKED };
+	static const char* layoutNames[] = { "float", "packed" };
+
+	printf("Vertices: %d quads per frame, bytes streamed (vertices + indices) and ms per frame\n", BENCH_QUADS);
+	printf("%10s %10s %10s %12s %10s\n", "group", "layout", "vertex B", "bytes", "push ms");
+	for (int g = 0; g < (int)ARRAY_COUNT(groups); g++)
+	{
+		for (int l = 0; l < (int)ARRAY_COUNT(layouts); l++)
+		{
+			RendererSetVertexLayout(renderer_p, groups[g], layouts[l]);
+			U64 bytes = 0;
+			double pushMs = 0;
+			BENCH_TIME(pushMs, bytes, PushQuads(renderer_p, groups[g]));
+			printf("%10s %10s %10u %12llu %10.4f\n", RenderGroupName(groups[g]), layoutNames[l],
+				RenderVertexSize(BenchGroupCommands(renderer_p, groups[g])), (unsigned long long)bytes, pushMs);
+		}
+	}
+
+	U64 spriteBytes = 0;
+	double spriteMs = 0;
+	BENCH_TIME(spriteMs, spriteBytes, PushQuads(renderer_p, RENDER_GROUP_SPRITES_DEFAULT));
+	printf("%10s %10s %10d %12llu %10.4f\n", RenderGroupName(RENDER_GROUP_SPRITES_DEFAULT), "instanced", (int)sizeof(SpriteInstance), (unsigned long long)spriteBytes, spriteMs);
+}
+
+// Large textures, as sprite sheets and level backgrounds would be.
+static const char* const benchTexturePaths[] =
+{
+	"../assets/textures/spacecraft.png",
+	"../assets/textures/triangle-41361.png",
+	"../assets/textures/ExplosionBig.png",
+	"../assets/textures/Explosion5.png",
+	"../assets/textures/Asteroids.png",
+};
+
+// One sprite per texture, drawn with the placeholder until the texture is there. Returns the frame's ms.
+static double BenchTextureFrame(OpenGL* openGl_p, Renderer* renderer_p, double tFrameStart)
+{
+	for (int t = 0; t < (int)ARRAY_COUNT(benchTexturePaths); t++)
+	{
+		PushSprite(renderer_p, V2(100.0f * t, 0.0f), V2(100.0f, 100.0f), VECTOR2_UP, (TextureHandleT)(TEXTURE_STREAMED_FIRST + t));
+	}
+	RendererSortAndBatch(renderer_p);
+	OpenGLEndFrame(openGl_p, RendererSwapFrame(renderer_p, (renderer_p->buildFrame + 1) % RENDER_FRAME_COUNT, true));
+	double ms = 1000.0 * (GetTime() - tFrameStart);
+
+	// Paced like the game, so the loader has time to work between frames.
+	double tNext = tFrameStart + BENCH_FRAME_SECONDS;
+	while (GetTime() < tNext) std::this_thread::sleep_for(std::chrono::microseconds(200));
+	return ms;
+}
+
+// Frame times while textures arrive mid game: decoded and uploaded inside the frame, or streamed.
+static void BenchTextures()
+{
+	GLADloadproc loadProc = (GLADloadproc)NullGLGetProcAddress;
+	if (!gladLoadGLLoader(loadProc)) { printf("ERROR: Failed to load the null GL backend\n"); return; }
+	OpenGL* openGl_p = (OpenGL*)malloc(sizeof(OpenGL));
+	OpenGLInit(openGl_p, loadProc);
+	Renderer* renderer_p = (Renderer*)malloc(sizeof(Renderer));
+	RendererInit(renderer_p);
+
+	const int textureCount = (int)ARRAY_COUNT(benchTexturePaths);
+	printf("Textures: %d textures %d frames apart, %d frames at 60 Hz\n", textureCount, BENCH_TEXTURE_INTERVAL, BENCH_TEXTURE_FRAMES);
+	printf("%10s %10s %10s %14s\n", "upload", "mean ms", "worst ms", "to resident ms");
+
+	double totalMs = 0;
+	double worstMs = 0;
+	for (int f = 0; f < BENCH_TEXTURE_FRAMES; f++)
+	{
+		double tStart = GetTime();
+		int t = f / BENCH_TEXTURE_INTERVAL;
+		if (f % BENCH_TEXTURE_INTERVAL == 0 && t < textureCount)
+		{
+			Texture texture = LoadTexture(benchTexturePaths[t]);
+			OpenGLUploadTexture(openGl_p, (TextureHandleT)(TEXTURE_STREAMED_FIRST + t), &texture);
+			FreeTexture(&texture);
+		}
+		double ms = BenchTextureFrame(openGl_p, renderer_p, tStart);
+		totalMs += ms;
+		worstMs = fmax(worstMs, ms);
+	}
+	printf("%10s %10.4f %10.4f %14s\n", "in frame", totalMs / BENCH_TEXTURE_FRAMES, worstMs, "-");
+	memset(&openGl_p->textures[TEXTURE_STREAMED_FIRST], 0, textureCount * sizeof(GLuint));
+
+	static TextureStream stream;
+	TextureStreamStart(&stream);
+	OpenGLSetTextureStream(openGl_p, &stream);
+	totalMs = 0;
+	worstMs = 0;
+	for (int f = 0; f < BENCH_TEXTURE_FRAMES; f++)
+	{
+		double tStart = GetTime();
+		int t = f / BENCH_TEXTURE_INTERVAL;
+		if (f % BENCH_TEXTURE_INTERVAL == 0 && t < textureCount) TextureStreamRequest(&stream, benchTexturePaths[t]);
+		double ms = BenchTextureFrame(openGl_p, renderer_p, tStart);
+		totalMs += ms;
+		worstMs = fmax(worstMs, ms);
+	}
+	const TextureStreamStats* stats_p = &stream.stats;
+	if (stats_p->resident != (U32)textureCount) printf("ERROR: %u of %d streamed textures resident\n", stats_p->resident, textureCount);
+	printf("%10s %10.4f %10.4f %14.2f\n", "streamed", totalMs / BENCH_TEXTURE_FRAMES, worstMs, stats_p->resident ? 1000.0 * stats_p->residentSeconds / stats_p->resident : 0.0);
+	OpenGLSetTextureStream(openGl_p, nullptr);
+	TextureStreamStop(&stream);
+}
+
+enum BenchSimdKernelE
+{
+	BENCH_SIMD_MULADD,
+	BENCH_SIMD_INTEGRATE,
+	BENCH_SIMD_ROTATE,
+	BENCH_SIMD_EXPIRED,
+	BENCH_SIMD_ATLEAST,
+	BENCH_SIMD_KERNEL_COUNT,
+};
+
+static const char* const benchSimdKernelNames[BENCH_SIMD_KERNEL_COUNT] = { "mulAdd", "integrateIds", "rotateIds", "expiredIds", "atLeast" };
+static const int benchSimdCounts[] = { 1000, 10000, BENCH_SIMD_MAX };
+
+struct BenchSimdData
+{
+	float* values_p;   // Particle like arrays.
+	float* rates_p;
+	Vector2* pos_p;    // Entity like arrays, BENCH_SIMD_SLOTS each.
+	Vector2* vel_p;
+	Vector2* facingV_p;
+	float* rotSpeed_p;
+	double* tEnabled_p;
+	EntityId* ids_p;   // Every slot once, shuffled, so any prefix is scattered like a live list.
+	U32* mask_p;
+};
+
+// Rotation speeds large enough that the angles cover the whole circle.
+static void BenchSimdReset(BenchSimdData* data_p)
+{
+	srand(1);
+	for (int i = 0; i < BENCH_SIMD_MAX; i++)
+	{
+		data_p->values_p[i] = GetRandomFloat01();
+		data_p->rates_p[i] = 2 * GetRandomFloat01();
+	}
+	for (int i = 0; i < BENCH_SIMD_SLOTS; i++)
+	{
+		data_p->pos_p[i] = V2((2 * GetRandomFloat01() - 1) * BENCH_ARENA_HALFSIZE, (2 * GetRandomFloat01() - 1) * BENCH_ARENA_HALFSIZE);
+		data_p->vel_p[i] = (float)GetRandomValue(50, 600) * RotateDeg(VECTOR2_UP, (float)GetRandomValue(0, 360));
+		data_p->facingV_p[i] = RotateDeg(VECTOR2_UP, (float)GetRandomValue(0, 360));
+		data_p->rotSpeed_p[i] = (float)GetRandomValue(-20000, 20000);
+		data_p->tEnabled_p[i] = 2 * GetRandomFloat01();
+		data_p->ids_p[i] = (EntityId)i;
+	}
+	for (int i = BENCH_SIMD_SLOTS - 1; i > 0; i--)
+	{
+		int j = GetRandomValue(0, i);
+		EntityId id = data_p->ids_p[i];
+		data_p->ids_p[i] = data_p->ids_p[j];
+		data_p->ids_p[j] = id;
+	}
+}
+
+static int BenchSimdCount(int kernel, int count)
+{
+	bool indexed = kernel == BENCH_SIMD_INTEGRATE || kernel == BENCH_SIMD_ROTATE || kernel == BENCH_SIMD_EXPIRED;
+	return (indexed && count > BENCH_SIMD_SLOTS) ? BENCH_SIMD_SLOTS : count;
+}
+
+static int RunSimdKernel(const SimdKernels* kernels_p, int kernel, BenchSimdData* data_p, int count)
+{
+	count = BenchSimdCount(kernel, count);
+	switch (kernel)
+	{
+	case BENCH_SIMD_MULADD:    kernels_p->mulAdd(data_p->values_p, data_p->rates_p, count, BENCH_DELTAT); break;
+	case BENCH_SIMD_INTEGRATE: kernels_p->integrateIds(data_p->pos_p, data_p->vel_p, data_p->ids_p, count, BENCH_DELTAT); break;
+	case BENCH_SIMD_ROTATE:    kernels_p->rotateIds(data_p->facingV_p, data_p->rotSpeed_p, data_p->ids_p, count, BENCH_DELTAT); break;
+	case BENCH_SIMD_EXPIRED:   kernels_p->expiredIds(data_p->tEnabled_p, data_p->ids_p, count, 2.0, 1.0, data_p->mask_p); break;
+	case BENCH_SIMD_ATLEAST:   kernels_p->atLeast(data_p->rates_p, count, 1.0f, data_p->mask_p); break;
+	}
+	return count;
+}
+
+static float MaxDifference(const float* a_p, const float* b_p, int count)
+{
+	float maxDiff = 0;
+	for (int i = 0; i < count; i++) maxDiff = fmaxf(maxDiff, fabsf(a_p[i] - b_p[i]));
+	return maxDiff;
+}
+
+// Every level runs every kernel once from the same state, the results are compared against the scalar ones.
+static void BenchSimdVerify(BenchSimdData* data_p, BenchSimdData* reference_p, SimdLevelE maxLevel)
+{
+	for (int level = SIMD_SCALAR; level <= maxLevel; level++)
+	{
+		const SimdKernels* kernels_p = SimdGetKernels((SimdLevelE)level);
+		BenchSimdReset(data_p);
+		float maxDiff = 0;
+		int maskErrors = 0;
+		for (int kernel = 0; kernel < BENCH_SIMD_KERNEL_COUNT; kernel++)
+		{
+			int count = RunSimdKernel(kernels_p, kernel, data_p, BENCH_SIMD_MAX);
+			bool masked = kernel == BENCH_SIMD_EXPIRED || kernel == BENCH_SIMD_ATLEAST;
+			U32* mask_p = reference_p->mask_p + kernel * SIMD_MASK_WORDS(BENCH_SIMD_MAX);
+			if (level == SIMD_SCALAR && masked) memcpy(mask_p, data_p->mask_p, SIMD_MASK_WORDS(count) * sizeof(U32));
+			else if (masked) maskErrors += memcmp(mask_p, data_p->mask_p, SIMD_MASK_WORDS(count) * sizeof(U32)) != 0;
+		}
+
+		if (level == SIMD_SCALAR)
+		{
+			memcpy(reference_p->values_p, data_p->values_p, BENCH_SIMD_MAX * sizeof(float));
+			memcpy(reference_p->pos_p, data_p->pos_p, BENCH_SIMD_SLOTS * sizeof(Vector2));
+			memcpy(reference_p->facingV_p, data_p->facingV_p, BENCH_SIMD_SLOTS * sizeof(Vector2));
+			continue;
+		}
+		maxDiff = fmaxf(maxDiff, MaxDifference(reference_p->values_p, data_p->values_p, BENCH_SIMD_MAX));
+		maxDiff = fmaxf(maxDiff, MaxDifference(&reference_p->pos_p[0].x, &data_p->pos_p[0].x, 2 * BENCH_SIMD_SLOTS));
+		maxDiff = fmaxf(maxDiff, MaxDifference(&reference_p->facingV_p[0].x, &data_p->facingV_p[0].x, 2 * BENCH_SIMD_SLOTS));
+		if (maxDiff > 1e-5f || maskErrors) printf("ERROR: %s kernels differ from scalar, max difference %g, %d masks wrong\n", SimdLevelName((SimdLevelE)level), maxDiff, maskErrors);
+		else printf("  %s matches scalar, max difference %g\n", SimdLevelName((SimdLevelE)level), maxDiff);
+	}
+
+	// The polynomial against the C library, RotateDeg is what the game rotated with before.
+	BenchSimdReset(data_p);
+	memcpy(reference_p->facingV_p, data_p->facingV_p, BENCH_SIMD_SLOTS * sizeof(Vector2));
+	RunSimdKernel(SimdGetKernels(SIMD_SCALAR), BENCH_SIMD_ROTATE, data_p, BENCH_SIMD_SLOTS);
+	float maxDiff = 0;
+	for (int i = 0; i < BENCH_SIMD_SLOTS; i++)
+	{
+		Vector2 expected = RotateDeg(reference_p->facingV_p[i], data_p->rotSpeed_p[i] * BENCH_DELTAT);
+		maxDiff = fmaxf(maxDiff, fmaxf(fabsf(expected.x - data_p->facingV_p[i].x), fabsf(expected.y - data_p->facingV_p[i].y)));
+	}
+	printf("  rotation polynomial vs sinf/cosf, max difference %g\n", maxDiff);
+}
+
+// Kernels of every level the CPU runs at growing counts, entity kernels through shuffled slot ids.
+static void BenchSimd()
+{
+	SimdLevelE maxLevel = SimdMaxLevel();
+	BenchSimdData data = { 0 };
+	BenchSimdData reference = { 0 };
+	BenchSimdData* both[] = { &data, &reference };
+	for (int i = 0; i < 2; i++)
+	{
+		both[i]->values_p = (float*)malloc(BENCH_SIMD_MAX * sizeof(float));
+		both[i]->rates_p = (float*)malloc(BENCH_SIMD_MAX * sizeof(float));
+		both[i]->pos_p = (Vector2*)malloc(BENCH_SIMD_SLOTS * sizeof(Vector2));
+		both[i]->vel_p = (Vector2*)malloc(BENCH_SIMD_SLOTS * sizeof(Vector2));
+		both[i]->facingV_p = (Vector2*)malloc(BENCH_SIMD_SLOTS * sizeof(Vector2));
+		both[i]->rotSpeed_p = (float*)malloc(BENCH_SIMD_SLOTS * sizeof(float));
+		both[i]->tEnabled_p = (double*)malloc(BENCH_SIMD_SLOTS * sizeof(double));
+		both[i]->ids_p = (EntityId*)malloc(BENCH_SIMD_SLOTS * sizeof(EntityId));
+		both[i]->mask_p = (U32*)malloc(BENCH_SIMD_KERNEL_COUNT * SIMD_MASK_WORDS(BENCH_SIMD_MAX) * sizeof(U32));
+	}
+
+	printf("SIMD kernels: widest level %s\n", SimdLevelName(maxLevel));
+	BenchSimdVerify(&data, &reference, maxLevel);
+
+	printf("%-14s %8s", "ms per call", "count");
+	for (int level = SIMD_SCALAR; level < SIMD_LEVEL_COUNT; level++) printf(" %10s", SimdLevelName((SimdLevelE)level));
+	printf(" %9s\n", "speedup");
+	BenchSimdReset(&data);
+	for (int kernel = 0; kernel < BENCH_SIMD_KERNEL_COUNT; kernel++)
+	{
+		for (int c = 0; c < (int)ARRAY_COUNT(benchSimdCounts); c++)
+		{
+			int count = 0;
+			int expectedCount = BenchSimdCount(kernel, benchSimdCounts[c]);
+			double ms[SIMD_LEVEL_COUNT] = { 0 };
+			printf("%-14s %8d", benchSimdKernelNames[kernel], expectedCount);
+			for (int level = SIMD_SCALAR; level < SIMD_LEVEL_COUNT; level++)
+			{
+				if (level > maxLevel) { printf(" %10s", "-"); continue; }
+				BENCH_TIME(ms[level], count, RunSimdKernel(SimdGetKernels((SimdLevelE)level), kernel, &data, benchSimdCounts[c]));
+				if (count != expectedCount) printf("\nERROR: %s processed %d elements, expected %d\n", SimdLevelName((SimdLevelE)level), count, expectedCount);
+				printf(" %10.4f", ms[level]);
+			}
+			printf(" %8.2fx\n", ms[SIMD_SCALAR] / ms[maxLevel]);
+		}
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		free(both[i]->values_p);
+		free(both[i]->rates_p);
+		free(both[i]->pos_p);
+		free(both[i]->vel_p);
+		free(both[i]->facingV_p);
+		free(both[i]->rotSpeed_p);
+		free(both[i]->tEnabled_p);
+		free(both[i]->ids_p);
+		free(both[i]->mask_p);
+	}
+}
+
+bool Bench(const char* name)
+{
+	if (strcmp(name, "broadphase") == 0) BenchBroadphase();
+	else if (strcmp(name, "entities") == 0) BenchEntities();
+	else if (strcmp(name, "particles") == 0) BenchParticles();
+	else if (strcmp(name, "text") == 0) BenchText();
+	else if (strcmp(name, "vertices") == 0) BenchVertices();
+	else if (strcmp(name, "textures") == 0) BenchTextures();
+	else if (strcmp(name, "simd") == 0) BenchSimd();
+	else return false;
+	return true;
+}
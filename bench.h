@@ -0,0 +1,5 @@
+#pragma once
+
+// Micro benchmarks run from the command line with --bench <name>, before any window or GL setup.
+// Returns false if there is no benchmark with that name.
+bool Bench(const char* name);
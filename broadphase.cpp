@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "broadphase.h"
+
+#define BROADPHASE_PAIRS_PER_ENTRY 4 // Initial pair capacity, grows when a crowded tick needs more.
+
+static U32 NextPowerOfTwo(U32 v)
+{
+	U32 result = 1;
+	while (result < v) result <<= 1;
+	return result;
+}
+
+static U32 HashCell(Broadphase* broadphase_p, int cellX, int cellY)
+{
+	U32 hash = ((U32)cellX * 73856093u) ^ ((U32)cellY * 19349663u);
+	return hash & (broadphase_p->bucketCount - 1);
+}
+
+void BroadphaseInit(Broadphase* broadphase_p, U32 maxEntries, float cellSize)
+{
+	memset(broadphase_p, 0, sizeof(*broadphase_p));
+	broadphase_p->cellSize = cellSize;
+	broadphase_p->invCellSize = 1.0f / cellSize;
+
+	broadphase_p->maxEntries = maxEntries;
+	broadphase_p->entries_p = (BroadphaseEntry*)malloc(maxEntries * sizeof(BroadphaseEntry));
+
+	broadphase_p->bucketCount = NextPowerOfTwo(2 * maxEntries); // Keeps unrelated cells sharing a bucket rare.
+	broadphase_p->buckets_p = (U32*)malloc(broadphase_p->bucketCount * sizeof(U32));
+	memset(broadphase_p->buckets_p, 0xff, broadphase_p->bucketCount * sizeof(U32));
+
+	broadphase_p->oversized_p = (U32*)malloc(maxEntries * sizeof(U32));
+
+	broadphase_p->maxPairs = maxEntries * BROADPHASE_PAIRS_PER_ENTRY;
+	broadphase_p->pairs_p = (BroadphasePair*)malloc(broadphase_p->maxPairs * sizeof(BroadphasePair));
+}
+
+void BroadphaseFree(Broadphase* broadphase_p)
+{
+	free(broadphase_p->entries_p);
+	free(broadphase_p->buckets_p);
+	free(broadphase_p->oversized_p);
+	free(broadphase_p->pairs_p);
+	memset(broadphase_p, 0, sizeof(*broadphase_p));
+}
+
+void BroadphaseClear(Broadphase* broadphase_p)
+{
+	// Only reset the buckets that were used instead of the whole table.
+	for (U32 i = 0; i < broadphase_p->entryCount; i++)
+	{
+		BroadphaseEntry* entry_p = &broadphase_p->entries_p[i];
+		if (entry_p->oversized) continue;
+		broadphase_p->buckets_p[HashCell(broadphase_p, entry_p->cellX, entry_p->cellY)] = BROADPHASE_EMPTY;
+	}
+	broadphase_p->entryCount = 0;
+	broadphase_p->oversizedCount = 0;
+	broadphase_p->pairCount = 0;
+}
+
+U32 BroadphaseAdd(Broadphase* broadphase_p, Vector2 pos, float radius, U32 typeMask, U32 collidesWith)
+{
+	assert(broadphase_p->entryCount < broadphase_p->maxEntries);
+
+	U32 idx = broadphase_p->entryCount++;
+	BroadphaseEntry* entry_p = &broadphase_p->entries_p[idx];
+	entry_p->pos = pos;
+	entry_p->radius = radius;
+	entry_p->typeMask = typeMask;
+	entry_p->collidesWith = collidesWith;
+	entry_p->cellX = (int)floorf(pos.x * broadphase_p->invCellSize);
+	entry_p->cellY = (int)floorf(pos.y * broadphase_p->invCellSize);
+	entry_p->next = BROADPHASE_EMPTY;
+	entry_p->oversized = (2 * radius > broadphase_p->cellSize);
+
+	// It could overlap entries in cells that aren't neighbours, so the grid can't find its pairs.
+	if (entry_p->oversized)
+	{
+		broadphase_p->oversized_p[broadphase_p->oversizedCount++] = idx;
+		return idx;
+	}
+
+	U32* bucket_p = &broadphase_p->buckets_p[HashCell(broadphase_p, entry_p->cellX, entry_p->cellY)];
+	entry_p->next = *bucket_p;
+	*bucket_p = idx;
+	return idx;
+}
+
+static void AddPair(Broadphase* broadphase_p, U32 a, U32 b)
+{
+	if (broadphase_p->pairCount == broadphase_p->maxPairs)
+	{
+		broadphase_p->maxPairs *= 2;
+		broadphase_p->pairs_p = (BroadphasePair*)realloc(broadphase_p->pairs_p, broadphase_p->maxPairs * sizeof(BroadphasePair));
+		assert(broadphase_p->pairs_p);
+	}
+	BroadphasePair* pair_p = &broadphase_p->pairs_p[broadphase_p->pairCount++];
+	pair_p->a = (a < b) ? a : b;
+	pair_p->b = (a < b) ? b : a;
+}
+
+static bool ShouldCollide(const BroadphaseEntry* a_p, const BroadphaseEntry* b_p)
+{
+	return (a_p->collidesWith & b_p->typeMask) || (b_p->collidesWith & a_p->typeMask);
+}
+
+static int ComparePairs(const void* a_p, const void* b_p)
+{
+	const BroadphasePair* pairA_p = (const BroadphasePair*)a_p;
+	const BroadphasePair* pairB_p = (const BroadphasePair*)b_p;
+	if (pairA_p->a != pairB_p->a) return (pairA_p->a < pairB_p->a) ? -1 : 1;
+	if (pairA_p->b != pairB_p->b) return (pairA_p->b < pairB_p->b) ? -1 : 1;
+	return 0;
+}
+
+void BroadphaseFindPairs(Broadphase* broadphase_p)
+{
+	// Own cell plus the 4 neighbours "ahead" of it, so every cell pair is visited once.
+	static const int neighbours[4][2] = { {1, 0}, {-1, 1}, {0, 1}, {1, 1} };
+
+	broadphase_p->pairCount = 0;
+	for (U32 i = 0; i < broadphase_p->entryCount; i++)
+	{
+		const BroadphaseEntry* entry_p = &broadphase_p->entries_p[i];
+		if (entry_p->oversized) continue;
+
+		// Same cell: only the entries after this one in the bucket, the earlier ones already saw us.
+		for (U32 j = entry_p->next; j != BROADPHASE_EMPTY; j = broadphase_p->entries_p[j].next)
+		{
+			const BroadphaseEntry* other_p = &broadphase_p->entries_p[j];
+			if (other_p->cellX != entry_p->cellX || other_p->cellY != entry_p->cellY) continue; // Hash collision.
+			if (ShouldCollide(entry_p, other_p)) AddPair(broadphase_p, i, j);
+		}
+
+		for (int n = 0; n < 4; n++)
+		{
+			int cellX = entry_p->cellX + neighbours[n][0];
+			int cellY = entry_p->cellY + neighbours[n][1];
+			for (U32 j = broadphase_p->buckets_p[HashCell(broadphase_p, cellX, cellY)]; j != BROADPHASE_EMPTY; j = broadphase_p->entries_p[j].next)
+			{
+				const BroadphaseEntry* other_p = &broadphase_p->entries_p[j];
+				if (other_p->cellX != cellX || other_p->cellY != cellY) continue;
+				if (ShouldCollide(entry_p, other_p)) AddPair(broadphase_p, i, j);
+			}
+		}
+	}
+
+	// Oversized entries against everything, a pair of two oversized ones only from the lower index.
+	for (U32 o = 0; o < broadphase_p->oversizedCount; o++)
+	{
+		U32 i = broadphase_p->oversized_p[o];
+		const BroadphaseEntry* entry_p = &broadphase_p->entries_p[i];
+		for (U32 j = 0; j < broadphase_p->entryCount; j++)
+		{
+			const BroadphaseEntry* other_p = &broadphase_p->entries_p[j];
+			if (j == i || (other_p->oversized && j < i)) continue;
+			if (ShouldCollide(entry_p, other_p)) AddPair(broadphase_p, i, j);
+		}
+	}
+
+	qsort(broadphase_p->pairs_p, broadphase_p->pairCount, sizeof(BroadphasePair), ComparePairs);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "common.h"
+#include "vector.h"
+
+#define BROADPHASE_EMPTY U32_MAX
+
+// Uniform grid broadphase. The grid is unbounded: cells are hashed into a bucket table, so only
+// occupied cells cost memory. Every entry goes into the cell of its center, so a pair of colliders no
+// larger than a cell can only overlap if the cells are the same or neighbours. Colliders wider than
+// a cell are kept out of the grid and tested against every other entry instead.
+struct BroadphaseEntry
+{
+	Vector2 pos;
+	float radius;
+	U32 typeMask;     // Single bit identifying the kind of object.
+	U32 collidesWith; // Types this entry interacts with, other pairs are never emitted.
+	int cellX;
+	int cellY;
+	U32 next;         // Next entry in the same bucket.
+	bool oversized;   // Diameter above the cell size, not in the grid.
+};
+
+// Candidate pair, a < b, indices in the order the entries were added.
+struct BroadphasePair
+{
+	U32 a;
+	U32 b;
+};
+
+struct Broadphase
+{
+	float cellSize;
+	float invCellSize;
+
+	U32 maxEntries;
+	U32 entryCount;
+	BroadphaseEntry* entries_p;
+
+	U32 bucketCount; // Power of two.
+	U32* buckets_p;  // First entry of each bucket, BROADPHASE_EMPTY if none.
+
+	U32 oversizedCount;
+	U32* oversized_p; // Entries too wide for the grid.
+
+	U32 maxPairs;
+	U32 pairCount;
+	BroadphasePair* pairs_p;
+};
+
+void BroadphaseInit(Broadphase* broadphase_p, U32 maxEntries, float cellSize);
+void BroadphaseFree(Broadphase* broadphase_p);
+void BroadphaseClear(Broadphase* broadphase_p);
+U32 BroadphaseAdd(Broadphase* broadphase_p, Vector2 pos, float radius, U32 typeMask, U32 collidesWith);
+
+// Fills pairs_p with every pair whose cells are neighbours and whose type masks match, sorted by
+// (a, b) so the result is processed in the same order as an all-pairs loop would.
+void BroadphaseFindPairs(Broadphase* broadphase_p);
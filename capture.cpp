@@ -0,0 +1,411 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <glad/glad.h>
+#include "capture.h"
+#include "filemap.h"
+#include "opengl.h"
+#include "nullgl.h"
+#include "timing.h"
+
+#define CAPTURE_MAGIC        0x50414352 // "RCAP"
+#define CAPTURE_VERSION      1
+#define CAPTURE_ALIGNMENT    4          // Every array starts aligned, so replay points straight into the mapped file.
+#define CAPTURE_GROUP_TYPES  (RENDER_GROUP_PARTICLES + 1)
+
+enum CaptureChunkE : U32
+{
+	CAPTURE_CHUNK_MESH = 1,
+	CAPTURE_CHUNK_FRAME = 2,
+};
+
+#define CAPTURE_GROUP_ONLY_COLORED 0x1
+
+struct CaptureHeader
+{
+	U32 magic;
+	U32 version;
+	U32 frameCount;      // Patched in by RenderCaptureClose.
+	U32 staticMeshCount;
+};
+
+struct CaptureChunk
+{
+	CaptureChunkE type;
+	U32 size; // Payload bytes that follow.
+};
+
+// Followed by the vertices and the U32 indices.
+struct CaptureMesh
+{
+	U32 vertexLayout;
+	U32 vertexCount;
+	U32 indexCount;
+	Vector2 boundsMin;
+	Vector2 boundsMax;
+};
+
+// Followed by groupCnt CaptureGroups, each one followed by its arrays.
+struct CaptureFrame
+{
+	Vector2 screenDim;
+	Vector2 framebufferDim;
+	U32 groupCnt;
+};
+
+// Arrays follow in this order: vertices, sorted indices, batches, instances, static draws.
+struct CaptureGroup
+{
+	U32 renderGroupType;
+	U32 vertexLayout;
+	U32 flags;
+	U32 vertexSize;   // Checked against this build's layouts on replay.
+	U32 instanceSize;
+	U32 sortedIndexSize;
+	OrtographicProj ortoProj;
+	U32 vertexCount;
+	U32 indexCount;
+	U32 instanceCount;
+	U32 batchCount;
+	U32 staticDrawCount;
+};
+
+struct CaptureReader
+{
+	const U8* cursor_p;
+	const U8* end_p;
+};
+
+static inline U32 CaptureAlign(U32 size)
+{
+	return (size + CAPTURE_ALIGNMENT - 1) & ~(CAPTURE_ALIGNMENT - 1);
+}
+
+static void CaptureWrite(RenderCapture* capture_p, const void* data_p, U32 size)
+{
+	static const U8 padding[CAPTURE_ALIGNMENT] = { 0 };
+	if (size) fwrite(data_p, 1, size, capture_p->file);
+	U32 aligned = CaptureAlign(size);
+	if (aligned != size) fwrite(padding, 1, aligned - size, capture_p->file);
+	capture_p->bytes += aligned;
+}
+
+static U32 StaticMeshVertexSize(U32 vertexLayout)
+{
+	return vertexLayout == VERTEX_LAYOUT_PACKED ? sizeof(PackedColoredVertex) : sizeof(ColoredVertex);
+}
+
+static U32 GroupInstanceSize(const RenderCommands* renderCmds_p)
+{
+	if (renderCmds_p->particleArray) return sizeof(ParticleInstance);
+	if (renderCmds_p->instanceArray) return sizeof(SpriteInstance);
+	return 0;
+}
+
+static CaptureGroup GroupHeader(const RenderGroup* rendGrp_p)
+{
+	const RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
+	CaptureGroup group = { 0 };
+	group.renderGroupType = rendGrp_p->renderGroupType;
+	group.vertexLayout = renderCmds_p->vertexLayout;
+	group.flags = renderCmds_p->onlyColoredVertexArray ? CAPTURE_GROUP_ONLY_COLORED : 0;
+	group.instanceSize = GroupInstanceSize(renderCmds_p);
+	group.ortoProj = rendGrp_p->ortoProj;
+	group.instanceCount = renderCmds_p->instanceCount;
+	group.batchCount = renderCmds_p->batchCount;
+	group.staticDrawCount = renderCmds_p->staticDrawCount;
+	if (!group.instanceSize)
+	{
+		group.vertexSize = RenderVertexSize(renderCmds_p);
+		group.sortedIndexSize = renderCmds_p->sortedIndexSize;
+		group.vertexCount = renderCmds_p->vertexCount;
+		group.indexCount = renderCmds_p->indexCount;
+	}
+	return group;
+}
+
+static U32 GroupCaptureSize(const CaptureGroup* group_p)
+{
+	return sizeof(CaptureGroup) + CaptureAlign(group_p->vertexCount * group_p->vertexSize) + CaptureAlign(group_p->indexCount * group_p->sortedIndexSize) +
+		group_p->batchCount * sizeof(RenderBatch) + CaptureAlign(group_p->instanceCount * group_p->instanceSize) + group_p->staticDrawCount * sizeof(StaticMeshDraw);
+}
+
+static void CaptureWriteMesh(RenderCapture* capture_p, const StaticMesh* mesh_p)
+{
+	CaptureMesh mesh = { (U32)mesh_p->vertexLayout, mesh_p->vertexCount, mesh_p->indexCount, mesh_p->boundsMin, mesh_p->boundsMax };
+	U32 vertexBytes = mesh.vertexCount * StaticMeshVertexSize(mesh.vertexLayout);
+	CaptureChunk chunk = { CAPTURE_CHUNK_MESH, (U32)sizeof(mesh) + CaptureAlign(vertexBytes) + mesh.indexCount * (U32)sizeof(U32) };
+	CaptureWrite(capture_p, &chunk, sizeof(chunk));
+	CaptureWrite(capture_p, &mesh, sizeof(mesh));
+	CaptureWrite(capture_p, mesh_p->vertices_p, vertexBytes);
+	CaptureWrite(capture_p, mesh_p->indices_p, mesh.indexCount * sizeof(U32));
+}
+
+bool RenderCaptureOpen(RenderCapture* capture_p, const char* path)
+{
+	memset(capture_p, 0, sizeof(*capture_p));
+	capture_p->file = fopen(path, "wb");
+	if (!capture_p->file) { printf("ERROR: Could not create capture %s\n", path); return false; }
+
+	CaptureHeader header = { CAPTURE_MAGIC, CAPTURE_VERSION, 0, 0 };
+	CaptureWrite(capture_p, &header, sizeof(header));
+	return true;
+}
+
+void RenderCaptureFrame(RenderCapture* capture_p, const Renderer* renderer_p)
+{
+	if (!capture_p->file) return;
+
+	for (; capture_p->staticMeshCount < (U32)renderer_p->staticMeshCount; capture_p->staticMeshCount++)
+	{
+		CaptureWriteMesh(capture_p, &renderer_p->staticMeshes[capture_p->staticMeshCount]);
+	}
+
+	CaptureGroup groups[MAX_RENDER_GROUPS];
+	CaptureFrame frame = { renderer_p->screenDim, renderer_p->framebufferDim, (U32)renderer_p->groupCnt };
+	CaptureChunk chunk = { CAPTURE_CHUNK_FRAME, sizeof(frame) };
+	for (int i = 0; i < renderer_p->groupCnt; i++)
+	{
+		groups[i] = GroupHeader(&renderer_p->renderGroups[i]);
+		chunk.size += GroupCaptureSize(&groups[i]);
+	}
+
+	CaptureWrite(capture_p, &chunk, sizeof(chunk));
+	CaptureWrite(capture_p, &frame, sizeof(frame));
+	for (int i = 0; i < renderer_p->groupCnt; i++)
+	{
+		const RenderCommands* renderCmds_p = &renderer_p->renderGroups[i].renderCommands;
+		const CaptureGroup* group_p = &groups[i];
+		const void* vertices_p = renderCmds_p->onlyColoredVertexArray ? (const void*)renderCmds_p->onlyColoredVertexArray : (const void*)renderCmds_p->vertexArray;
+		const void* instances_p = renderCmds_p->particleArray ? (const void*)renderCmds_p->particleArray : (const void*)renderCmds_p->sortedInstanceArray;
+
+		CaptureWrite(capture_p, group_p, sizeof(*group_p));
+		CaptureWrite(capture_p, vertices_p, group_p->vertexCount * group_p->vertexSize);
+		CaptureWrite(capture_p, renderCmds_p->sortedIndexArray, group_p->indexCount * group_p->sortedIndexSize);
+		CaptureWrite(capture_p, renderCmds_p->batchArray, group_p->batchCount * sizeof(RenderBatch));
+		CaptureWrite(capture_p, instances_p, group_p->instanceCount * group_p->instanceSize);
+		CaptureWrite(capture_p, renderCmds_p->staticDraws, group_p->staticDrawCount * sizeof(StaticMeshDraw));
+	}
+	capture_p->frameCount++;
+}
+
+void RenderCaptureClose(RenderCapture* capture_p)
+{
+	if (!capture_p->file) return;
+
+	CaptureHeader header = { CAPTURE_MAGIC, CAPTURE_VERSION, capture_p->frameCount, capture_p->staticMeshCount };
+	fseek(capture_p->file, 0, SEEK_SET);
+	fwrite(&header, sizeof(header), 1, capture_p->file);
+	if (ferror(capture_p->file)) printf("ERROR: Writing the capture failed, it is incomplete\n");
+	fclose(capture_p->file);
+	printf("Capture: %u frames, %u static meshes, %.1f MB\n", capture_p->frameCount, capture_p->staticMeshCount, capture_p->bytes / (double)(MB));
+	capture_p->file = nullptr;
+}
+
+// Next size bytes of the capture, nullptr when the file ends first.
+// Sizes are 64 bit, counts read from the file multiplied in 32 bits could wrap and pass the check.
+static const void* CaptureRead(CaptureReader* reader_p, U64 size)
+{
+	U64 aligned = (size + CAPTURE_ALIGNMENT - 1) & ~(U64)(CAPTURE_ALIGNMENT - 1);
+	if ((U64)(reader_p->end_p - reader_p->cursor_p) < aligned) return nullptr;
+	const void* data_p = reader_p->cursor_p;
+	reader_p->cursor_p += aligned;
+	return data_p;
+}
+
+static bool ReplayReadGroup(CaptureReader* reader_p, const Renderer* renderer_p, U32 staticMeshCount, RenderGroup* rendGrp_p)
+{
+	const CaptureGroup* group_p = (const CaptureGroup*)CaptureRead(reader_p, sizeof(CaptureGroup));
+	if (!group_p) return false;
+
+	const RenderGroup* initGroup_p = nullptr;
+	for (int g = 0; g < renderer_p->groupCnt; g++)
+	{
+		if (renderer_p->renderGroups[g].renderGroupType == (RenderGroupTypeE)group_p->renderGroupType) initGroup_p = &renderer_p->renderGroups[g];
+	}
+	if (!initGroup_p || group_p->staticDrawCount > MAX_STATIC_MESH_DRAWS) return false;
+
+	// The arrays point into the mapped file, the backend only reads them.
+	memset(rendGrp_p, 0, sizeof(*rendGrp_p));
+	rendGrp_p->renderGroupType = (RenderGroupTypeE)group_p->renderGroupType;
+	rendGrp_p->shaderProgram = initGroup_p->shaderProgram;
+	rendGrp_p->ortoProj = group_p->ortoProj;
+	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
+	renderCmds_p->vertexLayout = (VertexLayoutE)group_p->vertexLayout;
+	renderCmds_p->vertexCount = group_p->vertexCount;
+	renderCmds_p->indexCount = group_p->indexCount;
+	renderCmds_p->sortedIndexSize = group_p->sortedIndexSize;
+	renderCmds_p->instanceCount = group_p->instanceCount;
+	renderCmds_p->batchCount = group_p->batchCount;
+	renderCmds_p->staticDrawCount = group_p->staticDrawCount;
+
+	void* vertices_p = (void*)CaptureRead(reader_p, (U64)group_p->vertexCount * group_p->vertexSize);
+	renderCmds_p->sortedIndexArray = (void*)CaptureRead(reader_p, (U64)group_p->indexCount * group_p->sortedIndexSize);
+	renderCmds_p->batchArray = (RenderBatch*)CaptureRead(reader_p, (U64)group_p->batchCount * sizeof(RenderBatch));
+	void* instances_p = (void*)CaptureRead(reader_p, (U64)group_p->instanceCount * group_p->instanceSize);
+	const StaticMeshDraw* staticDraws_p = (const StaticMeshDraw*)CaptureRead(reader_p, (U64)group_p->staticDrawCount * sizeof(StaticMeshDraw));
+	if (!vertices_p || !renderCmds_p->sortedIndexArray || !renderCmds_p->batchArray || !instances_p || !staticDraws_p) return false;
+
+	if (initGroup_p->renderCommands.particleArray)      renderCmds_p->particleArray = (ParticleInstance*)instances_p;
+	else if (initGroup_p->renderCommands.instanceArray) renderCmds_p->instanceArray = renderCmds_p->sortedInstanceArray = (SpriteInstance*)instances_p;
+	else if (group_p->flags & CAPTURE_GROUP_ONLY_COLORED) renderCmds_p->onlyColoredVertexArray = (ColoredVertex*)vertices_p;
+	else renderCmds_p->vertexArray = (TexturedVertex*)vertices_p;
+
+	// Layouts that changed since the capture was written can't be drawn from it.
+	if (group_p->instanceSize != GroupInstanceSize(renderCmds_p)) return false;
+	if (!group_p->instanceSize && group_p->vertexSize != RenderVertexSize(renderCmds_p)) return false;
+
+	if (group_p->indexCount && group_p->sortedIndexSize != sizeof(U16) && group_p->sortedIndexSize != sizeof(U32)) return false;
+
+	// Batches of instanced groups count instances, the others indices.
+	U64 batchLimit = group_p->instanceSize ? group_p->instanceCount : group_p->indexCount;
+	for (U32 b = 0; b < group_p->batchCount; b++)
+	{
+		const RenderBatch* batch_p = &renderCmds_p->batchArray[b];
+		if (batch_p->textureHandle < 0 || batch_p->textureHandle >= MAX_TEXTURE_HANDLES) return false;
+		if ((U64)batch_p->firstIndex + batch_p->indexCount > batchLimit) return false;
+	}
+	for (U32 d = 0; d < group_p->staticDrawCount; d++)
+	{
+		if (staticDraws_p[d].mesh < 0 || (U32)staticDraws_p[d].mesh >= staticMeshCount) return false;
+		renderCmds_p->staticDraws[d] = staticDraws_p[d];
+	}
+	return true;
+}
+
+static bool ReplayReadMesh(CaptureReader* reader_p, StaticMesh* mesh_p)
+{
+	const CaptureMesh* mesh = (const CaptureMesh*)CaptureRead(reader_p, sizeof(CaptureMesh));
+	if (!mesh) return false;
+
+	mesh_p->vertexLayout = (VertexLayoutE)mesh->vertexLayout;
+	mesh_p->vertexCount = mesh->vertexCount;
+	mesh_p->indexCount = mesh->indexCount;
+	mesh_p->boundsMin = mesh->boundsMin;
+	mesh_p->boundsMax = mesh->boundsMax;
+	mesh_p->vertices_p = (void*)CaptureRead(reader_p, (U64)mesh->vertexCount * StaticMeshVertexSize(mesh->vertexLayout));
+	mesh_p->indices_p = (U32*)CaptureRead(reader_p, (U64)mesh->indexCount * sizeof(U32));
+	return mesh_p->vertices_p && mesh_p->indices_p;
+}
+
+// Every frame and mesh of the capture, the frames reference the mesh array and the mapped file.
+static bool ReplayLoad(const FileMap* map_p, const Renderer* renderer_p, RenderFrame** frames_pp, U32* frameCount_p, StaticMesh meshes[MAX_STATIC_MESHES])
+{
+	CaptureReader reader = { map_p->data_p, map_p->data_p + map_p->size };
+	const CaptureHeader* header_p = (const CaptureHeader*)CaptureRead(&reader, sizeof(CaptureHeader));
+	if (!header_p || header_p->magic != CAPTURE_MAGIC || header_p->version != CAPTURE_VERSION) return false;
+	if (header_p->frameCount == 0 || header_p->staticMeshCount > MAX_STATIC_MESHES) return false;
+
+	RenderFrame* frames_p = (RenderFrame*)calloc(header_p->frameCount, sizeof(RenderFrame));
+	U32 frameCount = 0;
+	U32 meshCount = 0;
+	bool valid = true;
+	while (valid && reader.cursor_p < reader.end_p)
+	{
+		const CaptureChunk* chunk_p = (const CaptureChunk*)CaptureRead(&reader, sizeof(CaptureChunk));
+		if (!chunk_p || (size_t)(reader.end_p - reader.cursor_p) < chunk_p->size) { valid = false; break; }
+		CaptureReader chunkReader = { reader.cursor_p, reader.cursor_p + chunk_p->size };
+		reader.cursor_p += chunk_p->size;
+
+		if (chunk_p->type == CAPTURE_CHUNK_MESH)
+		{
+			valid = meshCount < header_p->staticMeshCount && ReplayReadMesh(&chunkReader, &meshes[meshCount]);
+			meshCount++;
+		}
+		else if (chunk_p->type == CAPTURE_CHUNK_FRAME)
+		{
+			const CaptureFrame* frame = (const CaptureFrame*)CaptureRead(&chunkReader, sizeof(CaptureFrame));
+			valid = frame && frameCount < header_p->frameCount && frame->groupCnt <= MAX_RENDER_GROUPS;
+			if (!valid) break;
+
+			RenderFrame* frame_p = &frames_p[frameCount++];
+			frame_p->screenDim = frame->screenDim;
+			frame_p->framebufferDim = frame->framebufferDim;
+			frame_p->staticMeshes_p = meshes;
+			frame_p->groupCnt = (int)frame->groupCnt;
+			for (U32 g = 0; valid && g < frame->groupCnt; g++)
+			{
+				valid = ReplayReadGroup(&chunkReader, renderer_p, meshCount, &frame_p->renderGroups[g]);
+			}
+		}
+		// Unknown chunks are skipped.
+	}
+
+	if (!valid || frameCount != header_p->frameCount)
+	{
+		free(frames_p);
+		return false;
+	}
+	*frames_pp = frames_p;
+	*frameCount_p = frameCount;
+	return true;
+}
+
+bool RenderReplay(const char* path, int frameCount)
+{
+	// Shaders and buffers are created the same way the game does, against the null backend.
+	GLADloadproc loadProc = (GLADloadproc)NullGLGetProcAddress;
+	if (!gladLoadGLLoader(loadProc)) { printf("ERROR: Failed to load the null GL backend\n"); return false; }
+	OpenGL* openGl_p = (OpenGL*)malloc(sizeof(OpenGL));
+	OpenGLInit(openGl_p, loadProc);
+	Renderer* renderer_p = (Renderer*)malloc(sizeof(Renderer));
+	RendererInit(renderer_p);
+
+	FileMap map;
+	if (!FileMapOpen(&map, path)) { printf("ERROR: Could not open capture %s\n", path); return false; }
+
+	RenderFrame* frames_p = nullptr;
+	U32 captureFrames = 0;
+	StaticMesh meshes[MAX_STATIC_MESHES] = {};
+	if (!ReplayLoad(&map, renderer_p, &frames_p, &captureFrames, meshes))
+	{
+		printf("ERROR: %s is not a capture this build can replay\n", path);
+		FileMapClose(&map);
+		return false;
+	}
+	printf("Replay: %s, %u frames captured, %.1f MB\n", path, captureFrames, map.size / (double)(MB));
+
+	// Every captured frame is drawn once untimed, so stream buffer growth and static mesh uploads stay out of the timings.
+	for (U32 f = 0; f < captureFrames; f++) OpenGLEndFrame(openGl_p, &frames_p[f]);
+
+	double totalMs = 0;
+	double worstMs = 0;
+	U64 glCalls = 0;
+	U64 drawCalls = 0;
+	U64 bytesUploaded = 0;
+	U64 groupDrawCalls[CAPTURE_GROUP_TYPES] = { 0 };
+	U64 groupBytes[CAPTURE_GROUP_TYPES] = { 0 };
+	for (int i = 0; i < frameCount; i++)
+	{
+		RenderFrame* frame_p = &frames_p[i % captureFrames];
+		double tStart = GetTime();
+		OpenGLEndFrame(openGl_p, frame_p);
+		double ms = 1000.0 * (GetTime() - tStart);
+		totalMs += ms;
+		if (ms > worstMs) worstMs = ms;
+
+		glCalls += openGl_p->lastFrameStats.glCalls;
+		drawCalls += openGl_p->lastFrameStats.drawCalls;
+		bytesUploaded += openGl_p->lastFrameStats.bufferBytesUploaded;
+		for (int g = 0; g < frame_p->groupCnt; g++)
+		{
+			int type = frame_p->renderGroups[g].renderGroupType;
+			groupDrawCalls[type] += frame_p->groupStats[g].drawCalls;
+			groupBytes[type] += frame_p->groupStats[g].bytesUploaded;
+		}
+	}
+
+	double frames = (double)(frameCount > 0 ? frameCount : 1);
+	printf("Replay: %d frames, %.4f ms/frame, worst %.4f ms\n", frameCount, totalMs / frames, worstMs);
+	printf("  GL calls/frame %.1f, draw calls/frame %.1f, upload KB/frame %.1f\n", glCalls / frames, drawCalls / frames, bytesUploaded / frames / 1024.0);
+	printf("  %-10s %12s %12s\n", "group", "draws/frame", "KB/frame");
+	for (int type = RENDER_GROUP_SPRITES_DEFAULT; type < CAPTURE_GROUP_TYPES; type++)
+	{
+		printf("  %-10s %12.1f %12.1f\n", RenderGroupName((RenderGroupTypeE)type), groupDrawCalls[type] / frames, groupBytes[type] / frames / 1024.0);
+	}
+
+	free(frames_p);
+	FileMapClose(&map);
+	return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdio.h>
+#include "common.h"
+#include "renderer.h"
+
+// Render command captures: every frame's sorted and batched groups written to a binary file exactly as the
+// backend would receive them, so OpenGLEndFrame can be replayed and timed on its own without the game.
+// Only what the backend reads is stored: group types, projections, vertices, narrowed indices, batches
+// (with their texture handles), instances, static mesh draws, and each static mesh once when it's created.
+
+struct RenderCapture
+{
+	FILE* file;
+	U32 frameCount;
+	U32 staticMeshCount; // Meshes written so far, new ones are written before the first frame that can draw them.
+	U64 bytes;
+};
+
+bool RenderCaptureOpen(RenderCapture* capture_p, const char* path);
+void RenderCaptureFrame(RenderCapture* capture_p, const Renderer* renderer_p); // After RendererSortAndBatch.
+void RenderCaptureClose(RenderCapture* capture_p);
+
+// Draws frameCount frames from the capture through OpenGLEndFrame on the null GL backend, looping over the
+// capture as needed, and prints ms/frame, draw calls and upload bytes. Call before any GL setup.
+bool RenderReplay(const char* path, int frameCount);
@@ -5,6 +5,7 @@
 
 #define MB 1024*1024
 
+#define U8_MAX						UINT8_MAX
 #define U16_MAX						UINT16_MAX
 #define U32_MAX						UINT32_MAX
 #define S64_MAX						INT64_MAX
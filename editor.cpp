@@ -1,4 +1,5 @@
 #include <string.h>
+#include <math.h>
 #include "vector.h"
 #include "renderer.h"
 #include "texture.h"
@@ -10,6 +11,7 @@
 
 #define COLOR_GRID Col(0.24f, 0.24f, 0.24f)
 #define GRID_SIZE 100
+#define GRID_TILE_CELLS 32
 #define CAM_ZOOM_STEP 100.0f
 #define CAM_INITIAL_SIZE (2.0f * ScreenDim)
 #define MAX_ENTITIES 3
@@ -61,36 +63,45 @@ static Vector2 MouseToWorldPos(Vector2 mousepos)
 	return V2(x, y);
 }
 
-static inline int AlignToGrid(float coord, int gridSize)
-{
-	return gridSize * ((int)coord / gridSize);
-}
-
 static float GetZoomLevel(Camera* camera_p, float zoomStep = GRID_SIZE)
 {
 	if (CAM_INITIAL_SIZE.x == camera_p->rect.size.x) return 1.0f;
 	return 2.0f * ((CAM_INITIAL_SIZE.x - camera_p->rect.size.x) / zoomStep);
 }
 
-static void DrawGrid(Renderer* renderer_p, Camera* camera_p, int gridSize)
+// One tile of GRID_TILE_CELLS x GRID_TILE_CELLS cells, built once and drawn as often as the camera needs.
+static StaticMeshHandleT BuildGridTile(Renderer* renderer_p, int gridSize)
 {
-	float yStart = AlignToGrid(camera_p->rect.pos.y, gridSize) - gridSize;
-	float yEnd   = AlignToGrid(camera_p->rect.pos.y + camera_p->rect.size.y, gridSize) + gridSize;
-	float xStart = AlignToGrid(camera_p->rect.pos.x, gridSize) - gridSize;
-	float xEnd   = AlignToGrid(camera_p->rect.pos.x + camera_p->rect.size.x, gridSize) + gridSize;
-
-	float y = yStart;
-	while (y < yEnd)
+	float tileSize = (float)(GRID_TILE_CELLS * gridSize);
+	StaticMeshBegin(renderer_p);
+	for (int i = 0; i < GRID_TILE_CELLS; i++)
 	{
-		PushLine(renderer_p, V2(xStart, y), V2(xEnd, y), COLOR_GRID, y == 0 ? 2.0f : 0.001f);
-		y += gridSize;
+		float lineOffset = (float)(i * gridSize);
+		PushLine(renderer_p, V2(0.0f, lineOffset), V2(tileSize, lineOffset), COLOR_GRID, 0.001f);
+		PushLine(renderer_p, V2(lineOffset, 0.0f), V2(lineOffset, tileSize), COLOR_GRID, 0.001f);
 	}
-	float x = xStart;
-	while (x < xEnd)
+	return StaticMeshEnd(renderer_p);
+}
+
+static void DrawGrid(Renderer* renderer_p, Camera* camera_p, int gridSize)
+{
+	static StaticMeshHandleT gridTile = STATIC_MESH_NONE;
+	if (gridTile == STATIC_MESH_NONE) gridTile = BuildGridTile(renderer_p, gridSize);
+	if (gridTile == STATIC_MESH_NONE) return;
+
+	float tileSize = (float)(GRID_TILE_CELLS * gridSize);
+	float yStart = tileSize * floorf(camera_p->rect.pos.y / tileSize);
+	float yEnd   = camera_p->rect.pos.y + camera_p->rect.size.y;
+	float xStart = tileSize * floorf(camera_p->rect.pos.x / tileSize);
+	float xEnd   = camera_p->rect.pos.x + camera_p->rect.size.x;
+	for (float y = yStart; y < yEnd; y += tileSize)
 	{
-		PushLine(renderer_p, V2(x, yStart), V2(x, yEnd), COLOR_GRID, x == 0 ? 2.0f : 0.001f);
-		x += gridSize;
+		for (float x = xStart; x < xEnd; x += tileSize) PushStaticMesh(renderer_p, gridTile, V2(x, y));
 	}
+
+	// The axes are the only lines that differ, they span the view.
+	PushLine(renderer_p, V2(camera_p->rect.pos.x, 0.0f), V2(xEnd, 0.0f), COLOR_GRID, 2.0f);
+	PushLine(renderer_p, V2(0.0f, camera_p->rect.pos.y), V2(0.0f, yEnd), COLOR_GRID, 2.0f);
 }
 
 static Vector2 CameraPan(Camera* camera_p, Mouse* mouse_p)
@@ -289,6 +300,10 @@ void Editor(float deltaT, Renderer* renderer_p)
 		}
 	}
 	
+	// Before any world push, they are culled against this frame's camera.
+	SetSpritesOrtographicProj(renderer_p, camera.rect);
+	SetWireframeOrtographicProj(renderer_p, camera.rect);
+
 	DrawGrid(renderer_p, &camera, GRID_SIZE);
 
 	for (int i = 1; i < MAX_ENTITIES + 1; i++)
@@ -308,8 +323,5 @@ void Editor(float deltaT, Renderer* renderer_p)
 
 	ShowNotification(&notification);
 
-	SetSpritesOrtographicProj(renderer_p, camera.rect);
-	SetWireframeOrtographicProj(renderer_p, camera.rect);
-
 	time += deltaT;
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "entity.h"
+#include "simd.h"
+
+void EntityStoreInit(EntityStore* store_p, int capacity, int listCount)
+{
+	assert(capacity <= ENTITY_INVALID);
+	assert(listCount <= U8_MAX);
+
+	memset(store_p, 0, sizeof(*store_p));
+	store_p->capacity = capacity;
+	store_p->pos_p = (Vector2*)malloc(capacity * sizeof(Vector2));
+	store_p->vel_p = (Vector2*)malloc(capacity * sizeof(Vector2));
+	store_p->facingV_p = (Vector2*)malloc(capacity * sizeof(Vector2));
+	store_p->rotSpeed_p = (float*)malloc(capacity * sizeof(float));
+	store_p->colliderRadius_p = (float*)malloc(capacity * sizeof(float));
+	store_p->tEnabled_p = (double*)malloc(capacity * sizeof(double));
+	store_p->prevPos_p = (Vector2*)malloc(capacity * sizeof(Vector2));
+	store_p->prevFacingV_p = (Vector2*)malloc(capacity * sizeof(Vector2));
+	store_p->interpolate_p = (bool*)malloc(capacity * sizeof(bool));
+	store_p->list_p = (U8*)malloc(capacity * sizeof(U8));
+	store_p->listSlot_p = (int*)malloc(capacity * sizeof(int));
+
+	store_p->listCount = listCount;
+	store_p->lists_p = (EntityList*)malloc(listCount * sizeof(EntityList));
+	for (int i = 0; i < listCount; i++)
+	{
+		store_p->lists_p[i].count = 0;
+		store_p->lists_p[i].ids_p = (EntityId*)malloc(capacity * sizeof(EntityId));
+	}
+}
+
+void EntityStoreFree(EntityStore* store_p)
+{
+	free(store_p->pos_p);
+	free(store_p->vel_p);
+	free(store_p->facingV_p);
+	free(store_p->rotSpeed_p);
+	free(store_p->colliderRadius_p);
+	free(store_p->tEnabled_p);
+	free(store_p->prevPos_p);
+	free(store_p->prevFacingV_p);
+	free(store_p->interpolate_p);
+	free(store_p->list_p);
+	free(store_p->listSlot_p);
+	for (int i = 0; i < store_p->listCount; i++) free(store_p->lists_p[i].ids_p);
+	free(store_p->lists_p);
+	memset(store_p, 0, sizeof(*store_p));
+}
+
+void EntityStoreReset(EntityStore* store_p)
+{
+	store_p->count = 0;
+	for (int i = 0; i < store_p->listCount; i++) store_p->lists_p[i].count = 0;
+}
+
+EntityId EntityCreate(EntityStore* store_p, int list)
+{
+	assert(store_p->count < store_p->capacity);
+	assert(list < store_p->listCount);
+
+	EntityId id = (EntityId)store_p->count++;
+	store_p->pos_p[id] = VECTOR2_ZERO;
+	store_p->vel_p[id] = VECTOR2_ZERO;
+	store_p->facingV_p[id] = VECTOR2_ZERO;
+	store_p->rotSpeed_p[id] = 0;
+	store_p->colliderRadius_p[id] = 0;
+	store_p->tEnabled_p[id] = 0;
+	store_p->prevPos_p[id] = VECTOR2_ZERO;
+	store_p->prevFacingV_p[id] = VECTOR2_ZERO;
+	store_p->interpolate_p[id] = false;
+	store_p->list_p[id] = (U8)list;
+	store_p->listSlot_p[id] = -1;
+	return id;
+}
+
+void EntitySpawn(EntityStore* store_p, EntityId id)
+{
+	if (EntityIsLive(store_p, id)) return;
+
+	EntityList* list_p = &store_p->lists_p[store_p->list_p[id]];
+	store_p->listSlot_p[id] = list_p->count;
+	list_p->ids_p[list_p->count++] = id;
+}
+
+void EntityKill(EntityStore* store_p, EntityId id)
+{
+	int slot = store_p->listSlot_p[id];
+	if (slot < 0) return;
+
+	EntityList* list_p = &store_p->lists_p[store_p->list_p[id]];
+	EntityId last = list_p->ids_p[--list_p->count];
+	list_p->ids_p[slot] = last;
+	store_p->listSlot_p[last] = slot;
+	store_p->listSlot_p[id] = -1;
+}
+
+void EntitiesSavePrevState(EntityStore* store_p)
+{
+	memcpy(store_p->prevPos_p, store_p->pos_p, store_p->count * sizeof(Vector2));
+	memcpy(store_p->prevFacingV_p, store_p->facingV_p, store_p->count * sizeof(Vector2));
+	for (int i = 0; i < store_p->count; i++)
+	{
+		store_p->interpolate_p[i] = (store_p->listSlot_p[i] >= 0);
+	}
+}
+
+void EntitiesIntegrate(EntityStore* store_p, const EntityList* list_p, float deltaT)
+{
+	Simd.integrateIds(store_p->pos_p, store_p->vel_p, list_p->ids_p, list_p->count, deltaT);
+}
+
+void EntitiesRotate(EntityStore* store_p, const EntityList* list_p, float deltaT)
+{
+	Simd.rotateIds(store_p->facingV_p, store_p->rotSpeed_p, list_p->ids_p, list_p->count, deltaT);
+}
+
+int EntitiesFindExpired(const EntityStore* store_p, const EntityList* list_p, double time, double lifetime, EntityId expired_p[])
+{
+	U32 mask[SIMD_MASK_WORDS(ENTITY_INVALID)];
+	assert(list_p->count <= ENTITY_INVALID);
+	Simd.expiredIds(store_p->tEnabled_p, list_p->ids_p, list_p->count, time, lifetime, mask);
+
+	int count = 0;
+	for (int w = 0; w < SIMD_MASK_WORDS(list_p->count); w++)
+	{
+		for (U32 bits = mask[w]; bits; bits &= bits - 1) expired_p[count++] = list_p->ids_p[32 * w + SimdLowestBit(bits)];
+	}
+	return count;
+}
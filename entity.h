@@ -0,0 +1,60 @@
+#pragma once
+
+#include "common.h"
+#include "vector.h"
+
+#define ENTITY_INVALID U16_MAX
+
+typedef U16 EntityId;
+
+// Packed ids of the live entities of one kind. Passes iterate these instead of testing a flag per slot.
+struct EntityList
+{
+	int count;
+	EntityId* ids_p;
+};
+
+// Entity components stored as one array per field, indexed by EntityId. Only what the per tick passes
+// read and write lives here so they stream through memory, the rest stays with the game in its own arrays.
+struct EntityStore
+{
+	int capacity;
+	int count; // Slots created so far.
+
+	Vector2* pos_p;
+	Vector2* vel_p;
+	Vector2* facingV_p;
+	float* rotSpeed_p;
+	float* colliderRadius_p;
+	double* tEnabled_p;
+
+	// State at the start of the last simulation tick, rendering interpolates from it.
+	Vector2* prevPos_p;
+	Vector2* prevFacingV_p;
+	bool* interpolate_p; // False when spawned or teleported during the last tick.
+
+	U8* list_p;      // List each slot belongs to, fixed when the slot is created.
+	int* listSlot_p; // Position inside that list, -1 while not live.
+	int listCount;
+	EntityList* lists_p;
+};
+
+void EntityStoreInit(EntityStore* store_p, int capacity, int listCount);
+void EntityStoreFree(EntityStore* store_p);
+void EntityStoreReset(EntityStore* store_p); // Removes every slot.
+
+EntityId EntityCreate(EntityStore* store_p, int list); // New zeroed slot, not live yet.
+void EntitySpawn(EntityStore* store_p, EntityId id);   // Appends to its list, no-op when already live.
+void EntityKill(EntityStore* store_p, EntityId id);    // Swap-removes from its list, so list order isn't stable.
+
+static inline bool EntityIsLive(const EntityStore* store_p, EntityId id)
+{
+	return store_p->listSlot_p[id] >= 0;
+}
+
+void EntitiesSavePrevState(EntityStore* store_p);
+// Batch passes over one list, they run on the Simd kernels.
+void EntitiesIntegrate(EntityStore* store_p, const EntityList* list_p, float deltaT); // pos += deltaT * vel
+void EntitiesRotate(EntityStore* store_p, const EntityList* list_p, float deltaT);    // facingV rotated by rotSpeed * deltaT
+// Writes the ids alive longer than lifetime to expired_p, at most list_p->count of them. Returns how many.
+int EntitiesFindExpired(const EntityStore* store_p, const EntityList* list_p, double time, double lifetime, EntityId expired_p[]);
@@ -0,0 +1,72 @@
+#include <string.h>
+#include "filemap.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+bool FileMapOpen(FileMap* map_p, const char* path)
+{
+	memset(map_p, 0, sizeof(*map_p));
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) { CloseHandle(file); return false; }
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) { CloseHandle(file); return false; }
+
+	void* data_p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data_p) { CloseHandle(mapping); CloseHandle(file); return false; }
+
+	map_p->data_p = (const U8*)data_p;
+	map_p->size = (U64)size.QuadPart;
+	map_p->file = file;
+	map_p->mapping = mapping;
+	return true;
+}
+
+void FileMapClose(FileMap* map_p)
+{
+	if (!map_p->data_p) return;
+	UnmapViewOfFile(map_p->data_p);
+	CloseHandle(map_p->mapping);
+	CloseHandle(map_p->file);
+	memset(map_p, 0, sizeof(*map_p));
+}
+
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool FileMapOpen(FileMap* map_p, const char* path)
+{
+	memset(map_p, 0, sizeof(*map_p));
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return false; }
+
+	void* data_p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data_p == MAP_FAILED) { close(fd); return false; }
+
+	map_p->data_p = (const U8*)data_p;
+	map_p->size = (U64)st.st_size;
+	map_p->fd = fd;
+	return true;
+}
+
+void FileMapClose(FileMap* map_p)
+{
+	if (!map_p->data_p) return;
+	munmap((void*)map_p->data_p, map_p->size);
+	close(map_p->fd);
+	memset(map_p, 0, sizeof(*map_p));
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "common.h"
+
+// Read-only memory mapping of a whole file. Pages are loaded on first touch, so opening is cheap
+// no matter how big the file is. Closing an unopened (zeroed) map does nothing.
+struct FileMap
+{
+	const U8* data_p;
+	U64 size;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#else
+	int fd;
+#endif
+};
+
+bool FileMapOpen(FileMap* map_p, const char* path);
+void FileMapClose(FileMap* map_p);
@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "timing.h"
+#include "font.h"
+#include "assetpack.h"
+
+#define FONT_BLOB_MAGIC     0x46445346 // "FSDF"
+#define FONT_BLOB_VERSION   1
+#define FONT_ATLAS_MAX_SIZE 1024
+
+struct FontBlobHeader
+{
+	U32 magic;
+	U32 version;
+	float baseSize;
+	int padding;
+	int onedge;
+	int glyphCount;
+	int atlasWidth;
+	int atlasHeight;
+};
+
+struct FontGlyphSdf
+{
+	U8* bitmap_p; // nullptr for glyphs without an outline, like space.
+	int width;
+	int height;
+	int xoff;
+	int yoff;
+	float advance;
+};
+
+static U32 FontBlobSize(int atlasWidth, int atlasHeight)
+{
+	return sizeof(FontBlobHeader) + FONT_GLYPH_COUNT * sizeof(stbtt_bakedchar) + atlasWidth * atlasHeight;
+}
+
+static bool FontBlobValid(const U8* blob_p, U64 size)
+{
+	if (size < sizeof(FontBlobHeader)) return false;
+	const FontBlobHeader* header_p = (const FontBlobHeader*)blob_p;
+	return header_p->magic == FONT_BLOB_MAGIC && header_p->version == FONT_BLOB_VERSION && header_p->baseSize == FONT_SDF_BASE_SIZE &&
+		header_p->padding == FONT_SDF_PADDING && header_p->onedge == FONT_SDF_ONEDGE && header_p->glyphCount == FONT_GLYPH_COUNT &&
+		size == FontBlobSize(header_p->atlasWidth, header_p->atlasHeight);
+}
+
+// Rows of glyphs in codepoint order, a monospace font has nearly equal glyph heights anyway.
+static bool FontPackGlyphs(const FontGlyphSdf glyphs[], int width, int height, stbtt_bakedchar packed[])
+{
+	int x = 0;
+	int y = 0;
+	int rowHeight = 0;
+	for (int i = 0; i < FONT_GLYPH_COUNT; i++)
+	{
+		int w = glyphs[i].width + 1; // One pixel gap so linear filtering doesn't pick up the neighbour.
+		int h = glyphs[i].height + 1;
+		if (x + w > width) { x = 0; y += rowHeight; rowHeight = 0; }
+		if (x + w > width || y + h > height) return false;
+
+		packed[i].x0 = (unsigned short)x;
+		packed[i].y0 = (unsigned short)y;
+		packed[i].x1 = (unsigned short)(x + glyphs[i].width);
+		packed[i].y1 = (unsigned short)(y + glyphs[i].height);
+		packed[i].xoff = (float)glyphs[i].xoff;
+		packed[i].yoff = (float)glyphs[i].yoff;
+		packed[i].xadvance = glyphs[i].advance;
+
+		x += w;
+		if (h > rowHeight) rowHeight = h;
+	}
+	return true;
+}
+
+static U8* ReadWholeFile(const char* path, U32* size_p)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file) return nullptr;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	U8* data_p = (U8*)malloc(size);
+	bool read = fread(data_p, 1, size, file) == (size_t)size;
+	fclose(file);
+	if (!read) { free(data_p); return nullptr; }
+
+	*size_p = (U32)size;
+	return data_p;
+}
+
+static U8* FontBuildBlob(const char* const ttfPaths[], int ttfCount, U32* blobSize_p)
+{
+	U8* ttf_p = nullptr;
+	U32 ttfSize = 0;
+	for (int i = 0; i < ttfCount && !ttf_p; i++) ttf_p = ReadWholeFile(ttfPaths[i], &ttfSize);
+	if (!ttf_p) { printf("ERROR: Could not open any font to build the SDF atlas from\n"); return nullptr; }
+
+	stbtt_fontinfo info;
+	if (!stbtt_InitFont(&info, ttf_p, stbtt_GetFontOffsetForIndex(ttf_p, 0))) { free(ttf_p); return nullptr; }
+
+	float scale = stbtt_ScaleForPixelHeight(&info, FONT_SDF_BASE_SIZE);
+	FontGlyphSdf glyphs[FONT_GLYPH_COUNT];
+	for (int i = 0; i < FONT_GLYPH_COUNT; i++)
+	{
+		FontGlyphSdf* glyph_p = &glyphs[i];
+		memset(glyph_p, 0, sizeof(*glyph_p));
+		glyph_p->bitmap_p = stbtt_GetCodepointSDF(&info, scale, FONT_FIRST_CHAR + i, FONT_SDF_PADDING, FONT_SDF_ONEDGE, (float)FONT_SDF_ONEDGE / FONT_SDF_PADDING,
+			&glyph_p->width, &glyph_p->height, &glyph_p->xoff, &glyph_p->yoff);
+		if (!glyph_p->bitmap_p) glyph_p->width = glyph_p->height = 0;
+
+		int advance, leftSideBearing;
+		stbtt_GetCodepointHMetrics(&info, FONT_FIRST_CHAR + i, &advance, &leftSideBearing);
+		glyph_p->advance = scale * advance;
+	}
+
+	// Same size progression as the texture atlas, a 2:1 rectangle before the square of the same width.
+	stbtt_bakedchar packed[FONT_GLYPH_COUNT];
+	int width = 0;
+	int height = 0;
+	bool fits = false;
+	for (int size = 128; !fits && size <= FONT_ATLAS_MAX_SIZE; size *= 2)
+	{
+		width = size;
+		height = size / 2;
+		fits = FontPackGlyphs(glyphs, width, height, packed);
+		if (!fits)
+		{
+			height = size;
+			fits = FontPackGlyphs(glyphs, width, height, packed);
+		}
+	}
+	assert(fits);
+
+	U32 blobSize = FontBlobSize(width, height);
+	U8* blob_p = (U8*)calloc(1, blobSize);
+	FontBlobHeader header = { FONT_BLOB_MAGIC, FONT_BLOB_VERSION, FONT_SDF_BASE_SIZE, FONT_SDF_PADDING, FONT_SDF_ONEDGE, FONT_GLYPH_COUNT, width, height };
+	memcpy(blob_p, &header, sizeof(header));
+	memcpy(blob_p + sizeof(header), packed, sizeof(packed));
+
+	U8* atlas_p = blob_p + sizeof(header) + sizeof(packed);
+	for (int i = 0; i < FONT_GLYPH_COUNT; i++)
+	{
+		for (int y = 0; y < glyphs[i].height; y++)
+		{
+			memcpy(&atlas_p[(packed[i].y0 + y) * width + packed[i].x0], &glyphs[i].bitmap_p[y * glyphs[i].width], glyphs[i].width);
+		}
+		if (glyphs[i].bitmap_p) stbtt_FreeSDF(glyphs[i].bitmap_p, nullptr);
+	}
+
+	free(ttf_p);
+	*blobSize_p = blobSize;
+	return blob_p;
+}
+
+static bool FontWriteBlob(const char* blobPath, const U8* blob_p, U32 blobSize)
+{
+	FILE* file = fopen(blobPath, "wb");
+	if (!file) { printf("WARNING: Could not write font blob %s\n", blobPath); return false; }
+	bool written = fwrite(blob_p, 1, blobSize, file) == blobSize;
+	fclose(file);
+	return written;
+}
+
+bool FontLoad(Font* font_p, const char* blobPath, const char* const ttfPaths[], int ttfCount)
+{
+	double tStart = GetTime();
+	memset(font_p, 0, sizeof(*font_p));
+
+	// A blob in the mounted asset pack is used in place, it stays mapped as long as the pack.
+	U64 packedSize = 0;
+	const U8* packed_p = AssetPackFind(blobPath, &packedSize);
+	if (packed_p && !FontBlobValid(packed_p, packedSize)) packed_p = nullptr;
+
+	if (!packed_p && (!FileMapOpen(&font_p->blobMap, blobPath) || !FontBlobValid(font_p->blobMap.data_p, font_p->blobMap.size)))
+	{
+		FileMapClose(&font_p->blobMap);
+
+		U32 blobSize = 0;
+		U8* blob_p = FontBuildBlob(ttfPaths, ttfCount, &blobSize);
+		if (!blob_p) return false;
+		font_p->stats.built = true;
+
+		// Map what was written so a built and a loaded font behave the same.
+		if (FontWriteBlob(blobPath, blob_p, blobSize) && FileMapOpen(&font_p->blobMap, blobPath) && FontBlobValid(font_p->blobMap.data_p, font_p->blobMap.size))
+		{
+			free(blob_p);
+		}
+		else
+		{
+			FileMapClose(&font_p->blobMap);
+			font_p->builtBlob_p = blob_p;
+		}
+	}
+
+	const U8* blob_p = packed_p ? packed_p : font_p->builtBlob_p ? font_p->builtBlob_p : font_p->blobMap.data_p;
+	const FontBlobHeader* header_p = (const FontBlobHeader*)blob_p;
+	font_p->baseSize = header_p->baseSize;
+	font_p->glyphs_p = (const stbtt_bakedchar*)(blob_p + sizeof(FontBlobHeader));
+	font_p->texture.width = header_p->atlasWidth;
+	font_p->texture.height = header_p->atlasHeight;
+	font_p->texture.nrChannels = 1;
+	font_p->texture.data_p = (U8*)(blob_p + sizeof(FontBlobHeader) + FONT_GLYPH_COUNT * sizeof(stbtt_bakedchar));
+
+	font_p->stats.blobBytes = FontBlobSize(header_p->atlasWidth, header_p->atlasHeight);
+	font_p->stats.atlasBytes = header_p->atlasWidth * header_p->atlasHeight;
+	font_p->stats.loadMs = 1000.0 * (GetTime() - tStart);
+	return true;
+}
+
+void FontFree(Font* font_p)
+{
+	FileMapClose(&font_p->blobMap);
+	free(font_p->builtBlob_p);
+	memset(font_p, 0, sizeof(*font_p));
+}
+
+bool FontBakeBlob(const char* blobPath, const char* const ttfPaths[], int ttfCount)
+{
+	U32 blobSize = 0;
+	U8* blob_p = FontBuildBlob(ttfPaths, ttfCount, &blobSize);
+	if (!blob_p) return false;
+	bool written = FontWriteBlob(blobPath, blob_p, blobSize);
+	free(blob_p);
+	return written;
+}
+
+void FontGetQuad(const Font* font_p, float fontSize, int charIndex, float* xpos_p, float* ypos_p, stbtt_aligned_quad* quad_p)
+{
+	assert(charIndex >= 0 && charIndex < FONT_GLYPH_COUNT);
+	const stbtt_bakedchar* glyph_p = &font_p->glyphs_p[charIndex];
+	float scale = fontSize / font_p->baseSize;
+	float invWidth = 1.0f / font_p->texture.width;
+	float invHeight = 1.0f / font_p->texture.height;
+
+	quad_p->x0 = *xpos_p + scale * glyph_p->xoff;
+	quad_p->y0 = *ypos_p + scale * glyph_p->yoff;
+	quad_p->x1 = quad_p->x0 + scale * (glyph_p->x1 - glyph_p->x0);
+	quad_p->y1 = quad_p->y0 + scale * (glyph_p->y1 - glyph_p->y0);
+	quad_p->s0 = glyph_p->x0 * invWidth;
+	quad_p->t0 = glyph_p->y0 * invHeight;
+	quad_p->s1 = glyph_p->x1 * invWidth;
+	quad_p->t1 = glyph_p->y1 * invHeight;
+
+	*xpos_p += scale * glyph_p->xadvance;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stb_truetype.h>
+#include "common.h"
+#include "texture.h"
+#include "filemap.h"
+
+#define FONT_FIRST_CHAR      32
+#define FONT_GLYPH_COUNT     96   // ASCII 32..127.
+#define FONT_SDF_BASE_SIZE   32.0f // Pixel height the distance field is generated at, other sizes scale it.
+#define FONT_SDF_PADDING     4    // Distance field pixels around every glyph.
+#define FONT_SDF_ONEDGE      128  // Field value on the glyph outline.
+
+struct FontLoadStats
+{
+	double loadMs;
+	bool built;     // The blob was missing or stale and had to be generated from the TTF.
+	U32 blobBytes;
+	U32 atlasBytes;
+};
+
+// Signed distance field glyph atlas with its metrics. The whole font is one binary blob:
+// header, FONT_GLYPH_COUNT stbtt_bakedchar and the single channel atlas. It is generated from a TTF
+// the first time and memory mapped afterwards, so startup doesn't parse the TTF.
+struct Font
+{
+	float baseSize;
+	const stbtt_bakedchar* glyphs_p; // Metrics at baseSize, points into the blob.
+	Texture texture;                 // Single channel distance field, data_p points into the blob.
+
+	FileMap blobMap;
+	U8* builtBlob_p;                 // Blob kept in memory when it was built and couldn't be written.
+	FontLoadStats stats;
+};
+
+// Uses blobPath from the mounted asset pack, or maps it, or builds it from the first TTF in ttfPaths that
+// exists and writes it there.
+bool FontLoad(Font* font_p, const char* blobPath, const char* const ttfPaths[], int ttfCount);
+void FontFree(Font* font_p);
+bool FontBakeBlob(const char* blobPath, const char* const ttfPaths[], int ttfCount); // Offline rebuild, overwrites blobPath.
+
+// Same contract as stbtt_GetBakedQuad, scaled to fontSize. Positions aren't snapped to pixels, the
+// distance field keeps the edges sharp at fractional positions.
+void FontGetQuad(const Font* font_p, float fontSize, int charIndex, float* xpos_p, float* ypos_p, stbtt_aligned_quad* quad_p);
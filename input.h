@@ -50,6 +50,7 @@ enum ButtonVal
 	BUTTON_DEL,
 	BUTTON_LCTRL,
 	BUTTON_F1,
+	BUTTON_F2,
 	BUTTON_F10,
 	BUTTON_F11,
 	MAX_BUTTONS,
@@ -11,6 +11,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <time.h>
@@ -20,12 +21,21 @@
 #include "utils.h"
 #include "shaders.h"
 #include "opengl.h"
+#include "nullgl.h"
+#include "timing.h"
 #include "texture.h"
+#include "atlas.h"
 #include "asteroids.h"
 #include "renderer.h"
 #include "ui.h"
 #include "test.h"
 #include "editor.h"
+#include "bench.h"
+#include "renderthread.h"
+#include "capture.h"
+#include "assetpack.h"
+#include "texturestream.h"
+#include "simd.h"
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #include <stb_truetype.h>
@@ -53,9 +63,46 @@ struct FrameCtrl
 	bool rendererDoNotClear;
 };
 
+struct RunOptions
+{
+	bool headless;     // No window, GL calls go to the null backend and the frame rate is uncapped.
+	int frameCount;    // Frames to run in headless mode.
+	const char* bench; // Benchmark to run instead of the game, see bench.cpp.
+	bool bakeFont;     // Rebuild the font blob from the TTF and exit.
+	bool singleThread; // Draw on the main thread instead of a render thread.
+	const char* capture; // Write every frame's render commands to this file, see capture.h.
+	const char* replay;  // Replay a capture through the backend instead of running the game.
+	int startLevel;      // Level the headless run starts at.
+	bool cookAssets;     // Rebuild the asset pack from the loose files and exit.
+	bool textLayoutCache; // Reuse laid out text, off by default since it doesn't pay off for the HUD.
+};
+
+#define HEADLESS_DEFAULT_FRAMES 1000
+#define HEADLESS_DELTAT         (1.0f / 60.0f)
+#define MAX_FRAME_DELTAT        0.25f // Breakpoints and window drags shouldn't feed huge steps to the game.
+
+// Indexed by texture handle, packed into the atlas.
+static const char* const TexturePaths[TEXTURES_COUNT] =
+{
+	"../assets/textures/spacecraft.png",
+	"../assets/textures/RedShot.png",
+	"../assets/textures/ELI.png",
+	"../assets/textures/Asteroids.png",
+	"../assets/textures/BlueShot.png",
+	"../assets/textures/Exhaust.png",
+	"../assets/textures/ExplosionBig.png",
+	"../assets/textures/Explosion5.png",
+	"../assets/textures/ExplosionTiny.png",
+	"../assets/textures/Turret.png",
+};
+
 Vector2 ScreenDim = V2(900, 900);
 DbgPausedStateE DbgPausedState = DBG_PAUSED_NONE;
 GameModeE GameMode = GAMEMODE_GAME;
+static RunOptions Options = { false, HEADLESS_DEFAULT_FRAMES, nullptr, false, false, nullptr, nullptr, 1, false, false };
+static float FrameDeltaT = HEADLESS_DELTAT;
+static bool ShowRenderStats = false; // Per group backend stats overlay, toggled with F2.
+static Vector2 FramebufferDim = ScreenDim;
 
 static void GlfwErrorCallback(int error, const char* description)
 {
@@ -64,9 +111,9 @@ static void GlfwErrorCallback(int error, const char* description)
 
 static void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-	// Make sure the viewport matches the new window dimensions; note that width and 
+	// The viewport follows in OpenGLEndFrame, on the thread that owns the context. Note that width and
 	// height will be significantly larger than specified on retina displays.
-	glViewport(0, 0, width, height);
+	FramebufferDim = V2((float)width, (float)height);
 }
 
 static void BindButtons()
@@ -92,17 +139,15 @@ static void BindButtons()
 	GameInput_BindButton(BUTTON_END, GLFW_KEY_END);
 	GameInput_BindButton(BUTTON_LCTRL, GLFW_KEY_LEFT_CONTROL);
 	GameInput_BindButton(BUTTON_F1, GLFW_KEY_F1);
+	GameInput_BindButton(BUTTON_F2, GLFW_KEY_F2);
 	GameInput_BindButton(BUTTON_F10, GLFW_KEY_F10);
 	GameInput_BindButton(BUTTON_F11, GLFW_KEY_F11);
 }
 
+// Wall clock time of the last frame. Fixed when headless so runs are reproducible.
 static float GetDeltaT()
 {
-	GLFWmonitor* primaryMonitor = glfwGetPrimaryMonitor();
-	const GLFWvidmode* videoMode = glfwGetVideoMode(primaryMonitor);
-	int refreshRate = videoMode->refreshRate;
-
-	return 1.0f / refreshRate;
+	return FrameDeltaT;
 }
 
 static double r2()
@@ -120,6 +165,21 @@ void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 	EditorScrollCallback(yoffset);
 }
 
+// Stats of the last frame the backend handed back, GPU times lag a few frames behind.
+static void RenderStatsOverlay(const Renderer* renderer_p)
+{
+	const RenderFrame* frame_p = RendererGetLastDrawnFrame(renderer_p);
+	char buf[128];
+	for (int i = 0; i < frame_p->groupCnt; i++)
+	{
+		const RenderGroupStats* stats_p = &frame_p->groupStats[i];
+		const RenderBudgetStats* budgetStats_p = &renderer_p->renderGroups[i].budgetStats;
+		sprintf(buf, "%s: %.3f ms GPU, %u draws, %u verts, %.1f KB, peak %u verts %u inst", RenderGroupName(frame_p->renderGroups[i].renderGroupType),
+			stats_p->gpuMs, stats_p->drawCalls, stats_p->vertices, stats_p->bytesUploaded / 1024.0, budgetStats_p->peakVertices, budgetStats_p->peakInstances);
+		UILabel(buf, V2(0.01f, 0.06f + 0.025f * i), TEXT_ALIGN_LEFT, COLOR_YELLOW);
+	}
+}
+
 static FrameCtrl FrameMain(Renderer* renderer_p)
 {
 	FrameCtrl frame;
@@ -157,83 +217,282 @@ static FrameCtrl FrameMain(Renderer* renderer_p)
 		break;
 	}
 
+	if (GameInput_ButtonDown(BUTTON_F2)) ShowRenderStats = !ShowRenderStats;
+	if (ShowRenderStats) RenderStatsOverlay(renderer_p);
+
 	return frame;
 }
 
-int main(void)
+static void ParseArgs(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			Options.headless = true;
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && (i + 1) < argc)
+		{
+			Options.frameCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--bench") == 0 && (i + 1) < argc)
+		{
+			Options.bench = argv[++i];
+		}
+		else if (strcmp(argv[i], "--bake-font") == 0)
+		{
+			Options.bakeFont = true;
+		}
+		else if (strcmp(argv[i], "--single-thread") == 0)
+		{
+			Options.singleThread = true;
+		}
+		else if (strcmp(argv[i], "--capture") == 0 && (i + 1) < argc)
+		{
+			Options.capture = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && (i + 1) < argc)
+		{
+			Options.replay = argv[++i];
+		}
+		else if (strcmp(argv[i], "--level") == 0 && (i + 1) < argc)
+		{
+			Options.startLevel = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--cook-assets") == 0)
+		{
+			Options.cookAssets = true;
+			Options.headless = true; // The shaders only need to be read, not compiled by a driver.
+		}
+		else if (strcmp(argv[i], "--text-cache") == 0)
+		{
+			Options.textLayoutCache = true;
+		}
+		else
+		{
+			printf("ERROR: Unknown argument %s\n", argv[i]);
+		}
+	}
+}
+
+static void PrintHeadlessReport(const OpenGL* openGl_p, const Renderer* renderer_p, const RenderThreadStats* renderThreadStats_p, double startupMs, double tElapsed, U64 frameCnt)
 {
-	glfwSetErrorCallback(GlfwErrorCallback);
-	if (!glfwInit()) return -1;
+	NullGLStats stats = NullGLGetStats();
+	GameSimStats simStats = GameGetSimStats();
+	double frames = (double)(frameCnt ? frameCnt : 1);
+	printf("Headless: %llu frames in %.3f s, %.4f ms/frame, %.1f fps\n", (unsigned long long)frameCnt, tElapsed, 1000.0 * tElapsed / frames, frameCnt / tElapsed);
+	printf("  GL calls/frame %.1f, draw calls/frame %.1f, vertices/frame %.1f, buffer KB/frame %.1f\n",
+		stats.glCalls / frames, stats.drawCalls / frames, stats.verticesDrawn / frames, stats.bufferBytesMapped / frames / 1024.0);
+	printf("  last frame: backend GL calls %u, draw calls %u\n", openGl_p->lastFrameStats.glCalls, openGl_p->lastFrameStats.drawCalls);
+	if (renderThreadStats_p)
+	{
+		// Run serially the game would pay all of the render time, with the thread it only pays the waits.
+		double gameSeconds = renderThreadStats_p->wallSeconds - renderThreadStats_p->gameWaitSeconds;
+		double overlapSeconds = fmax(0.0, renderThreadStats_p->renderSeconds - renderThreadStats_p->gameWaitSeconds);
+		printf("  render thread: %llu frames drawn, game %.4f ms/frame, render %.4f ms/frame, game waited %.4f ms/frame, overlapped %.4f ms/frame (%.0f%% of render)\n", (unsigned long long)renderThreadStats_p->frames,
+			1000.0 * gameSeconds / frames, 1000.0 * renderThreadStats_p->renderSeconds / frames, 1000.0 * renderThreadStats_p->gameWaitSeconds / frames,
+			1000.0 * overlapSeconds / frames, renderThreadStats_p->renderSeconds > 0.0 ? 100.0 * overlapSeconds / renderThreadStats_p->renderSeconds : 0.0);
+	}
+	for (int i = 0; i < renderer_p->groupCnt; i++)
+	{
+		const RenderGroup* rendGrp_p = &renderer_p->renderGroups[i];
+		if (rendGrp_p->cullStats.visible + rendGrp_p->cullStats.culled == 0) continue;
+		printf("  cull %-10s visible/frame %.1f, culled/frame %.1f\n", RenderGroupName(rendGrp_p->renderGroupType),
+			rendGrp_p->cullStats.visible / frames, rendGrp_p->cullStats.culled / frames);
+	}
+	const RenderFrame* lastFrame_p = RendererGetLastDrawnFrame(renderer_p);
+	for (int i = 0; i < lastFrame_p->groupCnt; i++)
+	{
+		const RenderGroupStats* stats_p = &lastFrame_p->groupStats[i];
+		printf("  group %-10s gpu %.3f ms, draw calls %u, vertices %u, uploaded %.1f KB\n", RenderGroupName(lastFrame_p->renderGroups[i].renderGroupType),
+			stats_p->gpuMs, stats_p->drawCalls, stats_p->vertices, stats_p->bytesUploaded / 1024.0);
+	}
+	for (int i = 0; i < renderer_p->groupCnt; i++)
+	{
+		const RenderGroup* rendGrp_p = &renderer_p->renderGroups[i];
+		const RenderBudgetStats* budgetStats_p = &rendGrp_p->budgetStats;
+		printf("  budget %-10s peak vertices %u, indices %u, instances %u, entries %u, grows %u, dropped %llu\n", RenderGroupName(rendGrp_p->renderGroupType),
+			budgetStats_p->peakVertices, budgetStats_p->peakIndices, budgetStats_p->peakInstances, budgetStats_p->peakEntries,
+			budgetStats_p->grows, (unsigned long long)budgetStats_p->dropped);
+	}
+	printf("  stream segments vertex %u KB (grew %u), index %u KB (grew %u)\n", openGl_p->vertexStream.segmentSize / 1024, openGl_p->vertexStream.grows,
+		openGl_p->indexStream.segmentSize / 1024, openGl_p->indexStream.grows);
+	const FontLoadStats* fontStats_p = &renderer_p->textRendering.font.stats;
+	printf("  startup %.1f ms, font %s in %.2f ms, font atlas %dx%d %.1f KB, blob %.1f KB\n", startupMs, fontStats_p->built ? "built" : "mapped",
+		fontStats_p->loadMs, renderer_p->textRendering.font.texture.width, renderer_p->textRendering.font.texture.height,
+		fontStats_p->atlasBytes / 1024.0, fontStats_p->blobBytes / 1024.0);
+	printf("  sim ticks %llu, %.4f ms/tick, %s kernels\n", (unsigned long long)simStats.ticks, simStats.ticks ? 1000.0 * simStats.updateSeconds / simStats.ticks : 0.0,
+		SimdLevelName(SimdGetLevel()));
+
+	GamePoolStats poolStats[GAME_POOL_COUNT];
+	GameGetPoolStats(poolStats);
+	for (int i = 0; i < GAME_POOL_COUNT; i++)
+	{
+		printf("  pool %-16s peak %u/%u, allocs %llu, failures %llu\n", poolStats[i].name, poolStats[i].stats.peak, poolStats[i].capacity,
+			(unsigned long long)poolStats[i].stats.allocs, (unsigned long long)poolStats[i].stats.failures);
+	}
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	ParticleStats particleStats = GameGetParticleStats();
+	printf("  particles peak %u/%d, spawned %llu, dropped %llu\n", particleStats.peak, PARTICLES_MAX,
+		(unsigned long long)particleStats.spawned, (unsigned long long)particleStats.dropped);
 
-	GLFWwindow* window = glfwCreateWindow(ScreenDim.x, ScreenDim.y, "AsteroidsGL3", NULL, NULL);
-	if (window == NULL) return -1;
+	const TextLayoutStats* textStats_p = &renderer_p->textRendering.layoutCache.stats;
+	if (renderer_p->textRendering.useLayoutCache) printf("  text layout cache hits %llu, misses %llu, evictions %llu, skipped %llu, uncached %llu\n", (unsigned long long)textStats_p->hits,
+		(unsigned long long)textStats_p->misses, (unsigned long long)textStats_p->evictions, (unsigned long long)textStats_p->skipped,
+		(unsigned long long)textStats_p->uncached);
+}
 
-	glfwMakeContextCurrent(window);
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSwapInterval(1); // Enable vsync
+int main(int argc, char** argv)
+{
+	double tProgramStart = GetTime();
+	ParseArgs(argc, argv);
+	SimdInit();
+
+	if (Options.bench)
+	{
+		if (Bench(Options.bench)) return 0;
+		printf("ERROR: Unknown benchmark %s\n", Options.bench);
+		return -1;
+	}
 
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	if (Options.bakeFont) return RendererBakeFont() ? 0 : -1;
+	if (Options.replay) return RenderReplay(Options.replay, Options.frameCount) ? 0 : -1;
+
+	GLFWwindow* window = nullptr;
+	GLADloadproc loadProc = (GLADloadproc)NullGLGetProcAddress;
+	if (!Options.headless)
+	{
+		glfwSetErrorCallback(GlfwErrorCallback);
+		if (!glfwInit()) return -1;
+
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+		window = glfwCreateWindow(ScreenDim.x, ScreenDim.y, "AsteroidsGL3", NULL, NULL);
+		if (window == NULL) return -1;
+
+		glfwMakeContextCurrent(window);
+		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+		glfwSwapInterval(1); // Enable vsync
+		int framebufferWidth, framebufferHeight;
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		FramebufferDim = V2((float)framebufferWidth, (float)framebufferHeight);
+		loadProc = (GLADloadproc)glfwGetProcAddress;
+	}
+
+	if (!gladLoadGLLoader(loadProc))
 	{
 		printf("Failed to initialize GLAD\n");
 		return -1;
 	}
 
-	srand(time(NULL)); // Initialize random seed
+	// Fixed seed when headless so runs are comparable.
+	srand(Options.headless ? 1 : time(NULL)); // Initialize random seed
 
-	Texture textures[TEXTURES_COUNT] = { 0 };
-	textures[TEXTURE_SPACECRAFT] = LoadTexture("../assets/textures/Spacecraft.png");
-	textures[TEXTURE_REDSHOT] = LoadTexture("../assets/textures/RedShot.png");
-	textures[TEXTURE_ELI] = LoadTexture("../assets/textures/ELI.png");
-	textures[TEXTURE_ASTEROID] = LoadTexture("../assets/textures/Asteroids.png");
-	textures[TEXTURE_CHARGEDBULLET] = LoadTexture("../assets/textures/BlueShot.png");
-	textures[TEXTURE_SHIPEXHAUST] = LoadTexture("../assets/textures/Exhaust.png");
-	textures[TEXTURE_EXPLOSIONBIG] = LoadTexture("../assets/textures/ExplosionBig.png");
-	textures[TEXTURE_EXPLOSION5] = LoadTexture("../assets/textures/Explosion5.png");
-	textures[TEXTURE_EXPLOSIONSMALL] = LoadTexture("../assets/textures/ExplosionTiny.png");
-	textures[TEXTURE_TURRET] = LoadTexture("../assets/textures/turret.png");
+	// The atlas comes straight out of the asset pack. Without a pack, or with a stale one, the textures are
+	// decoded and packed again and a new pack is cooked once startup is done.
+	AssetPack assetPack = { 0 };
+	TextureAtlas atlas;
+	bool assetPackLoaded = !Options.cookAssets && AssetPackOpen(&assetPack, ASSET_PACK_PATH) && AssetPackGetAtlas(&assetPack, &atlas);
+	if (assetPackLoaded)
+	{
+		AssetPackMount(&assetPack);
+	}
+	else
+	{
+		AssetPackClose(&assetPack);
+		Texture textures[TEXTURES_COUNT] = { 0 };
+		LoadTextures(TexturePaths, TEXTURES_COUNT, textures);
+		atlas = AtlasBuild(textures, TEXTURES_COUNT, "../assets/textures/atlas.cache");
+		for (int i = 0; i < TEXTURES_COUNT; i++) FreeTexture(&textures[i]);
+	}
 
 	OpenGL openGl;
-	OpenGLInit(&openGl);
+	OpenGLInit(&openGl, loadProc);
+
+	OpenGLUploadTexture(&openGl, TEXTURE_ATLAS, &atlas.texture);
 
 	Renderer renderer;
 	RendererInit(&renderer);
+	renderer.textRendering.useLayoutCache = Options.textLayoutCache;
+	RendererSetTextureAtlas(&renderer, &atlas);
+	OpenGLUploadFontTexture(&openGl, &renderer.textRendering.font.texture);
+
+	if (!assetPackLoaded && AssetPackWrite(ASSET_PACK_PATH, &atlas, TexturePaths, TEXTURES_COUNT)) printf("Cooked asset pack %s\n", ASSET_PACK_PATH);
+	if (Options.cookAssets) return 0;
+
+	// Everything that can fail goes before the loader thread starts, returning after it would leave the thread running.
+	RenderCapture capture = { 0 };
+	if (Options.capture && !RenderCaptureOpen(&capture, Options.capture)) return -1;
+
+	TextureStream textureStream;
+	TextureStreamStart(&textureStream);
+	OpenGLSetTextureStream(&openGl, &textureStream);
 
 	GameInput_Init();
 	BindButtons();
-	ButtonState buttonStates[MAX_BUTTONS];
-	glfwSetInputMode(window, GLFW_STICKY_MOUSE_BUTTONS, GLFW_TRUE);
-	glfwSetCharCallback(window, CharCallback);
-	glfwSetScrollCallback(window, ScrollCallback);
+	ButtonState buttonStates[MAX_BUTTONS] = { RELEASED };
+	if (window)
+	{
+		glfwSetInputMode(window, GLFW_STICKY_MOUSE_BUTTONS, GLFW_TRUE);
+		glfwSetCharCallback(window, CharCallback);
+		glfwSetScrollCallback(window, ScrollCallback);
+	}
 
 	UIInit(&renderer);
 	GameInit();
 	EditorInit();
+	if (Options.headless) GameSkipMainMenu(Options.startLevel);
+
+	RenderThread renderThread;
+	if (!Options.singleThread) RenderThreadStart(&renderThread, &openGl, &renderer, window);
 
 	U64 frameCnt = 0;
-	while (!glfwWindowShouldClose(window))
+	double tStart = GetTime();
+	double startupMs = 1000.0 * (tStart - tProgramStart);
+	double tLastFrame = tStart;
+	while (Options.headless ? (frameCnt < (U64)Options.frameCount) : !glfwWindowShouldClose(window))
 	{
-	  for (int i = 0; i < MAX_BUTTONS; i++)
+	  double tNow = GetTime();
+	  if (!Options.headless) FrameDeltaT = (float)fmin(tNow - tLastFrame, MAX_FRAME_DELTAT);
+	  tLastFrame = tNow;
+
+	  double mouseXpos = 0, mouseYpos = 0;
+	  bool mouseLeft = false, mouseRight = false;
+	  if (window)
 	  {
-	    buttonStates[i] = (ButtonState) glfwGetKey(window, GameInput_GetBinding(i));
+	    for (int i = 0; i < MAX_BUTTONS; i++)
+	    {
+	      buttonStates[i] = (ButtonState) glfwGetKey(window, GameInput_GetBinding(i));
+	    }
+
+	    glfwGetCursorPos(window, &mouseXpos, &mouseYpos);
+	    mouseLeft = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+	    mouseRight = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
 	  }
-
-	  double mouseXpos, mouseYpos;
-	  glfwGetCursorPos(window, &mouseXpos, &mouseYpos);
-	  GameInput_NewFrame(buttonStates, glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS, glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS, V2(mouseXpos, mouseYpos), ScreenDim, GetDeltaT());
+	  GameInput_NewFrame(buttonStates, mouseLeft, mouseRight, V2(mouseXpos, mouseYpos), ScreenDim, GetDeltaT());
 	  UINewFrame(GetDeltaT(), ScreenDim);
 
 	  if (GameInput_ButtonDown(BUTTON_F1)) GameMode == GAMEMODE_GAME ? GameMode = GAMEMODE_EDITOR : GameMode = GAMEMODE_GAME;
 
 	  FrameCtrl frame = FrameMain(&renderer);
 
-	  OpenGLEndFrame(&openGl, &renderer, textures, ScreenDim);
-	  if (!frame.rendererDoNotClear) RendererEndFrame(&renderer);
-	  glfwSwapBuffers(window);
-	  glfwPollEvents();
+	  renderer.screenDim = ScreenDim;
+	  renderer.framebufferDim = FramebufferDim;
+	  RendererSortAndBatch(&renderer);
+	  RenderCaptureFrame(&capture, &renderer);
+	  if (!Options.singleThread)
+	  {
+	    RenderThreadSubmit(&renderThread, !frame.rendererDoNotClear);
+	  }
+	  else
+	  {
+	    RenderFrame* renderFrame_p = RendererSwapFrame(&renderer, (renderer.buildFrame + 1) % RENDER_FRAME_COUNT, !frame.rendererDoNotClear);
+	    OpenGLEndFrame(&openGl, renderFrame_p);
+	    if (window) glfwSwapBuffers(window);
+	  }
+	  if (window) glfwPollEvents();
 
 	  if      (DbgPausedState == DBG_PAUSED_FRAME)      DbgPausedState = DBG_PAUSED_FRAMEPLUS1;
 	  else if (DbgPausedState == DBG_PAUSED_FRAMEPLUS1) DbgPausedState = DBG_PAUSED_PAUSED;
@@ -243,6 +502,16 @@ int main(void)
 	  if (frame.quitApplication) break;
 	}
 
+	if (!Options.singleThread) RenderThreadStop(&renderThread);
+	TextureStreamStop(&textureStream);
+	RenderCaptureClose(&capture);
+
+	if (Options.headless)
+	{
+		PrintHeadlessReport(&openGl, &renderer, Options.singleThread ? nullptr : &renderThread.stats, startupMs, GetTime() - tStart, frameCnt);
+		return 0;
+	}
+
 	//stbi_image_free(data); //@nocommit
 
 	glfwDestroyWindow(window);
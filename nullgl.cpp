@@ -0,0 +1,549 @@
+#include <glad/glad.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "nullgl.h"
+
+#define MAX_NULLGL_BUFFERS  256
+#define MAX_NULLGL_BINDINGS 4
+
+struct NullBuffer
+{
+	U8* data_p;
+	GLsizeiptr size;
+	bool used;
+};
+
+struct NullGL
+{
+	NullGLStats stats;
+	GLuint nextName;  // Every object type but buffers, names only have to be unique and non zero.
+	U64 nextSync;
+	GLuint bindings[MAX_NULLGL_BINDINGS];
+	NullBuffer buffers[MAX_NULLGL_BUFFERS];
+};
+
+static NullGL nullGl = { {0}, 1, 1 };
+
+static int BindingIdx(GLenum target)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER:         return 0;
+	case GL_ELEMENT_ARRAY_BUFFER: return 1;
+	case GL_PIXEL_UNPACK_BUFFER:  return 2;
+	default:                      return 3;
+	}
+}
+
+// Null if nothing valid is bound, the call then does nothing like a GL_INVALID_OPERATION would.
+static NullBuffer* BoundBuffer(GLenum target)
+{
+	GLuint buffer = nullGl.bindings[BindingIdx(target)];
+	if (buffer == 0 || buffer >= MAX_NULLGL_BUFFERS || !nullGl.buffers[buffer].used) return NULL;
+	return &nullGl.buffers[buffer];
+}
+
+static GLuint GenName()
+{
+	return nullGl.nextName++;
+}
+
+// Buffer names index the buffer table, so deleted ones are reused. 0 when the table is full.
+static GLuint GenBufferName()
+{
+	for (GLuint name = 1; name < MAX_NULLGL_BUFFERS; name++)
+	{
+		if (nullGl.buffers[name].used) continue;
+		nullGl.buffers[name].used = true;
+		return name;
+	}
+	printf("ERROR: Null GL ran out of buffers, %d max\n", MAX_NULLGL_BUFFERS - 1);
+	return 0;
+}
+
+static U32 BytesPerPixel(GLenum format)
+{
+	switch (format)
+	{
+	case GL_RED:  return 1;
+	case GL_RG:   return 2;
+	case GL_RGB:  return 3;
+	default:      return 4;
+	}
+}
+
+//
+// Queries
+//
+static const GLubyte* APIENTRY NullGetString(GLenum name)
+{
+	nullGl.stats.glCalls++;
+	if (name == GL_VERSION) return (const GLubyte*)"3.3 Null";
+	return (const GLubyte*)"Null";
+}
+
+static const GLubyte* APIENTRY NullGetStringi(GLenum name, GLuint index)
+{
+	nullGl.stats.glCalls++;
+	return (const GLubyte*)"GL_NULL_backend";
+}
+
+static void APIENTRY NullGetIntegerv(GLenum pname, GLint* data)
+{
+	nullGl.stats.glCalls++;
+	*data = (pname == GL_NUM_EXTENSIONS) ? 1 : 0; // glad fails to load with no extensions at all.
+}
+
+static GLenum APIENTRY NullGetError()
+{
+	nullGl.stats.glCalls++;
+	return GL_NO_ERROR;
+}
+
+// Timer queries finish immediately and measure nothing.
+static void APIENTRY NullGenQueries(GLsizei n, GLuint* ids)
+{
+	nullGl.stats.glCalls++;
+	for (int i = 0; i < n; i++) ids[i] = GenName();
+}
+
+static void APIENTRY NullBeginQuery(GLenum target, GLuint id)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullEndQuery(GLenum target)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullGetQueryObjectiv(GLuint id, GLenum pname, GLint* params)
+{
+	nullGl.stats.glCalls++;
+	*params = (pname == GL_QUERY_RESULT_AVAILABLE) ? GL_TRUE : 0;
+}
+
+static void APIENTRY NullGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params)
+{
+	nullGl.stats.glCalls++;
+	*params = 0;
+}
+
+//
+// Buffers
+//
+static void APIENTRY NullGenVertexArrays(GLsizei n, GLuint* arrays)
+{
+	nullGl.stats.glCalls++;
+	for (int i = 0; i < n; i++) arrays[i] = GenName();
+}
+
+static void APIENTRY NullBindVertexArray(GLuint array)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullGenBuffers(GLsizei n, GLuint* buffers)
+{
+	nullGl.stats.glCalls++;
+	for (int i = 0; i < n; i++) buffers[i] = GenBufferName();
+}
+
+static void APIENTRY NullDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+	nullGl.stats.glCalls++;
+	for (int i = 0; i < n; i++)
+	{
+		if (buffers[i] == 0 || buffers[i] >= MAX_NULLGL_BUFFERS) continue;
+		free(nullGl.buffers[buffers[i]].data_p);
+		memset(&nullGl.buffers[buffers[i]], 0, sizeof(NullBuffer));
+		for (int b = 0; b < MAX_NULLGL_BINDINGS; b++) // Deleting unbinds it, as in GL.
+		{
+			if (nullGl.bindings[b] == buffers[i]) nullGl.bindings[b] = 0;
+		}
+	}
+}
+
+static void APIENTRY NullBindBuffer(GLenum target, GLuint buffer)
+{
+	nullGl.stats.glCalls++;
+	nullGl.bindings[BindingIdx(target)] = buffer;
+}
+
+static void APIENTRY NullBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+	nullGl.stats.glCalls++;
+	NullBuffer* buffer_p = BoundBuffer(target);
+	if (!buffer_p) return;
+	if (buffer_p->size != size)
+	{
+		buffer_p->data_p = (U8*)realloc(buffer_p->data_p, size);
+		buffer_p->size = size;
+	}
+	if (data) memcpy(buffer_p->data_p, data, size);
+}
+
+// Mapping hands out real memory so the streaming code writes to it exactly like with a driver.
+static void* APIENTRY NullMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+	nullGl.stats.glCalls++;
+	NullBuffer* buffer_p = BoundBuffer(target);
+	if (!buffer_p) return NULL;
+	assert(offset + length <= buffer_p->size);
+	nullGl.stats.bufferBytesMapped += length;
+	return buffer_p->data_p + offset;
+}
+
+static GLboolean APIENTRY NullUnmapBuffer(GLenum target)
+{
+	nullGl.stats.glCalls++;
+	return GL_TRUE;
+}
+
+static GLsync APIENTRY NullFenceSync(GLenum condition, GLbitfield flags)
+{
+	nullGl.stats.glCalls++;
+	return (GLsync)(uintptr_t)nullGl.nextSync++;
+}
+
+static GLenum APIENTRY NullClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+{
+	nullGl.stats.glCalls++;
+	return GL_ALREADY_SIGNALED;
+}
+
+static void APIENTRY NullDeleteSync(GLsync sync)
+{
+	nullGl.stats.glCalls++;
+}
+
+//
+// Shaders
+//
+static GLuint APIENTRY NullCreateShader(GLenum type)
+{
+	nullGl.stats.glCalls++;
+	return GenName();
+}
+
+static void APIENTRY NullShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullCompileShader(GLuint shader)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+	nullGl.stats.glCalls++;
+	*params = (pname == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+}
+
+static void APIENTRY NullGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+	nullGl.stats.glCalls++;
+	if (length) *length = 0;
+	if (bufSize > 0) infoLog[0] = '\0';
+}
+
+static void APIENTRY NullDeleteShader(GLuint shader)
+{
+	nullGl.stats.glCalls++;
+}
+
+static GLuint APIENTRY NullCreateProgram()
+{
+	nullGl.stats.glCalls++;
+	return GenName();
+}
+
+static void APIENTRY NullAttachShader(GLuint program, GLuint shader)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullLinkProgram(GLuint program)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+	nullGl.stats.glCalls++;
+	*params = 0;
+	if (pname == GL_LINK_STATUS) *params = GL_TRUE;
+	if (pname == GL_ACTIVE_UNIFORMS) *params = 1; // Every program reports just the transform.
+}
+
+static void APIENTRY NullGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+	nullGl.stats.glCalls++;
+	if (length) *length = 0;
+	if (bufSize > 0) infoLog[0] = '\0';
+}
+
+static void APIENTRY NullUseProgram(GLuint program)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+	nullGl.stats.glCalls++;
+	GLsizei written = (GLsizei)snprintf(name, bufSize, "transform");
+	if (length) *length = written;
+	*size = 1;
+	*type = GL_FLOAT_MAT4;
+}
+
+static GLint APIENTRY NullGetUniformLocation(GLuint program, const GLchar* name)
+{
+	nullGl.stats.glCalls++;
+	return 0;
+}
+
+static void APIENTRY NullUniform1i(GLint location, GLint v0)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullUniform1f(GLint location, GLfloat v0)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	nullGl.stats.glCalls++;
+}
+
+//
+// Textures
+//
+static void APIENTRY NullGenTextures(GLsizei n, GLuint* textures)
+{
+	nullGl.stats.glCalls++;
+	for (int i = 0; i < n; i++) textures[i] = GenName();
+}
+
+static void APIENTRY NullDeleteTextures(GLsizei n, const GLuint* textures)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullBindTexture(GLenum target, GLuint texture)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullPixelStorei(GLenum pname, GLint param)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+	nullGl.stats.glCalls++;
+	if (pixels) nullGl.stats.textureBytesUploaded += (U64)width * height * BytesPerPixel(format);
+}
+
+static void APIENTRY NullTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	nullGl.stats.glCalls++;
+	// With a pixel unpack buffer bound pixels is an offset into it.
+	if (pixels || nullGl.bindings[BindingIdx(GL_PIXEL_UNPACK_BUFFER)]) nullGl.stats.textureBytesUploaded += (U64)width * height * BytesPerPixel(format);
+}
+
+//
+// State
+//
+static void APIENTRY NullClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullClear(GLbitfield mask)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullEnable(GLenum cap)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullDisable(GLenum cap)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullPolygonMode(GLenum face, GLenum mode)
+{
+	nullGl.stats.glCalls++;
+}
+
+//
+// Vertex attributes and draws
+//
+static void APIENTRY NullVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullEnableVertexAttribArray(GLuint index)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullDisableVertexAttribArray(GLuint index)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullVertexAttribDivisor(GLuint index, GLuint divisor)
+{
+	nullGl.stats.glCalls++;
+}
+
+static void APIENTRY NullDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	nullGl.stats.glCalls++;
+	nullGl.stats.drawCalls++;
+	nullGl.stats.verticesDrawn += count;
+}
+
+static void APIENTRY NullDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	nullGl.stats.glCalls++;
+	nullGl.stats.drawCalls++;
+	nullGl.stats.verticesDrawn += count;
+}
+
+static void APIENTRY NullDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+{
+	nullGl.stats.glCalls++;
+	nullGl.stats.drawCalls++;
+	nullGl.stats.verticesDrawn += (U64)count * instancecount;
+}
+
+static void APIENTRY NullDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint basevertex)
+{
+	nullGl.stats.glCalls++;
+	nullGl.stats.drawCalls++;
+	nullGl.stats.verticesDrawn += count;
+}
+
+static void APIENTRY NullDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount)
+{
+	nullGl.stats.glCalls++;
+	nullGl.stats.drawCalls++;
+	nullGl.stats.verticesDrawn += (U64)count * instancecount;
+}
+
+struct NullProc
+{
+	const char* name;
+	void* proc_p;
+};
+
+// The static_cast fails to compile if a stub doesn't match the signature glad expects.
+#define NULL_PROC(_NAME, _PFN, _FN) { _NAME, (void*)static_cast<_PFN>(_FN) }
+
+static const NullProc nullProcs[] =
+{
+	NULL_PROC("glGetString",                PFNGLGETSTRINGPROC,                NullGetString),
+	NULL_PROC("glGetStringi",               PFNGLGETSTRINGIPROC,               NullGetStringi),
+	NULL_PROC("glGetIntegerv",              PFNGLGETINTEGERVPROC,              NullGetIntegerv),
+	NULL_PROC("glGetError",                 PFNGLGETERRORPROC,                 NullGetError),
+	NULL_PROC("glGenQueries",               PFNGLGENQUERIESPROC,               NullGenQueries),
+	NULL_PROC("glBeginQuery",               PFNGLBEGINQUERYPROC,               NullBeginQuery),
+	NULL_PROC("glEndQuery",                 PFNGLENDQUERYPROC,                 NullEndQuery),
+	NULL_PROC("glGetQueryObjectiv",         PFNGLGETQUERYOBJECTIVPROC,         NullGetQueryObjectiv),
+	NULL_PROC("glGetQueryObjectui64v",      PFNGLGETQUERYOBJECTUI64VPROC,      NullGetQueryObjectui64v),
+	NULL_PROC("glGenVertexArrays",          PFNGLGENVERTEXARRAYSPROC,          NullGenVertexArrays),
+	NULL_PROC("glBindVertexArray",          PFNGLBINDVERTEXARRAYPROC,          NullBindVertexArray),
+	NULL_PROC("glGenBuffers",               PFNGLGENBUFFERSPROC,               NullGenBuffers),
+	NULL_PROC("glDeleteBuffers",            PFNGLDELETEBUFFERSPROC,            NullDeleteBuffers),
+	NULL_PROC("glBindBuffer",               PFNGLBINDBUFFERPROC,               NullBindBuffer),
+	NULL_PROC("glBufferData",               PFNGLBUFFERDATAPROC,               NullBufferData),
+	NULL_PROC("glMapBufferRange",           PFNGLMAPBUFFERRANGEPROC,           NullMapBufferRange),
+	NULL_PROC("glUnmapBuffer",              PFNGLUNMAPBUFFERPROC,              NullUnmapBuffer),
+	NULL_PROC("glFenceSync",                PFNGLFENCESYNCPROC,                NullFenceSync),
+	NULL_PROC("glClientWaitSync",           PFNGLCLIENTWAITSYNCPROC,           NullClientWaitSync),
+	NULL_PROC("glDeleteSync",               PFNGLDELETESYNCPROC,               NullDeleteSync),
+	NULL_PROC("glCreateShader",             PFNGLCREATESHADERPROC,             NullCreateShader),
+	NULL_PROC("glShaderSource",             PFNGLSHADERSOURCEPROC,             NullShaderSource),
+	NULL_PROC("glCompileShader",            PFNGLCOMPILESHADERPROC,            NullCompileShader),
+	NULL_PROC("glGetShaderiv",              PFNGLGETSHADERIVPROC,              NullGetShaderiv),
+	NULL_PROC("glGetShaderInfoLog",         PFNGLGETSHADERINFOLOGPROC,         NullGetShaderInfoLog),
+	NULL_PROC("glDeleteShader",             PFNGLDELETESHADERPROC,             NullDeleteShader),
+	NULL_PROC("glCreateProgram",            PFNGLCREATEPROGRAMPROC,            NullCreateProgram),
+	NULL_PROC("glAttachShader",             PFNGLATTACHSHADERPROC,             NullAttachShader),
+	NULL_PROC("glLinkProgram",              PFNGLLINKPROGRAMPROC,              NullLinkProgram),
+	NULL_PROC("glGetProgramiv",             PFNGLGETPROGRAMIVPROC,             NullGetProgramiv),
+	NULL_PROC("glGetProgramInfoLog",        PFNGLGETPROGRAMINFOLOGPROC,        NullGetProgramInfoLog),
+	NULL_PROC("glUseProgram",               PFNGLUSEPROGRAMPROC,               NullUseProgram),
+	NULL_PROC("glGetActiveUniform",         PFNGLGETACTIVEUNIFORMPROC,         NullGetActiveUniform),
+	NULL_PROC("glGetUniformLocation",       PFNGLGETUNIFORMLOCATIONPROC,       NullGetUniformLocation),
+	NULL_PROC("glUniform1i",                PFNGLUNIFORM1IPROC,                NullUniform1i),
+	NULL_PROC("glUniform1f",                PFNGLUNIFORM1FPROC,                NullUniform1f),
+	NULL_PROC("glUniformMatrix4fv",         PFNGLUNIFORMMATRIX4FVPROC,         NullUniformMatrix4fv),
+	NULL_PROC("glGenTextures",              PFNGLGENTEXTURESPROC,              NullGenTextures),
+	NULL_PROC("glDeleteTextures",           PFNGLDELETETEXTURESPROC,           NullDeleteTextures),
+	NULL_PROC("glBindTexture",              PFNGLBINDTEXTUREPROC,              NullBindTexture),
+	NULL_PROC("glTexParameteri",            PFNGLTEXPARAMETERIPROC,            NullTexParameteri),
+	NULL_PROC("glPixelStorei",              PFNGLPIXELSTOREIPROC,              NullPixelStorei),
+	NULL_PROC("glTexImage2D",               PFNGLTEXIMAGE2DPROC,               NullTexImage2D),
+	NULL_PROC("glTexSubImage2D",            PFNGLTEXSUBIMAGE2DPROC,            NullTexSubImage2D),
+	NULL_PROC("glClearColor",               PFNGLCLEARCOLORPROC,               NullClearColor),
+	NULL_PROC("glClear",                    PFNGLCLEARPROC,                    NullClear),
+	NULL_PROC("glEnable",                   PFNGLENABLEPROC,                   NullEnable),
+	NULL_PROC("glDisable",                  PFNGLDISABLEPROC,                  NullDisable),
+	NULL_PROC("glBlendFunc",                PFNGLBLENDFUNCPROC,                NullBlendFunc),
+	NULL_PROC("glViewport",                 PFNGLVIEWPORTPROC,                 NullViewport),
+	NULL_PROC("glPolygonMode",              PFNGLPOLYGONMODEPROC,              NullPolygonMode),
+	NULL_PROC("glVertexAttribPointer",      PFNGLVERTEXATTRIBPOINTERPROC,      NullVertexAttribPointer),
+	NULL_PROC("glEnableVertexAttribArray",  PFNGLENABLEVERTEXATTRIBARRAYPROC,  NullEnableVertexAttribArray),
+	NULL_PROC("glDisableVertexAttribArray", PFNGLDISABLEVERTEXATTRIBARRAYPROC, NullDisableVertexAttribArray),
+	NULL_PROC("glVertexAttribDivisor",      PFNGLVERTEXATTRIBDIVISORPROC,      NullVertexAttribDivisor),
+	NULL_PROC("glDrawArrays",               PFNGLDRAWARRAYSPROC,               NullDrawArrays),
+	NULL_PROC("glDrawElements",             PFNGLDRAWELEMENTSPROC,             NullDrawElements),
+	NULL_PROC("glDrawElementsBaseVertex",   PFNGLDRAWELEMENTSBASEVERTEXPROC,   NullDrawElementsBaseVertex),
+	NULL_PROC("glDrawArraysInstanced",      PFNGLDRAWARRAYSINSTANCEDPROC,      NullDrawArraysInstanced),
+	NULL_PROC("glDrawElementsInstanced",    PFNGLDRAWELEMENTSINSTANCEDPROC,    NullDrawElementsInstanced),
+};
+
+// Anything not in the table stays null in glad, calling it crashes right away instead of silently doing nothing.
+void* NullGLGetProcAddress(const char* name)
+{
+	for (int i = 0; i < (int)ARRAY_COUNT(nullProcs); i++)
+	{
+		if (strcmp(nullProcs[i].name, name) == 0) return nullProcs[i].proc_p;
+	}
+	return nullptr;
+}
+
+NullGLStats NullGLGetStats()
+{
+	return nullGl.stats;
+}
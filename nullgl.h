@@ -0,0 +1,19 @@
+#pragma once
+
+#include "common.h"
+
+// Null OpenGL backend for running without a window or GPU. It implements the subset of GL 3.3 the
+// renderer uses, drops all rendering and only counts what was submitted. Load it with
+// gladLoadGLLoader(NullGLGetProcAddress) instead of the glfw loader.
+
+struct NullGLStats
+{
+	U64 glCalls;
+	U64 drawCalls;
+	U64 verticesDrawn; // Vertices (or indices) processed, instances included.
+	U64 bufferBytesMapped;
+	U64 textureBytesUploaded;
+};
+
+void* NullGLGetProcAddress(const char* name);
+NullGLStats NullGLGetStats();
@@ -8,16 +8,56 @@
 #include <glm/gtc/type_ptr.hpp>
 #include "opengl.h"
 #include "vector.h"	
+#include "timing.h"
+#include "assetpack.h"
+#include "texturestream.h"
 
 #define MAX_SHADERFILE_SIZE 10 * MB
+#define STREAM_ALIGNMENT    16
 
-static bool CompileShader(FILE* fileShader, unsigned int shader)
+// Per frame GL calls go through GL() so OpenGLFrameStats.glCalls counts them, e.g. GL(DrawArrays)(...).
+#define GL(fn) (openGl_p->frameStats.glCalls++, gl##fn)
+
+// GL 4.4 / ARB_buffer_storage, not part of the 3.3 core glad loader.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT   0x0080
+#endif
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+static PFNGLBUFFERSTORAGEPROC BufferStorage = nullptr;
+
+static ShaderProgram ShaderPrograms[MAX_SHADER_PROGRAMS];
+static int ShaderProgramCount = 0;
+
+// Shader code from the mounted asset pack, or read from the loose file when the pack doesn't have it.
+struct ShaderSource
+{
+	const GLchar* code;
+	GLint length;
+	U8* loaded_p; // Read from the loose file, nullptr when code points into the pack.
+};
+
+static bool ReadShaderSource(const char* path, ShaderSource* source_p)
+{
+	memset(source_p, 0, sizeof(*source_p));
+	U64 size = 0;
+	source_p->code = (const GLchar*)AssetPackFind(path, &size);
+	if (!source_p->code)
+	{
+		FILE* fileShader = fopen(path, "rb");
+		if (!fileShader) return false;
+		source_p->loaded_p = (U8*)malloc(MAX_SHADERFILE_SIZE);
+		size = fread(source_p->loaded_p, 1, MAX_SHADERFILE_SIZE, fileShader); assert(size < MAX_SHADERFILE_SIZE);
+		fclose(fileShader);
+		source_p->code = (const GLchar*)source_p->loaded_p;
+	}
+	source_p->length = (GLint)size;
+	return true;
+}
+
+static bool CompileShader(const ShaderSource* source_p, unsigned int shader)
 {
-	Buffer buffer = { 0 };
-	buffer.buf_p = (U8*)malloc(MAX_SHADERFILE_SIZE); memset(buffer.buf_p, 0, MAX_SHADERFILE_SIZE);
-	buffer.bufSize = fread(buffer.buf_p, 1, MAX_SHADERFILE_SIZE, fileShader); assert(buffer.bufSize <= MAX_SHADERFILE_SIZE);
-	const char* sourcecode = (const char*)buffer.buf_p;
-	glShaderSource(shader, 1, &sourcecode, NULL);
+	glShaderSource(shader, 1, &source_p->code, &source_p->length);
 	glCompileShader(shader);
 
 	// Check for shader compile errors
@@ -30,7 +70,6 @@ static bool CompileShader(FILE* fileShader, unsigned int shader)
 		return false;
 	}
 
-	free(buffer.buf_p);
 	return true;
 }
 
@@ -53,17 +92,39 @@ static bool LinkShaders(unsigned int shaderProgram, unsigned int vertexShader, u
 	return true;
 }
 
+static void ReflectUniforms(ShaderProgram* program_p)
+{
+	GLint activeUniforms = 0;
+	glGetProgramiv(program_p->id, GL_ACTIVE_UNIFORMS, &activeUniforms);
+	if (activeUniforms > MAX_SHADER_UNIFORMS) printf("WARNING: Shader program %u has %d uniforms, only %d are cached\n", program_p->id, activeUniforms, MAX_SHADER_UNIFORMS);
+
+	program_p->transformLoc = -1;
+	program_p->uniformCount = 0;
+	for (GLint i = 0; i < activeUniforms && i < MAX_SHADER_UNIFORMS; i++)
+	{
+		ShaderUniform* uniform_p = &program_p->uniforms[program_p->uniformCount++];
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(program_p->id, i, sizeof(uniform_p->name), nullptr, &size, &type, uniform_p->name);
+		uniform_p->location = glGetUniformLocation(program_p->id, uniform_p->name);
+		if (strcmp(uniform_p->name, "transform") == 0) program_p->transformLoc = uniform_p->location;
+	}
+}
+
 GLuint LoadAndCompileShaders(const char* vsPath, const char* fsPath)
 {
-	// Open shader files
-	FILE* fileVs = fopen(vsPath, "rb"); if (!fileVs) { printf("ERROR: Could not open shader %s\n", vsPath); return -1; }
-	FILE* fileFs = fopen(fsPath, "rb"); if (!fileFs) { printf("ERROR: Could not open shader %s\n", fsPath); return -1; }
+	// Read shader sources
+	ShaderSource vsSource, fsSource;
+	if (!ReadShaderSource(vsPath, &vsSource)) { printf("ERROR: Could not open shader %s\n", vsPath); return -1; }
+	if (!ReadShaderSource(fsPath, &fsSource)) { printf("ERROR: Could not open shader %s\n", fsPath); return -1; }
 
 	// Create and compile shaders
 	unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
 	unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	if (!CompileShader(fileVs, vertexShader)) { printf("ERROR::SHADER::VERTEX COMPILATION_FAILED\n"); return -1; }
-	if (!CompileShader(fileFs, fragmentShader)) { printf("ERROR::SHADER::FRAGMENT COMPILATION_FAILED\n"); return -1; }
+	if (!CompileShader(&vsSource, vertexShader)) { printf("ERROR::SHADER::VERTEX COMPILATION_FAILED\n"); return -1; }
+	if (!CompileShader(&fsSource, fragmentShader)) { printf("ERROR::SHADER::FRAGMENT COMPILATION_FAILED\n"); return -1; }
+	free(vsSource.loaded_p);
+	free(fsSource.loaded_p);
 
 	// Link shaders
 	unsigned int shaderProgram = glCreateProgram();
@@ -72,9 +133,34 @@ GLuint LoadAndCompileShaders(const char* vsPath, const char* fsPath)
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
 
+	assert(ShaderProgramCount < MAX_SHADER_PROGRAMS);
+	ShaderProgram* program_p = &ShaderPrograms[ShaderProgramCount++];
+	program_p->id = shaderProgram;
+	ReflectUniforms(program_p);
+
 	return shaderProgram;
 }
 
+const ShaderProgram* GetShaderProgram(GLuint shaderId)
+{
+	for (int i = 0; i < ShaderProgramCount; i++)
+	{
+		if (ShaderPrograms[i].id == shaderId) return &ShaderPrograms[i];
+	}
+	assert(false);
+	return nullptr;
+}
+
+GLint GetUniformLocation(GLuint shaderId, const char* name)
+{
+	const ShaderProgram* program_p = GetShaderProgram(shaderId);
+	for (int i = 0; i < program_p->uniformCount; i++)
+	{
+		if (strcmp(program_p->uniforms[i].name, name) == 0) return program_p->uniforms[i].location;
+	}
+	return -1;
+}
+
 void UseShader(unsigned int shaderId)
 {
 	glUseProgram(shaderId);
@@ -82,180 +168,585 @@ void UseShader(unsigned int shaderId)
 
 void SetBool(unsigned int shader, const char* name, bool value)
 {
-	//glUniform1i(glGetUniformLocation(shader, name, (int)value));
-	glUniform1i(glGetUniformLocation(shader, name), (int)value);
+	glUniform1i(GetUniformLocation(shader, name), (int)value);
 }
 
 void SetInt(unsigned int shader, const char* name, int value)
 {
-	glUniform1i(glGetUniformLocation(shader, name), value);
+	glUniform1i(GetUniformLocation(shader, name), value);
 }
 
 void SetFloat(unsigned int shader, const char* name, float value)
 {
-	glUniform1f(glGetUniformLocation(shader, name), value);
+	glUniform1f(GetUniformLocation(shader, name), value);
 }
 
-void OpenGLInit(OpenGL* openGL_p)
+static void CreateStreamBuffer(OpenGL* openGL_p, StreamBuffer* stream_p, GLenum target, U32 segmentSize)
 {
-	glGenVertexArrays(1, &openGL_p->VAO);
-	glGenBuffers(1, &openGL_p->VBO);
-	glGenBuffers(1, &openGL_p->EBO);
-	glBindVertexArray(openGL_p->VAO);
+	memset(stream_p, 0, sizeof(*stream_p));
+	stream_p->target = target;
+	stream_p->writeTarget = (target == GL_ELEMENT_ARRAY_BUFFER) ? GL_COPY_WRITE_BUFFER : target;
+	stream_p->segmentSize = segmentSize;
+
+	U32 size = segmentSize * STREAM_BUFFER_FRAMES;
+	GLenum writeTarget = stream_p->writeTarget;
+	glGenBuffers(1, &stream_p->buffer);
+	glBindBuffer(writeTarget, stream_p->buffer);
+	if (openGL_p->persistentMapping)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		BufferStorage(writeTarget, size, nullptr, flags);
+		stream_p->mapped_p = (U8*)glMapBufferRange(writeTarget, 0, size, flags);
+		assert(stream_p->mapped_p);
+	}
+	else
+	{
+		glBufferData(writeTarget, size, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+// Waits until the GPU is done with the segment this frame is going to overwrite.
+static void StreamBufferBeginFrame(OpenGL* openGl_p, StreamBuffer* stream_p)
+{
+	GLsync fence = stream_p->fences[stream_p->segment];
+	if (fence)
+	{
+		double tStart = GetTime();
+		GLenum result = GL(ClientWaitSync)(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		while (result == GL_TIMEOUT_EXPIRED) result = GL(ClientWaitSync)(fence, 0, 1000000000);
+		openGl_p->frameStats.fenceWaitMs += 1000.0 * (GetTime() - tStart);
+
+		GL(DeleteSync)(fence);
+		stream_p->fences[stream_p->segment] = 0;
+	}
+	stream_p->offset = 0;
+}
 
-	glGenTextures(1, &openGL_p->texture);
-	glBindTexture(GL_TEXTURE_2D, openGL_p->texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER); // Set texture wrapping.
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);      // Set texture filtering.
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+static void StreamBufferEndFrame(OpenGL* openGl_p, StreamBuffer* stream_p)
+{
+	stream_p->fences[stream_p->segment] = GL(FenceSync)(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	stream_p->segment = (stream_p->segment + 1) % STREAM_BUFFER_FRAMES;
 }
 
-void OpenGLEndFrame(OpenGL* openGl_p, const Renderer* renderer_p, Texture textures[], Vector2 screenDim)
+// Copies data into this frame's segment and returns its offset inside the GL buffer, a multiple of alignment.
+// Vertex data is aligned to its stride so the offset can be passed as a base vertex.
+static U32 StreamBufferWrite(OpenGL* openGl_p, StreamBuffer* stream_p, const void* data_p, U32 size, U32 alignment = STREAM_ALIGNMENT)
 {
-	//glClearColor(0.0f, 0.0f, 0.1f, 1.0f); 
-	//glClearColor(1.0f, 1.0f, 1.0f, 1.0f);   // White
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // Black
-	glClear(GL_COLOR_BUFFER_BIT);
+	U32 segmentStart = stream_p->segment * stream_p->segmentSize;
+	U32 bufferOffset = (segmentStart + stream_p->offset + alignment - 1) / alignment * alignment;
+	stream_p->offset = bufferOffset - segmentStart;
+	assert(stream_p->offset + size <= stream_p->segmentSize);
+	if (size == 0) return bufferOffset;
+
+	if (stream_p->mapped_p)
+	{
+		memcpy(stream_p->mapped_p + bufferOffset, data_p, size);
+	}
+	else
+	{
+		// The fence in StreamBufferBeginFrame already guarantees the GPU is done with this range.
+		GL(BindBuffer)(stream_p->writeTarget, stream_p->buffer);
+		void* dst_p = GL(MapBufferRange)(stream_p->writeTarget, bufferOffset, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+		assert(dst_p);
+		memcpy(dst_p, data_p, size);
+		GL(UnmapBuffer)(stream_p->writeTarget);
+	}
+
+	stream_p->offset += size;
+	openGl_p->frameStats.bufferBytesUploaded += size;
+	return bufferOffset;
+}
+
+// Attributes of the bound VAO, read from the bound GL_ARRAY_BUFFER. The normalized integer attributes of
+// the packed layout arrive in the shader as floats.
+static void SetColoredVertexAttribs(VertexLayoutE vertexLayout)
+{
+	if (vertexLayout == VERTEX_LAYOUT_PACKED)
+	{
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(PackedColoredVertex), (void*)OFFSET_OF(PackedColoredVertex, pos)); // position attribute
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedColoredVertex), (void*)OFFSET_OF(PackedColoredVertex, color)); // color attribute
+	}
+	else
+	{
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*)OFFSET_OF(ColoredVertex, pos)); // position attribute
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*)OFFSET_OF(ColoredVertex, color)); // color attribute
+	}
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+}
+
+// Indexed formats read from the start of the vertex stream, draws pick their vertices with a base vertex.
+static void CreateIndexedVertexArrays(OpenGL* openGL_p)
+{
+	glBindVertexArray(openGL_p->vaos[VERTEX_FORMAT_COLORED]);
+	glBindBuffer(GL_ARRAY_BUFFER, openGL_p->vertexStream.buffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, openGL_p->indexStream.buffer);
+	SetColoredVertexAttribs(VERTEX_LAYOUT_FLOAT);
+
+	glBindVertexArray(openGL_p->vaos[VERTEX_FORMAT_TEXTURED]);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, openGL_p->indexStream.buffer);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)OFFSET_OF(TexturedVertex, pos)); // position attribute
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)OFFSET_OF(TexturedVertex, color)); // color attribute
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)OFFSET_OF(TexturedVertex, uv)); // uv attribute
+	glEnableVertexAttribArray(2);
+
+	glBindVertexArray(openGL_p->vaos[VERTEX_FORMAT_COLORED_PACKED]);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, openGL_p->indexStream.buffer);
+	SetColoredVertexAttribs(VERTEX_LAYOUT_PACKED);
+
+	glBindVertexArray(openGL_p->vaos[VERTEX_FORMAT_TEXTURED_PACKED]);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, openGL_p->indexStream.buffer);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(PackedTexturedVertex), (void*)OFFSET_OF(PackedTexturedVertex, pos)); // position attribute
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedTexturedVertex), (void*)OFFSET_OF(PackedTexturedVertex, color)); // color attribute
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedTexturedVertex), (void*)OFFSET_OF(PackedTexturedVertex, uv)); // uv attribute
+	glEnableVertexAttribArray(2);
+}
+
+// No base instance in GL 3.3, so the instance attributes still get pointed at their data every frame. Only
+// the enables and divisors live in the VAO.
+static void CreateInstancedVertexArrays(OpenGL* openGL_p)
+{
+	glBindVertexArray(openGL_p->vaos[VERTEX_FORMAT_SPRITE]);
+	for (int attrib = 3; attrib <= 7; attrib++)
+	{
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribDivisor(attrib, 1);
+	}
+
+	glBindVertexArray(openGL_p->vaos[VERTEX_FORMAT_PARTICLE]);
+	for (int attrib = 3; attrib <= 5; attrib++)
+	{
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribDivisor(attrib, 1);
+	}
+}
+
+// Grown render groups can outgrow the segments. Rare, so everything in flight is waited for and the buffer
+// is created again with doubled segments. The indexed VAOs hold on to the old buffer and are set up again.
+static void StreamBufferReserve(OpenGL* openGl_p, StreamBuffer* stream_p, U32 size)
+{
+	if (size <= stream_p->segmentSize) return;
+
+	for (int i = 0; i < STREAM_BUFFER_FRAMES; i++)
+	{
+		if (!stream_p->fences[i]) continue;
+		while (GL(ClientWaitSync)(stream_p->fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+		GL(DeleteSync)(stream_p->fences[i]);
+	}
+	GL(BindBuffer)(stream_p->writeTarget, stream_p->buffer);
+	if (stream_p->mapped_p) GL(UnmapBuffer)(stream_p->writeTarget);
+	GL(DeleteBuffers)(1, &stream_p->buffer);
+
+	U32 segmentSize = stream_p->segmentSize;
+	while (segmentSize < size) segmentSize *= 2;
+	U32 grows = stream_p->grows + 1;
+	CreateStreamBuffer(openGl_p, stream_p, stream_p->target, segmentSize);
+	stream_p->grows = grows;
+	CreateIndexedVertexArrays(openGl_p);
+	printf("WARNING: Stream buffer segments grown to %u KB\n", segmentSize / 1024);
+}
+
+// Upper bound of what the frame writes to each stream, with room for aligning every write.
+static void FrameStreamSizes(const RenderFrame* frame_p, U32* vertexBytes_p, U32* indexBytes_p)
+{
+	U32 vertexBytes = 0;
+	U32 indexBytes = 0;
+	for (int i = 0; i < frame_p->groupCnt; i++)
+	{
+		const RenderCommands* renderCmds_p = &frame_p->renderGroups[i].renderCommands;
+		if (renderCmds_p->particleArray)      vertexBytes += renderCmds_p->instanceCount * sizeof(ParticleInstance) + STREAM_ALIGNMENT;
+		else if (renderCmds_p->instanceArray) vertexBytes += renderCmds_p->instanceCount * sizeof(SpriteInstance) + STREAM_ALIGNMENT;
+		else
+		{
+			vertexBytes += (renderCmds_p->vertexCount + 1) * RenderVertexSize(renderCmds_p);
+			indexBytes += renderCmds_p->indexCount * renderCmds_p->sortedIndexSize + STREAM_ALIGNMENT;
+		}
+	}
+	*vertexBytes_p = vertexBytes;
+	*indexBytes_p = indexBytes;
+}
+
+static GLuint CreateTexture(OpenGL* openGl_p, const Texture* texture_p);
+
+void OpenGLInit(OpenGL* openGL_p, GLADloadproc loadProc)
+{
+	memset(openGL_p, 0, sizeof(*openGL_p));
+
+	glGenVertexArrays(VERTEX_FORMAT_COUNT, openGL_p->vaos);
+	glBindVertexArray(openGL_p->vaos[VERTEX_FORMAT_COLORED]);
+
+	if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4))
+	{
+		BufferStorage = (PFNGLBUFFERSTORAGEPROC)loadProc("glBufferStorage");
+	}
+	openGL_p->persistentMapping = BufferStorage != nullptr;
+
+	CreateStreamBuffer(openGL_p, &openGL_p->vertexStream, GL_ARRAY_BUFFER, STREAM_VERTEX_SEGMENT_SIZE);
+	CreateStreamBuffer(openGL_p, &openGL_p->indexStream, GL_ELEMENT_ARRAY_BUFFER, STREAM_INDEX_SEGMENT_SIZE);
+	CreateIndexedVertexArrays(openGL_p);
+	CreateInstancedVertexArrays(openGL_p);
+	glGenQueries(GPU_QUERY_FRAMES * MAX_RENDER_GROUPS, &openGL_p->gpuTimers.queries[0][0]);
+
+	// Grey checker, obviously not final art.
+	static U8 placeholderPixels[2 * 2 * 4] = { 96, 96, 96, 255,  160, 160, 160, 255,  160, 160, 160, 255,  96, 96, 96, 255 };
+	Texture placeholder = { 2, 2, 4, placeholderPixels };
+	openGL_p->placeholderTexture = CreateTexture(openGL_p, &placeholder);
 
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+static GLuint CreateTexture(OpenGL* openGl_p, const Texture* texture_p)
+{
+	GLuint textureId;
+	GL(GenTextures)(1, &textureId);
+	GL(BindTexture)(GL_TEXTURE_2D, textureId);
+	GL(TexParameteri)(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER); // Set texture wrapping.
+	GL(TexParameteri)(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	GL(TexParameteri)(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);      // Set texture filtering.
+	GL(TexParameteri)(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	GLenum format = GL_RGBA;
+	if (texture_p->nrChannels == 3) format = GL_RGB;
+	if (texture_p->nrChannels == 1) format = GL_RED;
+	GL(PixelStorei)(GL_UNPACK_ALIGNMENT, 1); // Rows of RGB and single channel textures are not 4-byte aligned.
+	GL(TexImage2D)(GL_TEXTURE_2D, 0, format, texture_p->width, texture_p->height, 0, format, GL_UNSIGNED_BYTE, texture_p->data_p);
+
+	// No pixels only allocates the storage, callers fill it later.
+	if (texture_p->data_p) openGl_p->frameStats.textureBytesUploaded += (U64)texture_p->width * texture_p->height * texture_p->nrChannels;
+
+	return textureId;
+}
+
+void OpenGLUploadTexture(OpenGL* openGL_p, TextureHandleT textureHandle, const Texture* texture_p)
+{
+	assert(textureHandle >= 0 && textureHandle < MAX_TEXTURE_HANDLES);
+	if (openGL_p->textures[textureHandle]) glDeleteTextures(1, &openGL_p->textures[textureHandle]);
+	openGL_p->textures[textureHandle] = CreateTexture(openGL_p, texture_p);
+}
 
-	for (int i = 0; i < renderer_p->groupCnt; i++)
+void OpenGLUploadFontTexture(OpenGL* openGL_p, const Texture* fontTexture_p)
+{
+	assert(fontTexture_p->nrChannels == 1);
+	if (openGL_p->fontTexture) glDeleteTextures(1, &openGL_p->fontTexture);
+	openGL_p->fontTexture = CreateTexture(openGL_p, fontTexture_p);
+}
+
+void OpenGLSetTextureStream(OpenGL* openGL_p, TextureStream* textureStream_p)
+{
+	openGL_p->textureStream_p = textureStream_p;
+}
+
+// Takes the backend's steps of every streamed texture, none of them waits on the GPU or the loader.
+static void ServiceTextureStream(OpenGL* openGl_p, TextureStream* stream_p)
+{
+	for (int i = 0; i < MAX_STREAMED_TEXTURES; i++)
 	{
-		const RenderGroup* rendGrp_p = &renderer_p->renderGroups[i];
-		UseShader(rendGrp_p->shaderProgram);
+		StreamedTexture* tex_p = &stream_p->textures[i];
+		StreamedTextureGl* texGl_p = &openGl_p->streamedTextures[i];
+		TextureHandleT textureHandle = (TextureHandleT)(TEXTURE_STREAMED_FIRST + i);
+		GLsizeiptr size = (GLsizeiptr)tex_p->width * tex_p->height * 4;
 
-		const RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
+		switch (tex_p->state.load(std::memory_order_acquire))
+		{
+		case STREAMED_TEXTURE_SIZED:
+		{
+			GL(GenBuffers)(1, &texGl_p->pixelBuffer);
+			GL(BindBuffer)(GL_PIXEL_UNPACK_BUFFER, texGl_p->pixelBuffer);
+			GL(BufferData)(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+			tex_p->mapped_p = (U8*)GL(MapBufferRange)(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+			GL(BindBuffer)(GL_PIXEL_UNPACK_BUFFER, 0);
+			tex_p->state.store(STREAMED_TEXTURE_MAPPED, std::memory_order_release);
+			TextureStreamWake(stream_p);
+		}
+		break;
+		case STREAMED_TEXTURE_FILLED:
+		{
+			GL(BindBuffer)(GL_PIXEL_UNPACK_BUFFER, texGl_p->pixelBuffer);
+			GL(UnmapBuffer)(GL_PIXEL_UNPACK_BUFFER);
+			GL(BindBuffer)(GL_PIXEL_UNPACK_BUFFER, 0); // The storage is allocated empty, not sourced from the buffer.
+			tex_p->mapped_p = nullptr;
+
+			Texture storage = { tex_p->width, tex_p->height, 4, nullptr };
+			texGl_p->texture = CreateTexture(openGl_p, &storage);
+			GL(BindBuffer)(GL_PIXEL_UNPACK_BUFFER, texGl_p->pixelBuffer);
+			GL(TexSubImage2D)(GL_TEXTURE_2D, 0, 0, 0, tex_p->width, tex_p->height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0); // From the bound pixel buffer.
+			GL(BindBuffer)(GL_PIXEL_UNPACK_BUFFER, 0); // Other uploads read from client memory again.
+			openGl_p->frameStats.textureBytesUploaded += size;
+			texGl_p->fence = GL(FenceSync)(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			tex_p->state.store(STREAMED_TEXTURE_UPLOADING, std::memory_order_release);
+		}
+		break;
+		case STREAMED_TEXTURE_UPLOADING:
+		{
+			GLenum waitResult = GL(ClientWaitSync)(texGl_p->fence, 0, 0);
+			if (waitResult != GL_ALREADY_SIGNALED && waitResult != GL_CONDITION_SATISFIED) break;
+
+			GL(DeleteSync)(texGl_p->fence);
+			GL(DeleteBuffers)(1, &texGl_p->pixelBuffer);
+			texGl_p->fence = nullptr;
+			texGl_p->pixelBuffer = 0;
+			openGl_p->textures[textureHandle] = texGl_p->texture;
+			stream_p->stats.resident++;
+			stream_p->stats.bytesUploaded += size;
+			stream_p->stats.residentSeconds += GetTime() - tex_p->tRequested;
+			tex_p->state.store(STREAMED_TEXTURE_RESIDENT, std::memory_order_release);
+		}
+		break;
+		case STREAMED_TEXTURE_RELEASED:
+		{
+			if (texGl_p->texture) GL(DeleteTextures)(1, &texGl_p->texture);
+			texGl_p->texture = 0;
+			openGl_p->textures[textureHandle] = 0;
+			tex_p->state.store(STREAMED_TEXTURE_FREE, std::memory_order_release);
+		}
+		break;
+		default:
+		break;
+		}
+	}
+}
+
+static void DrawBatch(OpenGL* openGl_p, const RenderBatch* batch_p, U32 indexSize, U32 indexOffset, GLint baseVertex)
+{
+	GLenum indexType = indexSize == sizeof(U32) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+	GL(DrawElementsBaseVertex)(GL_TRIANGLES, batch_p->indexCount, indexType, (GLvoid*)(size_t)(indexOffset + batch_p->firstIndex * indexSize), baseVertex);
+	openGl_p->frameStats.drawCalls++;
+	openGl_p->frameStats.verticesDrawn += batch_p->indexCount;
+}
+
+// Reads the queries issued GPU_QUERY_FRAMES ago before their slot is reused. A result that still isn't
+// available is dropped rather than waited for, the group keeps its previous time.
+static void ReadGpuTimers(OpenGL* openGl_p)
+{
+	GpuTimerRing* timers_p = &openGl_p->gpuTimers;
+	for (int i = 0; i < MAX_RENDER_GROUPS; i++)
+	{
+		if (!timers_p->issued[timers_p->slot][i]) continue;
+		timers_p->issued[timers_p->slot][i] = false;
+
+		GLuint query = timers_p->queries[timers_p->slot][i];
+		GLint available = 0;
+		GL(GetQueryObjectiv)(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			openGl_p->frameStats.gpuQueriesMissed++;
+			continue;
+		}
+
+		GLuint64 elapsedNs = 0;
+		GL(GetQueryObjectui64v)(query, GL_QUERY_RESULT, &elapsedNs);
+		timers_p->gpuMs[i] = elapsedNs / 1000000.0;
+	}
+}
+
+static void SetTransform(OpenGL* openGl_p, const ShaderProgram* program_p, const glm::mat4& transMatrix)
+{
+	GL(UniformMatrix4fv)(program_p->transformLoc, 1, GL_FALSE, glm::value_ptr(transMatrix));
+}
+
+// The first draw of a mesh uploads it, meshes never change once created.
+static const StaticMeshGl* GetStaticMeshGl(OpenGL* openGl_p, const StaticMesh* meshes_p, StaticMeshHandleT handle)
+{
+	assert(handle >= 0 && handle < MAX_STATIC_MESHES);
+	StaticMeshGl* meshGl_p = &openGl_p->staticMeshes[handle];
+	if (meshGl_p->uploaded) return meshGl_p;
+
+	const StaticMesh* mesh_p = &meshes_p[handle];
+	U32 vertexBytes = mesh_p->vertexCount * (mesh_p->vertexLayout == VERTEX_LAYOUT_PACKED ? sizeof(PackedColoredVertex) : sizeof(ColoredVertex));
+	U32 indexBytes = mesh_p->indexCount * sizeof(U32);
+	GL(GenVertexArrays)(1, &meshGl_p->vao);
+	GL(BindVertexArray)(meshGl_p->vao);
+	GL(GenBuffers)(1, &meshGl_p->vertexBuffer);
+	GL(BindBuffer)(GL_ARRAY_BUFFER, meshGl_p->vertexBuffer);
+	GL(BufferData)(GL_ARRAY_BUFFER, vertexBytes, mesh_p->vertices_p, GL_STATIC_DRAW);
+	GL(GenBuffers)(1, &meshGl_p->indexBuffer);
+	GL(BindBuffer)(GL_ELEMENT_ARRAY_BUFFER, meshGl_p->indexBuffer);
+	GL(BufferData)(GL_ELEMENT_ARRAY_BUFFER, indexBytes, mesh_p->indices_p, GL_STATIC_DRAW);
+	SetColoredVertexAttribs(mesh_p->vertexLayout);
+
+	// Instance attributes of the later groups are pointed into the stream buffer.
+	GL(BindBuffer)(GL_ARRAY_BUFFER, openGl_p->vertexStream.buffer);
+	openGl_p->frameStats.bufferBytesUploaded += vertexBytes + indexBytes;
+	meshGl_p->uploaded = true;
+	return meshGl_p;
+}
+
+static void DrawStaticMeshes(OpenGL* openGl_p, const ShaderProgram* program_p, const RenderFrame* frame_p, const RenderCommands* renderCmds_p, const glm::mat4& projMatrix)
+{
+	for (U32 d = 0; d < renderCmds_p->staticDrawCount; d++)
+	{
+		const StaticMeshDraw* draw_p = &renderCmds_p->staticDraws[d];
+		const StaticMeshGl* meshGl_p = GetStaticMeshGl(openGl_p, frame_p->staticMeshes_p, draw_p->mesh);
+		U32 indexCount = frame_p->staticMeshes_p[draw_p->mesh].indexCount;
+
+		glm::mat4 transMatrix = glm::translate(projMatrix, glm::vec3(draw_p->offset.x, draw_p->offset.y, 0.0f));
+		transMatrix = glm::scale(transMatrix, glm::vec3(draw_p->scale, draw_p->scale, 1.0f));
+		SetTransform(openGl_p, program_p, transMatrix);
+
+		GL(BindVertexArray)(meshGl_p->vao);
+		GL(DrawElements)(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (GLvoid*)0);
+		openGl_p->frameStats.drawCalls++;
+		openGl_p->frameStats.verticesDrawn += indexCount;
+	}
+}
+
+void OpenGLEndFrame(OpenGL* openGl_p, RenderFrame* frame_p)
+{
+	int framebufferWidth = (int)frame_p->framebufferDim.x;
+	int framebufferHeight = (int)frame_p->framebufferDim.y;
+	if (framebufferWidth != openGl_p->viewportWidth || framebufferHeight != openGl_p->viewportHeight)
+	{
+		GL(Viewport)(0, 0, framebufferWidth, framebufferHeight);
+		openGl_p->viewportWidth = framebufferWidth;
+		openGl_p->viewportHeight = framebufferHeight;
+	}
+	Vector2 screenDim = frame_p->screenDim;
+
+	//glClearColor(0.0f, 0.0f, 0.1f, 1.0f);
+	//glClearColor(1.0f, 1.0f, 1.0f, 1.0f);   // White
+	GL(ClearColor)(0.0f, 0.0f, 0.0f, 1.0f); // Black
+	GL(Clear)(GL_COLOR_BUFFER_BIT);
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, openGl_p->EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, renderCmds_p->indexCount * sizeof(U32), renderCmds_p->indexArray, GL_DYNAMIC_DRAW);
+	U32 vertexBytes, indexBytes;
+	FrameStreamSizes(frame_p, &vertexBytes, &indexBytes);
+	StreamBufferReserve(openGl_p, &openGl_p->vertexStream, vertexBytes);
+	StreamBufferReserve(openGl_p, &openGl_p->indexStream, indexBytes);
 
+	if (openGl_p->textureStream_p) ServiceTextureStream(openGl_p, openGl_p->textureStream_p);
+
+	StreamBufferBeginFrame(openGl_p, &openGl_p->vertexStream);
+	StreamBufferBeginFrame(openGl_p, &openGl_p->indexStream);
+	GL(BindBuffer)(GL_ARRAY_BUFFER, openGl_p->vertexStream.buffer); // Instance attributes are pointed into it below.
+	ReadGpuTimers(openGl_p);
+
+	GpuTimerRing* timers_p = &openGl_p->gpuTimers;
+	for (int i = 0; i < frame_p->groupCnt; i++)
+	{
+		const RenderGroup* rendGrp_p = &frame_p->renderGroups[i];
+		const ShaderProgram* program_p = GetShaderProgram(rendGrp_p->shaderProgram);
+		OpenGLFrameStats statsBefore = openGl_p->frameStats;
+		GL(BeginQuery)(GL_TIME_ELAPSED, timers_p->queries[timers_p->slot][i]);
+		GL(UseProgram)(program_p->id);
+
+		const RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
 
 		switch (rendGrp_p->renderGroupType)
 		{
 		case RENDER_GROUP_SPRITES_DEFAULT:
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, openGl_p->VBO);
-			glBufferData(GL_ARRAY_BUFFER, renderCmds_p->vertexCount * sizeof(TexturedVertex), renderCmds_p->vertexArray, GL_DYNAMIC_DRAW);
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)OFFSET_OF(TexturedVertex, pos)); // position attribute
-			glEnableVertexAttribArray(0);
-			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)OFFSET_OF(TexturedVertex, color)); // color attribute
-			glEnableVertexAttribArray(1);
-			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)OFFSET_OF(TexturedVertex, uv)); // uv attribute
-			glEnableVertexAttribArray(2);
+			size_t instanceOffset = StreamBufferWrite(openGl_p, &openGl_p->vertexStream, renderCmds_p->sortedInstanceArray, renderCmds_p->instanceCount * sizeof(SpriteInstance));
+			GL(BindVertexArray)(openGl_p->vaos[VERTEX_FORMAT_SPRITE]);
 
 			// Matrix transform
 			glm::mat4 transMatrix = glm::mat4(1.0f);
 			transMatrix = glm::ortho(rendGrp_p->ortoProj.xmin, rendGrp_p->ortoProj.xmax, rendGrp_p->ortoProj.ymin, rendGrp_p->ortoProj.ymax, -1.0f, 1.0f);
-			unsigned int transformLoc = glGetUniformLocation(rendGrp_p->shaderProgram, "transform");
-			glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transMatrix));
+			SetTransform(openGl_p, program_p, transMatrix);
 
-			TextureHandleT textureHandle = -1;
-			int quadCount = renderCmds_p->vertexCount / 4;
-			int indexIndex = 0;
-			for (int quadIndex = 0; quadIndex < quadCount; quadIndex++)
+			for (U32 b = 0; b < renderCmds_p->batchCount; b++)
 			{
-				glBindTexture(GL_TEXTURE_2D, openGl_p->texture);
-				TexturedVertex* vert_p = &renderCmds_p->vertexArray[quadIndex * 4];
-				if (vert_p->textureHandle != textureHandle)
-				{
-					textureHandle = vert_p->textureHandle;
-					Texture* texture_p = &textures[textureHandle];			
-					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture_p->width, texture_p->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture_p->data_p);
-				}
-				//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-				glDrawElementsBaseVertex(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (GLvoid*)(indexIndex * sizeof(U16)), 0);
-				//glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-				indexIndex += 6;
+				const RenderBatch* batch_p = &renderCmds_p->batchArray[b];
+				assert(batch_p->textureHandle >= 0 && batch_p->textureHandle < MAX_TEXTURE_HANDLES);
+				GLuint texture = openGl_p->textures[batch_p->textureHandle];
+				GL(BindTexture)(GL_TEXTURE_2D, texture ? texture : openGl_p->placeholderTexture);
+
+				// No base instance in GL 3.3, so the attributes are pointed at the first instance of the batch.
+				size_t batchOffset = instanceOffset + batch_p->firstIndex * sizeof(SpriteInstance);
+				GL(VertexAttribPointer)(3, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(batchOffset + OFFSET_OF(SpriteInstance, pos))); // position attribute
+				GL(VertexAttribPointer)(4, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(batchOffset + OFFSET_OF(SpriteInstance, halfSize))); // half size attribute
+				GL(VertexAttribPointer)(5, 2, GL_SHORT, GL_TRUE, sizeof(SpriteInstance), (void*)(batchOffset + OFFSET_OF(SpriteInstance, facing))); // facing attribute
+				GL(VertexAttribPointer)(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteInstance), (void*)(batchOffset + OFFSET_OF(SpriteInstance, color))); // color attribute
+				GL(VertexAttribPointer)(7, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(SpriteInstance), (void*)(batchOffset + OFFSET_OF(SpriteInstance, uv))); // uv attribute
+				GL(DrawArraysInstanced)(GL_TRIANGLE_STRIP, 0, 4, batch_p->indexCount);
+				openGl_p->frameStats.drawCalls++;
+				openGl_p->frameStats.verticesDrawn += 4 * batch_p->indexCount;
 			}
 		}
 		break;
+		case RENDER_GROUP_PARTICLES:
+		{
+			if (renderCmds_p->instanceCount == 0) break;
+
+			size_t particleOffset = StreamBufferWrite(openGl_p, &openGl_p->vertexStream, renderCmds_p->particleArray, renderCmds_p->instanceCount * sizeof(ParticleInstance));
+			GL(BindVertexArray)(openGl_p->vaos[VERTEX_FORMAT_PARTICLE]);
+			GL(VertexAttribPointer)(3, 2, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)(particleOffset + OFFSET_OF(ParticleInstance, pos))); // position attribute
+			GL(VertexAttribPointer)(4, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)(particleOffset + OFFSET_OF(ParticleInstance, size))); // size attribute
+			GL(VertexAttribPointer)(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ParticleInstance), (void*)(particleOffset + OFFSET_OF(ParticleInstance, color))); // color attribute
+
+			// Matrix transform
+			glm::mat4 transMatrix = glm::mat4(1.0f);
+			transMatrix = glm::ortho(rendGrp_p->ortoProj.xmin, rendGrp_p->ortoProj.xmax, rendGrp_p->ortoProj.ymin, rendGrp_p->ortoProj.ymax, -1.0f, 1.0f);
+			SetTransform(openGl_p, program_p, transMatrix);
+
+			// Every live particle in one draw.
+			GL(DrawArraysInstanced)(GL_TRIANGLE_STRIP, 0, 4, renderCmds_p->instanceCount);
+			openGl_p->frameStats.drawCalls++;
+			openGl_p->frameStats.verticesDrawn += 4 * renderCmds_p->instanceCount;
+		}
+		break;
 		case RENDER_GROUP_UI:
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, openGl_p->VBO);
-			glBufferData(GL_ARRAY_BUFFER, renderCmds_p->vertexCount * sizeof(ColoredVertex), renderCmds_p->onlyColoredVertexArray, GL_DYNAMIC_DRAW);
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*)OFFSET_OF(ColoredVertex, pos)); // position attribute
-			glEnableVertexAttribArray(0);
-			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*)OFFSET_OF(ColoredVertex, color)); // color attribute
-			glEnableVertexAttribArray(1);
+			U32 indexOffset = StreamBufferWrite(openGl_p, &openGl_p->indexStream, renderCmds_p->sortedIndexArray, renderCmds_p->indexCount * renderCmds_p->sortedIndexSize);
+			U32 vertexSize = RenderVertexSize(renderCmds_p);
+			U32 vertexOffset = StreamBufferWrite(openGl_p, &openGl_p->vertexStream, renderCmds_p->onlyColoredVertexArray, renderCmds_p->vertexCount * vertexSize, vertexSize);
+			GL(BindVertexArray)(openGl_p->vaos[renderCmds_p->vertexLayout == VERTEX_LAYOUT_PACKED ? VERTEX_FORMAT_COLORED_PACKED : VERTEX_FORMAT_COLORED]);
 
 			// Matrix transform
 			glm::mat4 transMatrix = glm::mat4(1.0f);
 			transMatrix = glm::scale(transMatrix, glm::vec3(2.0f / screenDim.x, 2.0f / screenDim.y, 1.0f));
 			//transMatrix = glm::translate(transMatrix, glm::vec3(-1.0f, -1.0f, 1.0f)) * glm::scale(transMatrix, glm::vec3(2.0f, 2.0f, 1.0f));
 			//glm::mat4 projectionMatrix = glm::ortho(0.0f, 1.0f, 0.0f, 1.0f, -1.0f, 1.0f);
+			SetTransform(openGl_p, program_p, transMatrix);
 
-			unsigned int transformLoc = glGetUniformLocation(rendGrp_p->shaderProgram, "transform");
-			glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transMatrix));
-
-			int triangleCount = renderCmds_p->indexCount / 3;
-			int indexIndex = 0;
-			for (int i = 0; i < triangleCount; i++)
+			for (U32 b = 0; b < renderCmds_p->batchCount; b++)
 			{
-				//glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-				glDrawElementsBaseVertex(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, (GLvoid*)(indexIndex * sizeof(U16)), 0);
-				indexIndex += 3;
+				DrawBatch(openGl_p, &renderCmds_p->batchArray[b], renderCmds_p->sortedIndexSize, indexOffset, vertexOffset / vertexSize);
 			}
 		}
 		break;
 		case RENDER_GROUP_TEXT_DEFAULT:
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, openGl_p->VBO);
-			glBufferData(GL_ARRAY_BUFFER, renderCmds_p->vertexCount * sizeof(TexturedVertex), renderCmds_p->vertexArray, GL_DYNAMIC_DRAW);
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)OFFSET_OF(TexturedVertex, pos)); // position attribute
-			glEnableVertexAttribArray(0);
-			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)OFFSET_OF(TexturedVertex, color)); // color attribute
-			glEnableVertexAttribArray(1);
-			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)OFFSET_OF(TexturedVertex, uv)); // uv attribute
-			glEnableVertexAttribArray(2);
+			U32 indexOffset = StreamBufferWrite(openGl_p, &openGl_p->indexStream, renderCmds_p->sortedIndexArray, renderCmds_p->indexCount * renderCmds_p->sortedIndexSize);
+			U32 vertexSize = RenderVertexSize(renderCmds_p);
+			U32 vertexOffset = StreamBufferWrite(openGl_p, &openGl_p->vertexStream, renderCmds_p->vertexArray, renderCmds_p->vertexCount * vertexSize, vertexSize);
+			GL(BindVertexArray)(openGl_p->vaos[renderCmds_p->vertexLayout == VERTEX_LAYOUT_PACKED ? VERTEX_FORMAT_TEXTURED_PACKED : VERTEX_FORMAT_TEXTURED]);
 
 			// Matrix transform
 			// Note: Using a negative in the Y transform given how stb builds the quad.
 			glm::mat4 transMatrix = glm::mat4(1.0f);
 			transMatrix = glm::scale(transMatrix, glm::vec3(2.0f / screenDim.x, (-1) * 2.0f / screenDim.y, 1.0f));
-			unsigned int transformLoc = glGetUniformLocation(rendGrp_p->shaderProgram, "transform");
-			glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transMatrix));
+			SetTransform(openGl_p, program_p, transMatrix);
 
-			const Texture* textTexture_p = &renderer_p->textRendering.textTexture;
-			int quadCount = renderCmds_p->vertexCount / 4;
-			int indexIndex = 0;
-			for (int quadIndex = 0; quadIndex < quadCount; quadIndex++)
+			GL(BindTexture)(GL_TEXTURE_2D, openGl_p->fontTexture);
+			for (U32 b = 0; b < renderCmds_p->batchCount; b++)
 			{
-				glBindTexture(GL_TEXTURE_2D, openGl_p->texture);
-				TexturedVertex* vert_p = &renderCmds_p->vertexArray[quadIndex * 4];
-				glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, textTexture_p->width, textTexture_p->height, 0, GL_RED, GL_UNSIGNED_BYTE, textTexture_p->data_p);
-				//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-				glDrawElementsBaseVertex(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (GLvoid*)(indexIndex * sizeof(U16)), 0);
-				//glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-				indexIndex += 6;
+				DrawBatch(openGl_p, &renderCmds_p->batchArray[b], renderCmds_p->sortedIndexSize, indexOffset, vertexOffset / vertexSize);
 			}
 		}
 		break;
 		case RENDER_GROUP_WIREFRAME:
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, openGl_p->VBO);
-			glBufferData(GL_ARRAY_BUFFER, renderCmds_p->vertexCount * sizeof(ColoredVertex), renderCmds_p->onlyColoredVertexArray, GL_DYNAMIC_DRAW);
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*)OFFSET_OF(ColoredVertex, pos)); // position attribute
-			glEnableVertexAttribArray(0);
-			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*)OFFSET_OF(ColoredVertex, color)); // color attribute
-			glEnableVertexAttribArray(1);
+			U32 indexOffset = StreamBufferWrite(openGl_p, &openGl_p->indexStream, renderCmds_p->sortedIndexArray, renderCmds_p->indexCount * renderCmds_p->sortedIndexSize);
+			U32 vertexSize = RenderVertexSize(renderCmds_p);
+			U32 vertexOffset = StreamBufferWrite(openGl_p, &openGl_p->vertexStream, renderCmds_p->onlyColoredVertexArray, renderCmds_p->vertexCount * vertexSize, vertexSize);
+			GL(BindVertexArray)(openGl_p->vaos[renderCmds_p->vertexLayout == VERTEX_LAYOUT_PACKED ? VERTEX_FORMAT_COLORED_PACKED : VERTEX_FORMAT_COLORED]);
 
 			// Matrix transform
 			glm::mat4 transMatrix = glm::mat4(1.0f);
 			transMatrix = glm::ortho(rendGrp_p->ortoProj.xmin, rendGrp_p->ortoProj.xmax, rendGrp_p->ortoProj.ymin, rendGrp_p->ortoProj.ymax, -1.0f, 1.0f);
-			unsigned int transformLoc = glGetUniformLocation(rendGrp_p->shaderProgram, "transform");
-			glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transMatrix));
+			SetTransform(openGl_p, program_p, transMatrix);
 
-			int triangleCount = renderCmds_p->indexCount / 3;
-			int indexIndex = 0;
-			for (int i = 0; i < triangleCount; i++)
+			GL(PolygonMode)(GL_FRONT_AND_BACK, GL_LINE);
+			for (U32 b = 0; b < renderCmds_p->batchCount; b++)
 			{
-				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-				glDrawElementsBaseVertex(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, (GLvoid*)(indexIndex * sizeof(U16)), 0);
-				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-				indexIndex += 3;
+				DrawBatch(openGl_p, &renderCmds_p->batchArray[b], renderCmds_p->sortedIndexSize, indexOffset, vertexOffset / vertexSize);
 			}
+			DrawStaticMeshes(openGl_p, program_p, frame_p, renderCmds_p, transMatrix);
+			GL(PolygonMode)(GL_FRONT_AND_BACK, GL_FILL);
 		}
 		break;
 		default:
@@ -263,6 +754,20 @@ void OpenGLEndFrame(OpenGL* openGl_p, const Renderer* renderer_p, Texture textur
 		break;
 		};
 
+		GL(EndQuery)(GL_TIME_ELAPSED);
+		timers_p->issued[timers_p->slot][i] = true;
 
+		RenderGroupStats* groupStats_p = &frame_p->groupStats[i];
+		groupStats_p->gpuMs = timers_p->gpuMs[i];
+		groupStats_p->drawCalls = openGl_p->frameStats.drawCalls - statsBefore.drawCalls;
+		groupStats_p->vertices = openGl_p->frameStats.verticesDrawn - statsBefore.verticesDrawn;
+		groupStats_p->bytesUploaded = openGl_p->frameStats.bufferBytesUploaded - statsBefore.bufferBytesUploaded;
 	}
-}
+	timers_p->slot = (timers_p->slot + 1) % GPU_QUERY_FRAMES;
+
+	StreamBufferEndFrame(openGl_p, &openGl_p->vertexStream);
+	StreamBufferEndFrame(openGl_p, &openGl_p->indexStream);
+
+	openGl_p->lastFrameStats = openGl_p->frameStats;
+	memset(&openGl_p->frameStats, 0, sizeof(openGl_p->frameStats));
+}
\ No newline at end of file
@@ -4,15 +4,120 @@
 #include "texture.h"
 #include "renderer.h"
 
-struct OpenGL
+#define STREAM_BUFFER_FRAMES         3 // Frames in flight, each one writes to its own segment of the ring.
+#define STREAM_VERTEX_SEGMENT_SIZE   (8 * MB) // Sprites plus a full particle group take over 3 MB.
+#define STREAM_INDEX_SEGMENT_SIZE    (1 * MB)
+#define MAX_SHADER_PROGRAMS          16
+#define MAX_SHADER_UNIFORMS          16
+#define GPU_QUERY_FRAMES             4 // Timer queries are read back this many frames after they were issued.
+
+struct OpenGLFrameStats
+{
+	U32 glCalls;   // GL calls made by OpenGLEndFrame.
+	U32 drawCalls;
+	U32 verticesDrawn;
+	U64 textureBytesUploaded;
+	U64 bufferBytesUploaded;
+	double fenceWaitMs; // Time blocked waiting for the GPU to release the stream segment of this frame.
+	U32 gpuQueriesMissed; // Timer results still not available after GPU_QUERY_FRAMES, the group keeps its older gpuMs.
+};
+
+// GL_TIME_ELAPSED query per render group for each of the last GPU_QUERY_FRAMES frames.
+struct GpuTimerRing
+{
+	GLuint queries[GPU_QUERY_FRAMES][MAX_RENDER_GROUPS];
+	bool issued[GPU_QUERY_FRAMES][MAX_RENDER_GROUPS];
+	U32 slot;                          // Slot written this frame.
+	double gpuMs[MAX_RENDER_GROUPS];   // Latest result read back per group index.
+};
+
+struct ShaderUniform
 {
-	GLuint VAO;
-	GLuint VBO;
-	GLuint EBO;
+	char name[32];
+	GLint location;
+};
+
+// Linked program with its active uniforms, reflected once after linking so nothing is looked up by name per frame.
+struct ShaderProgram
+{
+	GLuint id;
+	GLint transformLoc; // -1 when the program has no transform uniform.
+	int uniformCount;
+	ShaderUniform uniforms[MAX_SHADER_UNIFORMS];
+};
+
+// One VAO per vertex layout. Attribute formats, enables and divisors are set up once in OpenGLInit.
+enum VertexFormatE
+{
+	VERTEX_FORMAT_COLORED,  // ColoredVertex, indexed.
+	VERTEX_FORMAT_TEXTURED, // TexturedVertex, indexed.
+	VERTEX_FORMAT_COLORED_PACKED,  // PackedColoredVertex, indexed.
+	VERTEX_FORMAT_TEXTURED_PACKED, // PackedTexturedVertex, indexed.
+	VERTEX_FORMAT_SPRITE,   // SpriteInstance, instanced.
+	VERTEX_FORMAT_PARTICLE, // ParticleInstance, instanced.
+	VERTEX_FORMAT_COUNT,
+};
+
+// Ring of STREAM_BUFFER_FRAMES segments. Every frame writes to its own segment and fences it, so the
+// CPU never writes memory the GPU may still be reading and the buffer is never orphaned.
+struct StreamBuffer
+{
+	GLenum target;
+	GLenum writeTarget; // Bound for writes. Binding GL_ELEMENT_ARRAY_BUFFER would change the bound VAO's index buffer.
+	GLuint buffer;
+	U32 segmentSize;
+	U32 segment;   // Segment written this frame.
+	U32 offset;    // Write offset within the segment.
+	U8* mapped_p;  // Persistent mapping of the whole buffer, nullptr when mapping per write.
+	GLsync fences[STREAM_BUFFER_FRAMES];
+	U32 grows;     // Times the segments were doubled because a frame didn't fit.
+};
+
+// GL side of a StaticMesh, created when the mesh is first drawn.
+struct StaticMeshGl
+{
+	bool uploaded;
+	GLuint vao;
+	GLuint vertexBuffer;
+	GLuint indexBuffer;
+};
+
+// GL side of a StreamedTexture while it is uploaded.
+struct StreamedTextureGl
+{
+	GLuint pixelBuffer;
 	GLuint texture;
+	GLsync fence;
+};
+
+struct TextureStream;
+
+struct OpenGL
+{
+	GLuint vaos[VERTEX_FORMAT_COUNT];
+	StreamBuffer vertexStream;
+	StreamBuffer indexStream;
+	bool persistentMapping; // GL 4.4 / ARB_buffer_storage available.
+	GLuint textures[MAX_TEXTURE_HANDLES]; // Indexed by TextureHandleT. Created once at load time, only bound per frame. Streamed ones are 0 until resident.
+	GLuint fontTexture;
+	int viewportWidth;  // Last glViewport, follows the framebuffer size of the frames drawn.
+	int viewportHeight;
+	GpuTimerRing gpuTimers;
+	StaticMeshGl staticMeshes[MAX_STATIC_MESHES];
+	TextureStream* textureStream_p;  // Serviced at the start of every frame, nullptr when nothing is streamed.
+	StreamedTextureGl streamedTextures[MAX_STREAMED_TEXTURES];
+	GLuint placeholderTexture;       // Bound for sprites whose texture isn't resident yet.
+
+	OpenGLFrameStats frameStats;     // Accumulated during the current frame.
+	OpenGLFrameStats lastFrameStats; // Stats of the last frame that went through OpenGLEndFrame.
 };
 
-void OpenGLInit(OpenGL* openGL_p);
+void OpenGLInit(OpenGL* openGL_p, GLADloadproc loadProc);
+void OpenGLUploadTexture(OpenGL* openGL_p, TextureHandleT textureHandle, const Texture* texture_p);
+void OpenGLUploadFontTexture(OpenGL* openGL_p, const Texture* fontTexture_p);
+void OpenGLSetTextureStream(OpenGL* openGL_p, TextureStream* textureStream_p);
 GLuint LoadAndCompileShaders(const char* vsPath, const char* fsPath);
+const ShaderProgram* GetShaderProgram(GLuint shaderId);
+GLint GetUniformLocation(GLuint shaderId, const char* name); // From the table reflected at link time, -1 when not active.
 void UseShader(unsigned int shaderId);
-void OpenGLEndFrame(OpenGL* openGl_p, const Renderer* renderer_p, Texture textures[], Vector2 screenDim);
+void OpenGLEndFrame(OpenGL* openGl_p, RenderFrame* frame_p); // Also fills frame_p->groupStats.
@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "utils.h"
+#include "particles.h"
+#include "simd.h"
+
+void ParticlesInit(ParticleSystem* system_p, int capacity)
+{
+	memset(system_p, 0, sizeof(*system_p));
+	system_p->capacity = capacity;
+	system_p->posX_p = (float*)malloc(capacity * sizeof(float));
+	system_p->posY_p = (float*)malloc(capacity * sizeof(float));
+	system_p->velX_p = (float*)malloc(capacity * sizeof(float));
+	system_p->velY_p = (float*)malloc(capacity * sizeof(float));
+	system_p->life_p = (float*)malloc(capacity * sizeof(float));
+	system_p->lifeRate_p = (float*)malloc(capacity * sizeof(float));
+	system_p->emitter_p = (U8*)malloc(capacity * sizeof(U8));
+	system_p->deadMask_p = (U32*)malloc(SIMD_MASK_WORDS(capacity) * sizeof(U32));
+}
+
+void ParticlesFree(ParticleSystem* system_p)
+{
+	free(system_p->posX_p);
+	free(system_p->posY_p);
+	free(system_p->velX_p);
+	free(system_p->velY_p);
+	free(system_p->life_p);
+	free(system_p->lifeRate_p);
+	free(system_p->emitter_p);
+	free(system_p->deadMask_p);
+	memset(system_p, 0, sizeof(*system_p));
+}
+
+void ParticlesClear(ParticleSystem* system_p)
+{
+	system_p->count = 0;
+	system_p->stats.live = 0;
+	for (int i = 0; i < system_p->emitterCount; i++) system_p->emitAccumulators[i] = 0.0f;
+}
+
+int ParticlesAddEmitter(ParticleSystem* system_p, const ParticleEmitter* emitter_p)
+{
+	assert(system_p->emitterCount < PARTICLES_MAX_EMITTERS);
+	assert(emitter_p->lifetime > 0.0f);
+
+	int emitter = system_p->emitterCount++;
+	system_p->emitters[emitter] = *emitter_p;
+	system_p->emitAccumulators[emitter] = 0.0f;
+	for (int i = 0; i < PARTICLES_COLOR_STEPS; i++)
+	{
+		float t = (float)i / (PARTICLES_COLOR_STEPS - 1);
+		Color color;
+		color.r = Lerp(emitter_p->colorStart.r, emitter_p->colorEnd.r, t);
+		color.g = Lerp(emitter_p->colorStart.g, emitter_p->colorEnd.g, t);
+		color.b = Lerp(emitter_p->colorStart.b, emitter_p->colorEnd.b, t);
+		color.a = Lerp(emitter_p->colorStart.a, emitter_p->colorEnd.a, t);
+		system_p->colorRamps[emitter][i] = ToColor32(color);
+	}
+	return emitter;
+}
+
+void ParticlesBurst(ParticleSystem* system_p, int emitter, Vector2 pos, Vector2 dirV, int count)
+{
+	assert(emitter >= 0 && emitter < system_p->emitterCount);
+	const ParticleEmitter* emitter_p = &system_p->emitters[emitter];
+
+	int room = system_p->capacity - system_p->count;
+	if (count > room)
+	{
+		system_p->stats.dropped += count - room;
+		count = room;
+	}
+
+	float dirRad = atan2f(dirV.y, dirV.x);
+	float coneRad = DegToRad(emitter_p->coneDeg);
+	float lifeRate = 1.0f / emitter_p->lifetime;
+	for (int i = 0; i < count; i++)
+	{
+		int p = system_p->count++;
+		float angle = dirRad + (GetRandomFloat01() - 0.5f) * coneRad;
+		float speed = emitter_p->speedMin + GetRandomFloat01() * (emitter_p->speedMax - emitter_p->speedMin);
+		float spawnAngle = GetRandomFloat01() * 2 * PI;
+
+		system_p->posX_p[p] = pos.x + emitter_p->spawnRadius * cosf(spawnAngle);
+		system_p->posY_p[p] = pos.y + emitter_p->spawnRadius * sinf(spawnAngle);
+		system_p->velX_p[p] = speed * cosf(angle);
+		system_p->velY_p[p] = speed * sinf(angle);
+		system_p->life_p[p] = 0.0f;
+		system_p->lifeRate_p[p] = lifeRate;
+		system_p->emitter_p[p] = (U8)emitter;
+	}
+
+	system_p->stats.spawned += count;
+	system_p->stats.live = system_p->count;
+	if (system_p->stats.live > system_p->stats.peak) system_p->stats.peak = system_p->stats.live;
+}
+
+void ParticlesEmit(ParticleSystem* system_p, int emitter, Vector2 pos, Vector2 dirV, float deltaT)
+{
+	assert(emitter >= 0 && emitter < system_p->emitterCount);
+	float* accumulator_p = &system_p->emitAccumulators[emitter];
+	*accumulator_p += system_p->emitters[emitter].rate * deltaT;
+	int count = (int)*accumulator_p;
+	*accumulator_p -= count;
+	if (count > 0) ParticlesBurst(system_p, emitter, pos, dirV, count);
+}
+
+void ParticlesUpdate(ParticleSystem* system_p, float deltaT)
+{
+	int count = system_p->count;
+	Simd.mulAdd(system_p->posX_p, system_p->velX_p, count, deltaT);
+	Simd.mulAdd(system_p->posY_p, system_p->velY_p, count, deltaT);
+	Simd.mulAdd(system_p->life_p, system_p->lifeRate_p, count, deltaT);
+	Simd.atLeast(system_p->life_p, count, 1.0f, system_p->deadMask_p);
+
+	// Swap-remove the dead ones in mask order, particle order doesn't matter. Dead ones at the end are
+	// dropped first, so whatever moves down is live. Bits at or past count belong to dropped particles.
+	const U32* deadMask_p = system_p->deadMask_p;
+	for (int w = 0; w < SIMD_MASK_WORDS(count); w++)
+	{
+		for (U32 bits = deadMask_p[w]; bits; bits &= bits - 1)
+		{
+			int i = 32 * w + SimdLowestBit(bits);
+			while (count > i && (deadMask_p[(count - 1) >> 5] & (1u << ((count - 1) & 31)))) count--;
+			if (i >= count) break;
+
+			count--;
+			system_p->posX_p[i] = system_p->posX_p[count];
+			system_p->posY_p[i] = system_p->posY_p[count];
+			system_p->velX_p[i] = system_p->velX_p[count];
+			system_p->velY_p[i] = system_p->velY_p[count];
+			system_p->life_p[i] = system_p->life_p[count];
+			system_p->lifeRate_p[i] = system_p->lifeRate_p[count];
+			system_p->emitter_p[i] = system_p->emitter_p[count];
+		}
+	}
+	system_p->count = count;
+	system_p->stats.live = count;
+}
+
+void ParticlesRender(const ParticleSystem* system_p, Renderer* renderer_p)
+{
+	if (system_p->count == 0) return;
+
+	ParticleInstance* instances_p = PushParticles(renderer_p, system_p->count);
+	if (!instances_p) return;
+	for (int i = 0; i < system_p->count; i++)
+	{
+		int emitter = system_p->emitter_p[i];
+		int step = (int)(system_p->life_p[i] * (PARTICLES_COLOR_STEPS - 1));
+		instances_p[i].pos = V2(system_p->posX_p[i], system_p->posY_p[i]);
+		instances_p[i].size = system_p->emitters[emitter].size;
+		instances_p[i].color = system_p->colorRamps[emitter][step];
+	}
+}
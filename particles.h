@@ -0,0 +1,66 @@
+#pragma once
+
+#include "common.h"
+#include "vector.h"
+#include "color.h"
+#include "renderer.h"
+
+#define PARTICLES_MAX            (1 << 17) // Room for 100k live particles, also the size of the renderer's particle group.
+#define PARTICLES_MAX_EMITTERS   16
+#define PARTICLES_COLOR_STEPS    32        // Color over life is baked into this many steps per emitter.
+
+// Emitters are plain data, the game describes each effect with one of these and registers it once.
+struct ParticleEmitter
+{
+	float rate;        // Particles per second for ParticlesEmit, bursts ignore it.
+	float lifetime;    // Seconds.
+	float speedMin;
+	float speedMax;
+	float coneDeg;     // Spread around the emit direction, 360 emits in every direction.
+	float spawnRadius; // Particles start on a circle of this radius around the emit position.
+	float size;
+	Color colorStart;  // Color over life goes linearly from colorStart to colorEnd.
+	Color colorEnd;
+};
+
+struct ParticleStats
+{
+	U32 live;
+	U32 peak;
+	U64 spawned;
+	U64 dropped; // Spawns refused because the system was full.
+};
+
+// Particles stored as one array per field and kept packed, dead particles are swap-removed.
+// The update runs the Simd kernels over the float arrays.
+struct ParticleSystem
+{
+	int capacity;
+	int count;
+
+	float* posX_p;
+	float* posY_p;
+	float* velX_p;
+	float* velY_p;
+	float* life_p;     // Normalized age, 0 when spawned and dead once it reaches 1.
+	float* lifeRate_p; // 1 / lifetime of the emitter.
+	U8* emitter_p;
+	U32* deadMask_p;   // Scratch for the update, one bit per particle.
+
+	int emitterCount;
+	ParticleEmitter emitters[PARTICLES_MAX_EMITTERS];
+	float emitAccumulators[PARTICLES_MAX_EMITTERS]; // Fractional particles carried over by ParticlesEmit.
+	Color32 colorRamps[PARTICLES_MAX_EMITTERS][PARTICLES_COLOR_STEPS];
+
+	ParticleStats stats;
+};
+
+void ParticlesInit(ParticleSystem* system_p, int capacity);
+void ParticlesFree(ParticleSystem* system_p);
+void ParticlesClear(ParticleSystem* system_p); // Kills every particle, emitters and stats other than live are kept.
+int ParticlesAddEmitter(ParticleSystem* system_p, const ParticleEmitter* emitter_p);
+
+void ParticlesBurst(ParticleSystem* system_p, int emitter, Vector2 pos, Vector2 dirV, int count);
+void ParticlesEmit(ParticleSystem* system_p, int emitter, Vector2 pos, Vector2 dirV, float deltaT); // Spawns emitter rate * deltaT particles.
+void ParticlesUpdate(ParticleSystem* system_p, float deltaT);
+void ParticlesRender(const ParticleSystem* system_p, Renderer* renderer_p);
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "common.h"
+
+// Handle to a pool item: slot index in the low 16 bits, slot generation in the high 16 bits. Freeing a slot
+// bumps its generation, so handles to a freed item stop resolving instead of aliasing whatever reuses the slot.
+typedef U32 PoolHandle;
+
+#define POOL_HANDLE_NONE 0 // Generations start at 1, so this never resolves.
+#define POOL_FREE_END    U32_MAX
+#define POOL_MAX_SLOTS   (U16_MAX + 1)
+
+struct PoolStats
+{
+	U32 live;
+	U32 peak;     // Most items live at once, what the capacity should be sized from.
+	U64 allocs;
+	U64 failures; // Allocations refused because the pool was full and couldn't grow.
+};
+
+struct PoolSlot
+{
+	U16 generation;
+	bool live;
+	U32 nextFree; // Free list link, only meaningful while the slot is free.
+};
+
+// Fixed capacity pool with O(1) alloc and free. Free slots are chained through the slot table, most
+// recently freed first. A pool created with maxCapacity > capacity doubles its storage when it runs out.
+template <typename T>
+struct Pool
+{
+	U32 capacity;
+	U32 maxCapacity;
+	U32 used;     // Slots handed out at least once, slots past this are not on the free list yet.
+	U32 freeHead;
+	T* items_p;
+	PoolSlot* slots_p;
+	PoolStats stats;
+};
+
+static inline U32 PoolIndex(PoolHandle handle)
+{
+	return handle & 0xffff;
+}
+
+template <typename T>
+void PoolInit(Pool<T>* pool_p, U32 capacity, U32 maxCapacity = 0)
+{
+	if (maxCapacity < capacity) maxCapacity = capacity;
+	assert(capacity > 0 && maxCapacity <= POOL_MAX_SLOTS);
+
+	pool_p->capacity = capacity;
+	pool_p->maxCapacity = maxCapacity;
+	pool_p->used = 0;
+	pool_p->freeHead = POOL_FREE_END;
+	pool_p->items_p = (T*)calloc(capacity, sizeof(T));
+	pool_p->slots_p = (PoolSlot*)calloc(capacity, sizeof(PoolSlot));
+	pool_p->stats = { 0 };
+}
+
+template <typename T>
+void PoolDestroy(Pool<T>* pool_p)
+{
+	free(pool_p->items_p);
+	free(pool_p->slots_p);
+	*pool_p = { 0 };
+}
+
+// Frees every item, stats other than live are kept so they cover the whole run.
+template <typename T>
+void PoolClear(Pool<T>* pool_p)
+{
+	for (U32 i = 0; i < pool_p->used; i++)
+	{
+		if (pool_p->slots_p[i].live) pool_p->slots_p[i].generation++;
+		pool_p->slots_p[i].live = false;
+	}
+	pool_p->used = 0;
+	pool_p->freeHead = POOL_FREE_END;
+	pool_p->stats.live = 0;
+}
+
+template <typename T>
+static bool PoolGrow(Pool<T>* pool_p)
+{
+	if (pool_p->capacity >= pool_p->maxCapacity) return false;
+
+	U32 capacity = 2 * pool_p->capacity;
+	if (capacity > pool_p->maxCapacity) capacity = pool_p->maxCapacity;
+	pool_p->items_p = (T*)realloc(pool_p->items_p, capacity * sizeof(T));
+	pool_p->slots_p = (PoolSlot*)realloc(pool_p->slots_p, capacity * sizeof(PoolSlot));
+	assert(pool_p->items_p && pool_p->slots_p);
+	memset(&pool_p->items_p[pool_p->capacity], 0, (capacity - pool_p->capacity) * sizeof(T));
+	memset(&pool_p->slots_p[pool_p->capacity], 0, (capacity - pool_p->capacity) * sizeof(PoolSlot));
+	pool_p->capacity = capacity;
+	return true;
+}
+
+// Returns POOL_HANDLE_NONE when the pool is full, the item keeps whatever it held when it was last freed.
+template <typename T>
+PoolHandle PoolAlloc(Pool<T>* pool_p)
+{
+	U32 index = pool_p->freeHead;
+	if (index != POOL_FREE_END)
+	{
+		pool_p->freeHead = pool_p->slots_p[index].nextFree;
+	}
+	else
+	{
+		if (pool_p->used == pool_p->capacity && !PoolGrow(pool_p))
+		{
+			pool_p->stats.failures++;
+			return POOL_HANDLE_NONE;
+		}
+		index = pool_p->used++;
+	}
+
+	PoolSlot* slot_p = &pool_p->slots_p[index];
+	if (slot_p->generation == 0) slot_p->generation = 1;
+	slot_p->live = true;
+
+	pool_p->stats.allocs++;
+	pool_p->stats.live++;
+	if (pool_p->stats.live > pool_p->stats.peak) pool_p->stats.peak = pool_p->stats.live;
+	return ((U32)slot_p->generation << 16) | index;
+}
+
+template <typename T>
+bool PoolIsValid(const Pool<T>* pool_p, PoolHandle handle)
+{
+	U32 index = PoolIndex(handle);
+	if (index >= pool_p->used) return false;
+	const PoolSlot* slot_p = &pool_p->slots_p[index];
+	return slot_p->live && (slot_p->generation == (handle >> 16));
+}
+
+// Null when the handle is stale.
+template <typename T>
+T* PoolGet(Pool<T>* pool_p, PoolHandle handle)
+{
+	return PoolIsValid(pool_p, handle) ? &pool_p->items_p[PoolIndex(handle)] : nullptr;
+}
+
+// Stale handles are ignored, so freeing the same item twice is harmless.
+template <typename T>
+void PoolFree(Pool<T>* pool_p, PoolHandle handle)
+{
+	if (!PoolIsValid(pool_p, handle)) return;
+
+	U32 index = PoolIndex(handle);
+	PoolSlot* slot_p = &pool_p->slots_p[index];
+	slot_p->live = false;
+	slot_p->generation++;
+	if (slot_p->generation == 0) slot_p->generation = 1;
+	slot_p->nextFree = pool_p->freeHead;
+	pool_p->freeHead = index;
+	pool_p->stats.live--;
+}
+
+// Handle of the item currently in the slot, for walking the pool by index.
+template <typename T>
+PoolHandle PoolHandleAt(const Pool<T>* pool_p, U32 index)
+{
+	const PoolSlot* slot_p = &pool_p->slots_p[index];
+	return slot_p->live ? (((U32)slot_p->generation << 16) | index) : POOL_HANDLE_NONE;
+}
@@ -12,15 +12,23 @@
 #include "rect.h"
 #include "color.h"
 
-#define MAX_SPRITE_QUADS    (1 << 8)
-#define MAX_TEXT_QUADS      (1 << 8)
-#define MAX_UI_QUADS        (1 << 8)
-#define MAX_WIREFRAME_QUADS (1 << 12)
-
-static U8 ttfBuffer[1 << 20];
-
-static RenderGroup CreateRendererGroup(RenderGroupTypeE rendererGroupType, int shaderProgram, int maxQuads, bool onlyColored = false);
+// Limits, groups start at 1 / RENDER_GROUP_INITIAL_DIV of them and double on demand.
+#define MAX_SPRITE_QUADS    (1 << 16) // Instanced, 32 bytes each.
+#define MAX_TEXT_QUADS      (1 << 16)
+#define MAX_UI_QUADS        (1 << 12)
+#define MAX_WIREFRAME_QUADS (1 << 16) // 256k vertices, past 64k the group draws with 32-bit indices.
+#define MAX_PARTICLES       (1 << 17) // Instanced, 16 bytes each. Same as PARTICLES_MAX.
+#define RENDER_GROUP_INITIAL_DIV 16
+#define FONT_BLOB_PATH      "../assets/font.sdf"
+
+// Headless runs happen on Linux boxes without the Windows fonts.
+static const char* const fontPaths[] = { "C:/Windows/Fonts/consola.ttf", "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf" };
+
+static RenderGroup CreateRendererGroup(RenderGroupTypeE rendererGroupType, int shaderProgram, int maxQuads, VertexLayoutE vertexLayout, bool onlyColored = false);
+static RenderGroup CreateInstancedRendererGroup(RenderGroupTypeE rendererGroupType, int shaderProgram, int maxInstances);
+static RenderGroup CreateParticleRendererGroup(RenderGroupTypeE rendererGroupType, int shaderProgram, int maxParticles);
 static RenderGroup* FindRenderGroup(Renderer* renderer_p, RenderGroupTypeE rendererGroupType);
+static void PushRenderEntry(RenderCommands* renderCmds_p, RenderLayerE layer, TextureHandleT textureHandle, U32 firstIndex, U32 indexCount);
 
 Renderer* rendererGl_p = nullptr;
 
@@ -34,36 +42,170 @@ void RendererInit(Renderer* renderer_p)
 	//
 	int wireframeShaderProgram = LoadAndCompileShaders("../shaders/wireframe_shader.vs", "../shaders/wireframe_shader.fs");
 	assert(wireframeShaderProgram >= 0);
-	renderer_p->renderGroups[0] = CreateRendererGroup(RENDER_GROUP_WIREFRAME, wireframeShaderProgram, MAX_WIREFRAME_QUADS, true);
-
-	int spriteShaderProgram = LoadAndCompileShaders("../shaders/vertex_shader.vs", "../shaders/sprites_shader.fs");
+	int particleShaderProgram = LoadAndCompileShaders("../shaders/particle_shader.vs", "../shaders/particle_shader.fs");
+	assert(particleShaderProgram >= 0);
+	int spriteShaderProgram = LoadAndCompileShaders("../shaders/sprite_shader.vs", "../shaders/sprites_shader.fs");
 	assert(spriteShaderProgram >= 0);
-	renderer_p->renderGroups[1] = CreateRendererGroup(RENDER_GROUP_SPRITES_DEFAULT, spriteShaderProgram, MAX_SPRITE_QUADS);
-
 	int uiShaderProgram = LoadAndCompileShaders("../shaders/wireframe_shader.vs", "../shaders/wireframe_shader.fs");
 	assert(uiShaderProgram >= 0);
-	renderer_p->renderGroups[2] = CreateRendererGroup(RENDER_GROUP_UI, uiShaderProgram, MAX_UI_QUADS, true);
-
 	int textShaderProgram = LoadAndCompileShaders("../shaders/vertex_shader.vs", "../shaders/text_shader.fs");
 	assert(textShaderProgram >= 0);
-	renderer_p->renderGroups[3] = CreateRendererGroup(RENDER_GROUP_TEXT_DEFAULT, textShaderProgram, MAX_TEXT_QUADS);
 
-	renderer_p->groupCnt = 4;
+	for (int f = 0; f < RENDER_FRAME_COUNT; f++)
+	{
+		RenderFrame* frame_p = &renderer_p->frames[f];
+		frame_p->renderGroups[0] = CreateRendererGroup(RENDER_GROUP_WIREFRAME, wireframeShaderProgram, MAX_WIREFRAME_QUADS, VERTEX_LAYOUT_PACKED, true);
+		frame_p->renderGroups[1] = CreateParticleRendererGroup(RENDER_GROUP_PARTICLES, particleShaderProgram, MAX_PARTICLES);
+		frame_p->renderGroups[2] = CreateInstancedRendererGroup(RENDER_GROUP_SPRITES_DEFAULT, spriteShaderProgram, MAX_SPRITE_QUADS);
+		frame_p->renderGroups[3] = CreateRendererGroup(RENDER_GROUP_UI, uiShaderProgram, MAX_UI_QUADS, VERTEX_LAYOUT_PACKED, true);
+		frame_p->renderGroups[4] = CreateRendererGroup(RENDER_GROUP_TEXT_DEFAULT, textShaderProgram, MAX_TEXT_QUADS, VERTEX_LAYOUT_PACKED);
+		frame_p->groupCnt = 5;
+		frame_p->staticMeshes_p = renderer_p->staticMeshes;
+	}
+
+	renderer_p->groupCnt = renderer_p->frames[0].groupCnt;
+	memcpy(renderer_p->renderGroups, renderer_p->frames[0].renderGroups, sizeof(renderer_p->renderGroups));
+	renderer_p->buildFrame = 0;
+	renderer_p->screenDim = ScreenDim;
+	renderer_p->framebufferDim = ScreenDim;
 
 	//
-	// Text Textures
+	// Font
 	// 
-	Texture* textTexture_p = &renderer_p->textRendering.textTexture;
-	textTexture_p->data_p = (U8*)malloc(512 * 512);
-	textTexture_p->width = 512;
-	textTexture_p->height = 512;
+	bool fontLoaded = FontLoad(&renderer_p->textRendering.font, FONT_BLOB_PATH, fontPaths, ARRAY_COUNT(fontPaths));
+	assert(fontLoaded);
 
-	fread(ttfBuffer, 1, 1 << 20, fopen("C:/Windows/Fonts/consola.ttf", "rb"));
-	stbtt_BakeFontBitmap(ttfBuffer, 0, 16.0f, textTexture_p->data_p, 512, 512, 32, 96, renderer_p->textRendering.charUvData);
+	renderer_p->textRendering.useLayoutCache = false; // Only a win with many repeated labels, see the text bench.
+	TextLayoutCacheInit(&renderer_p->textRendering.layoutCache, TEXT_LAYOUT_CACHE_SIZE);
 
 	assert(renderer_p->groupCnt < MAX_RENDER_GROUPS);
 }
 
+bool RendererBakeFont()
+{
+	return FontBakeBlob(FONT_BLOB_PATH, fontPaths, ARRAY_COUNT(fontPaths));
+}
+
+void RendererSetTextureAtlas(Renderer* renderer_p, const TextureAtlas* atlas_p)
+{
+	assert(atlas_p->textureCount == TEXTURES_COUNT);
+	renderer_p->useAtlas = true;
+	memcpy(renderer_p->atlasUvRects, atlas_p->uvRects, sizeof(renderer_p->atlasUvRects));
+}
+
+static int CompareRenderEntries(const void* a_p, const void* b_p)
+{
+	RenderSortKeyT keyA = ((const RenderEntry*)a_p)->sortKey;
+	RenderSortKeyT keyB = ((const RenderEntry*)b_p)->sortKey;
+	if (keyA < keyB) return -1;
+	if (keyA > keyB) return 1;
+	return 0;
+}
+
+static inline bool HasCullRect(const RenderGroup* rendGrp_p)
+{
+	return rendGrp_p->ortoProj.xmax > rendGrp_p->ortoProj.xmin;
+}
+
+// True when the box lies completely outside the group's projection.
+static inline bool CullBox(RenderGroup* rendGrp_p, Vector2 min, Vector2 max)
+{
+	if (!HasCullRect(rendGrp_p)) return false;
+
+	const OrtographicProj* proj_p = &rendGrp_p->ortoProj;
+	bool culled = max.x < proj_p->xmin || min.x > proj_p->xmax || max.y < proj_p->ymin || min.y > proj_p->ymax;
+	if (culled) rendGrp_p->cullStats.culled++;
+	else        rendGrp_p->cullStats.visible++;
+	return culled;
+}
+
+// Rotated quads and circles are tested with their bounding circle.
+static inline bool CullCircle(RenderGroup* rendGrp_p, Vector2 center, float radius)
+{
+	return CullBox(rendGrp_p, center - radius * VECTOR2_ONE, center + radius * VECTOR2_ONE);
+}
+
+// Particles are written straight into the group, so they are culled here by compacting the live instances.
+static void CullParticles(RenderGroup* rendGrp_p)
+{
+	if (!HasCullRect(rendGrp_p)) return;
+
+	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
+	const OrtographicProj* proj_p = &rendGrp_p->ortoProj;
+	U32 visible = 0;
+	for (U32 i = 0; i < renderCmds_p->instanceCount; i++)
+	{
+		const ParticleInstance* particle_p = &renderCmds_p->particleArray[i];
+		float halfSize = 0.5f * particle_p->size;
+		if (particle_p->pos.x + halfSize < proj_p->xmin || particle_p->pos.x - halfSize > proj_p->xmax ||
+			particle_p->pos.y + halfSize < proj_p->ymin || particle_p->pos.y - halfSize > proj_p->ymax) continue;
+		renderCmds_p->particleArray[visible++] = *particle_p;
+	}
+
+	rendGrp_p->cullStats.visible += visible;
+	rendGrp_p->cullStats.culled += renderCmds_p->instanceCount - visible;
+	renderCmds_p->instanceCount = visible;
+}
+
+void RendererSortAndBatch(Renderer* renderer_p)
+{
+	assert(!renderer_p->staticMeshCapture.active);
+	for (int i = 0; i < renderer_p->groupCnt; i++)
+	{
+		RenderCommands* renderCmds_p = &renderer_p->renderGroups[i].renderCommands;
+		RenderBudgetStats* budgetStats_p = &renderer_p->renderGroups[i].budgetStats;
+		budgetStats_p->peakVertices = __max(budgetStats_p->peakVertices, renderCmds_p->vertexCount);
+		budgetStats_p->peakIndices = __max(budgetStats_p->peakIndices, renderCmds_p->indexCount);
+		budgetStats_p->peakInstances = __max(budgetStats_p->peakInstances, renderCmds_p->instanceCount);
+		budgetStats_p->peakEntries = __max(budgetStats_p->peakEntries, renderCmds_p->entryCount);
+
+		if (renderCmds_p->particleArray)
+		{
+			CullParticles(&renderer_p->renderGroups[i]);
+			continue; // Particles are neither sorted nor batched.
+		}
+
+		// The sequence number in the key makes every key unique, so qsort behaves as a stable sort.
+		qsort(renderCmds_p->entryArray, renderCmds_p->entryCount, sizeof(RenderEntry), CompareRenderEntries);
+
+		renderCmds_p->batchCount = 0;
+		bool instanced = renderCmds_p->instanceArray != nullptr;
+		renderCmds_p->sortedIndexSize = renderCmds_p->vertexCount > U16_MAX + 1 ? sizeof(U32) : sizeof(U16);
+		U32 sortedIndexCount = 0;
+		RenderBatch* batch_p = nullptr;
+		for (U32 e = 0; e < renderCmds_p->entryCount; e++)
+		{
+			RenderEntry* entry_p = &renderCmds_p->entryArray[e];
+			TextureHandleT textureHandle = (TextureHandleT)((entry_p->sortKey >> 40) & 0xffff);
+			if (!batch_p || batch_p->textureHandle != textureHandle)
+			{
+				batch_p = &renderCmds_p->batchArray[renderCmds_p->batchCount++];
+				batch_p->textureHandle = textureHandle;
+				batch_p->firstIndex = sortedIndexCount;
+				batch_p->indexCount = 0;
+			}
+
+			if (instanced)
+			{
+				memcpy(&renderCmds_p->sortedInstanceArray[sortedIndexCount], &renderCmds_p->instanceArray[entry_p->firstIndex], entry_p->indexCount * sizeof(SpriteInstance));
+			}
+			else if (renderCmds_p->sortedIndexSize == sizeof(U16))
+			{
+				U16* dst_p = (U16*)renderCmds_p->sortedIndexArray + sortedIndexCount;
+				const U32* src_p = &renderCmds_p->indexArray[entry_p->firstIndex];
+				for (U32 n = 0; n < entry_p->indexCount; n++) dst_p[n] = (U16)src_p[n];
+			}
+			else
+			{
+				memcpy((U32*)renderCmds_p->sortedIndexArray + sortedIndexCount, &renderCmds_p->indexArray[entry_p->firstIndex], entry_p->indexCount * sizeof(U32));
+			}
+			sortedIndexCount += entry_p->indexCount;
+			batch_p->indexCount += entry_p->indexCount;
+		}
+		assert(sortedIndexCount == (instanced ? renderCmds_p->instanceCount : renderCmds_p->indexCount));
+	}
+}
+
 void RendererEndFrame(Renderer* renderer_p)
 {
 	for (int i = 0; i < renderer_p->groupCnt; i++)
@@ -71,6 +213,191 @@ void RendererEndFrame(Renderer* renderer_p)
 		RenderGroup* rendGrp_p = &renderer_p->renderGroups[i];
 		rendGrp_p->renderCommands.vertexCount = 0;
 		rendGrp_p->renderCommands.indexCount = 0;
+		rendGrp_p->renderCommands.instanceCount = 0;
+		rendGrp_p->renderCommands.entryCount = 0;
+		rendGrp_p->renderCommands.batchCount = 0;
+		rendGrp_p->renderCommands.staticDrawCount = 0;
+	}
+	TextLayoutCacheEndFrame(&renderer_p->textRendering.layoutCache);
+}
+
+static void ResizeRenderCommands(RenderCommands* renderCmds_p, U32 maxVertexCount, U32 maxIndexCount, U32 maxEntryCount, U32 maxInstanceCount)
+{
+	if (maxVertexCount != renderCmds_p->maxVertexCount)
+	{
+		if (renderCmds_p->onlyColoredVertexArray)
+		{
+			renderCmds_p->onlyColoredVertexArray = (ColoredVertex*)realloc(renderCmds_p->onlyColoredVertexArray, maxVertexCount * sizeof(ColoredVertex));
+			renderCmds_p->packedColoredVertexArray = (PackedColoredVertex*)renderCmds_p->onlyColoredVertexArray;
+		}
+		if (renderCmds_p->vertexArray)
+		{
+			renderCmds_p->vertexArray = (TexturedVertex*)realloc(renderCmds_p->vertexArray, maxVertexCount * sizeof(TexturedVertex));
+			renderCmds_p->packedVertexArray = (PackedTexturedVertex*)renderCmds_p->vertexArray;
+		}
+		assert(renderCmds_p->onlyColoredVertexArray || renderCmds_p->vertexArray);
+		renderCmds_p->maxVertexCount = maxVertexCount;
+	}
+	if (maxIndexCount != renderCmds_p->maxIndexCount)
+	{
+		renderCmds_p->indexArray = (U32*)realloc(renderCmds_p->indexArray, maxIndexCount * sizeof(U32));
+		renderCmds_p->sortedIndexArray = realloc(renderCmds_p->sortedIndexArray, maxIndexCount * sizeof(U32));
+		assert(renderCmds_p->indexArray && renderCmds_p->sortedIndexArray);
+		renderCmds_p->maxIndexCount = maxIndexCount;
+	}
+	if (maxEntryCount != renderCmds_p->maxEntryCount)
+	{
+		renderCmds_p->entryArray = (RenderEntry*)realloc(renderCmds_p->entryArray, maxEntryCount * sizeof(RenderEntry));
+		renderCmds_p->batchArray = (RenderBatch*)realloc(renderCmds_p->batchArray, maxEntryCount * sizeof(RenderBatch));
+		assert(renderCmds_p->entryArray && renderCmds_p->batchArray);
+		renderCmds_p->maxEntryCount = maxEntryCount;
+	}
+	if (maxInstanceCount != renderCmds_p->maxInstanceCount)
+	{
+		if (renderCmds_p->particleArray)
+		{
+			renderCmds_p->particleArray = (ParticleInstance*)realloc(renderCmds_p->particleArray, maxInstanceCount * sizeof(ParticleInstance));
+			assert(renderCmds_p->particleArray);
+		}
+		else
+		{
+			renderCmds_p->instanceArray = (SpriteInstance*)realloc(renderCmds_p->instanceArray, maxInstanceCount * sizeof(SpriteInstance));
+			renderCmds_p->sortedInstanceArray = (SpriteInstance*)realloc(renderCmds_p->sortedInstanceArray, maxInstanceCount * sizeof(SpriteInstance));
+			assert(renderCmds_p->instanceArray && renderCmds_p->sortedInstanceArray);
+		}
+		renderCmds_p->maxInstanceCount = maxInstanceCount;
+	}
+}
+
+// Doubles the capacity until needed items fit, at most up to limit. False when not even the limit is enough.
+static bool GrowCapacity(U32* capacity_p, U32 limit, U32 needed)
+{
+	if (needed <= *capacity_p) return true;
+	if (needed > limit) return false;
+
+	U32 capacity = __max(*capacity_p, 1u);
+	while (capacity < needed) capacity *= 2;
+	*capacity_p = __min(capacity, limit);
+	return true;
+}
+
+static bool GrowRenderCommands(RenderGroup* rendGrp_p, U32 vertices, U32 indices, U32 entries, U32 instances)
+{
+	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
+	U32 maxVertexCount = renderCmds_p->maxVertexCount;
+	U32 maxIndexCount = renderCmds_p->maxIndexCount;
+	U32 maxEntryCount = renderCmds_p->maxEntryCount;
+	U32 maxInstanceCount = renderCmds_p->maxInstanceCount;
+	if (!GrowCapacity(&maxVertexCount, renderCmds_p->vertexLimit, renderCmds_p->vertexCount + vertices) ||
+		!GrowCapacity(&maxIndexCount, renderCmds_p->indexLimit, renderCmds_p->indexCount + indices) ||
+		!GrowCapacity(&maxEntryCount, renderCmds_p->entryLimit, renderCmds_p->entryCount + entries) ||
+		!GrowCapacity(&maxInstanceCount, renderCmds_p->instanceLimit, renderCmds_p->instanceCount + instances))
+	{
+		rendGrp_p->budgetStats.dropped++;
+		return false;
+	}
+
+	ResizeRenderCommands(renderCmds_p, maxVertexCount, maxIndexCount, maxEntryCount, maxInstanceCount);
+	rendGrp_p->budgetStats.grows++;
+	return true;
+}
+
+// Makes room for a push, growing the group if needed. False when the group is at its limits, the push is
+// then dropped and counted in the group's budget stats.
+static inline bool ReserveRenderCommands(RenderGroup* rendGrp_p, U32 vertices, U32 indices, U32 entries, U32 instances = 0)
+{
+	const RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
+	if (renderCmds_p->vertexCount + vertices <= renderCmds_p->maxVertexCount && renderCmds_p->indexCount + indices <= renderCmds_p->maxIndexCount &&
+		renderCmds_p->entryCount + entries <= renderCmds_p->maxEntryCount && renderCmds_p->instanceCount + instances <= renderCmds_p->maxInstanceCount) return true;
+	return GrowRenderCommands(rendGrp_p, vertices, indices, entries, instances);
+}
+
+static void CopyRenderCommands(RenderGroup* dstGrp_p, const RenderCommands* src_p)
+{
+	RenderCommands* dst_p = &dstGrp_p->renderCommands;
+	assert(dst_p->vertexLayout == src_p->vertexLayout);
+	if (src_p->maxVertexCount > dst_p->maxVertexCount || src_p->maxIndexCount > dst_p->maxIndexCount ||
+		src_p->maxEntryCount > dst_p->maxEntryCount || src_p->maxInstanceCount > dst_p->maxInstanceCount)
+	{
+		ResizeRenderCommands(dst_p, __max(dst_p->maxVertexCount, src_p->maxVertexCount), __max(dst_p->maxIndexCount, src_p->maxIndexCount),
+			__max(dst_p->maxEntryCount, src_p->maxEntryCount), __max(dst_p->maxInstanceCount, src_p->maxInstanceCount));
+		dstGrp_p->budgetStats.grows++;
+	}
+
+	dst_p->vertexCount = src_p->vertexCount;
+	dst_p->indexCount = src_p->indexCount;
+	dst_p->entryCount = src_p->entryCount;
+	dst_p->instanceCount = src_p->instanceCount;
+	dst_p->staticDrawCount = src_p->staticDrawCount;
+	memcpy(dst_p->staticDraws, src_p->staticDraws, src_p->staticDrawCount * sizeof(StaticMeshDraw));
+	if (src_p->vertexArray)            memcpy(dst_p->vertexArray, src_p->vertexArray, src_p->vertexCount * RenderVertexSize(src_p));
+	if (src_p->onlyColoredVertexArray) memcpy(dst_p->onlyColoredVertexArray, src_p->onlyColoredVertexArray, src_p->vertexCount * RenderVertexSize(src_p));
+	if (src_p->indexArray)             memcpy(dst_p->indexArray, src_p->indexArray, src_p->indexCount * sizeof(U32));
+	if (src_p->entryArray)             memcpy(dst_p->entryArray, src_p->entryArray, src_p->entryCount * sizeof(RenderEntry));
+	if (src_p->instanceArray)          memcpy(dst_p->instanceArray, src_p->instanceArray, src_p->instanceCount * sizeof(SpriteInstance));
+	if (src_p->particleArray)          memcpy(dst_p->particleArray, src_p->particleArray, src_p->instanceCount * sizeof(ParticleInstance));
+}
+
+RenderFrame* RendererSwapFrame(Renderer* renderer_p, int nextFrame, bool clear)
+{
+	assert(nextFrame >= 0 && nextFrame < RENDER_FRAME_COUNT && nextFrame != renderer_p->buildFrame);
+
+	RenderFrame* frozen_p = &renderer_p->frames[renderer_p->buildFrame];
+	frozen_p->groupCnt = renderer_p->groupCnt;
+	memcpy(frozen_p->renderGroups, renderer_p->renderGroups, renderer_p->groupCnt * sizeof(RenderGroup));
+	frozen_p->screenDim = renderer_p->screenDim;
+	frozen_p->framebufferDim = renderer_p->framebufferDim;
+
+	// Only the buffers change owner, projections, vertex layouts and cull stats stay with the groups being built.
+	RenderFrame* next_p = &renderer_p->frames[nextFrame];
+	for (int i = 0; i < renderer_p->groupCnt; i++)
+	{
+		VertexLayoutE vertexLayout = renderer_p->renderGroups[i].renderCommands.vertexLayout;
+		renderer_p->renderGroups[i].renderCommands = next_p->renderGroups[i].renderCommands;
+		renderer_p->renderGroups[i].renderCommands.vertexLayout = vertexLayout;
+	}
+	renderer_p->buildFrame = nextFrame;
+
+	RendererEndFrame(renderer_p);
+	if (!clear)
+	{
+		for (int i = 0; i < renderer_p->groupCnt; i++) CopyRenderCommands(&renderer_p->renderGroups[i], &frozen_p->renderGroups[i].renderCommands);
+	}
+	return frozen_p;
+}
+
+// The frame being built is the one the backend gave back last, its stats are still those of its last draw.
+const RenderFrame* RendererGetLastDrawnFrame(const Renderer* renderer_p)
+{
+	return &renderer_p->frames[renderer_p->buildFrame];
+}
+
+// Frames still owned by the backend keep the layout they were built with, the next swap hands it on.
+void RendererSetVertexLayout(Renderer* renderer_p, RenderGroupTypeE renderGroupType, VertexLayoutE vertexLayout)
+{
+	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, renderGroupType);
+	assert(rendGrp_p && rendGrp_p->renderCommands.vertexCount == 0);
+	assert(rendGrp_p->renderCommands.onlyColoredVertexArray || rendGrp_p->renderCommands.vertexArray);
+	rendGrp_p->renderCommands.vertexLayout = vertexLayout;
+}
+
+U32 RenderVertexSize(const RenderCommands* renderCmds_p)
+{
+	bool packed = renderCmds_p->vertexLayout == VERTEX_LAYOUT_PACKED;
+	if (renderCmds_p->onlyColoredVertexArray) return packed ? sizeof(PackedColoredVertex) : sizeof(ColoredVertex);
+	return packed ? sizeof(PackedTexturedVertex) : sizeof(TexturedVertex);
+}
+
+const char* RenderGroupName(RenderGroupTypeE renderGroupType)
+{
+	switch (renderGroupType)
+	{
+	case RENDER_GROUP_SPRITES_DEFAULT: return "sprites";
+	case RENDER_GROUP_TEXT_DEFAULT:    return "text";
+	case RENDER_GROUP_UI:              return "ui";
+	case RENDER_GROUP_WIREFRAME:       return "wireframe";
+	case RENDER_GROUP_PARTICLES:       return "particles";
+	default:                           return "none";
 	}
 }
 
@@ -98,50 +425,99 @@ void SetWireframeOrtographicProj(Renderer* renderer_p, Rect rect)
 	SetOrtographicProj(rendGrp_p, rect);
 }
 
-void PushSprite(Renderer* renderer_p, Vector2 pos, Vector2 size, Vector2 facingV, TextureHandleT textureHandle, Color color, Rect uvRect)
+void SetParticlesOrtographicProj(Renderer* renderer_p, Rect rect)
+{
+	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_PARTICLES);
+	assert(rendGrp_p);
+	SetOrtographicProj(rendGrp_p, rect);
+}
+
+static inline S16 PackSnorm16(float v)
+{
+	v = __max(-1.0f, __min(1.0f, v));
+	return (S16)roundf(v * S16_MAX);
+}
+
+static inline U16 PackUnorm16(float v)
+{
+	v = __max(0.0f, __min(1.0f, v));
+	return (U16)(v * U16_MAX + 0.5f);
+}
+
+static inline void SetColoredVertex(RenderCommands* renderCmds_p, U32 vertex, Vector2 pos, Color color)
+{
+	if (renderCmds_p->vertexLayout == VERTEX_LAYOUT_PACKED)
+	{
+		PackedColoredVertex* vert_p = &renderCmds_p->packedColoredVertexArray[vertex];
+		vert_p->pos = pos;
+		vert_p->color = ToColor32(color);
+	}
+	else
+	{
+		ColoredVertex* vert_p = &renderCmds_p->onlyColoredVertexArray[vertex];
+		vert_p->pos = V3(pos);
+		vert_p->color = color;
+	}
+}
+
+static inline void SetTexturedVertex(RenderCommands* renderCmds_p, U32 vertex, Vector2 pos, Vector2 uv, Color color)
+{
+	if (renderCmds_p->vertexLayout == VERTEX_LAYOUT_PACKED)
+	{
+		PackedTexturedVertex* vert_p = &renderCmds_p->packedVertexArray[vertex];
+		vert_p->pos = pos;
+		vert_p->uv[0] = PackUnorm16(uv.x);
+		vert_p->uv[1] = PackUnorm16(uv.y);
+		vert_p->color = ToColor32(color);
+		vert_p->textureLayer = 0;
+	}
+	else
+	{
+		TexturedVertex* vert_p = &renderCmds_p->vertexArray[vertex];
+		vert_p->pos = V3(pos);
+		vert_p->color = color;
+		vert_p->uv = uv;
+	}
+}
+
+void PushSprite(Renderer* renderer_p, Vector2 pos, Vector2 size, Vector2 facingV, TextureHandleT textureHandle, Color color, Rect uvRect, RenderLayerE layer)
 {
 	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_SPRITES_DEFAULT);
 	assert(rendGrp_p);
 
+	if (CullCircle(rendGrp_p, pos, Magnitude(0.5f * size))) return;
+
+	if (!ReserveRenderCommands(rendGrp_p, 0, 0, 1, 1)) return;
 	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
-	assert(renderCmds_p->vertexCount < renderCmds_p->maxVertexCount);
-	assert(renderCmds_p->indexCount < renderCmds_p->maxIndexCount);
 
-	float angleRad = atan2(-facingV.x, facingV.y);
-	Vector2 MaxXMaxY = pos + RotateRad(V2( 0.5f * size.x,  0.5f * size.y), angleRad);
-	Vector2 MaxXMinY = pos + RotateRad(V2( 0.5f * size.x, -0.5f * size.y), angleRad);
-	Vector2 MinXMinY = pos + RotateRad(V2(-0.5f * size.x, -0.5f * size.y), angleRad);
-	Vector2 MinXMaxY = pos + RotateRad(V2(-0.5f * size.x,  0.5f * size.y), angleRad);
-
-	TexturedVertex* vert_p = &renderCmds_p->vertexArray[renderCmds_p->vertexCount];
-	vert_p[0].pos = V3(MaxXMaxY);
-	vert_p[0].color = color;
-	vert_p[0].uv = RectMaxXMaxY(uvRect);
-	vert_p[0].textureHandle = textureHandle;
-	vert_p[1].pos = V3(MaxXMinY);
-	vert_p[1].color = color;
-	vert_p[1].uv = RectMaxXMinY(uvRect);
-	vert_p[1].textureHandle = textureHandle;
-	vert_p[2].pos = V3(MinXMinY);
-	vert_p[2].color = color;
-	vert_p[2].uv = RectMinXMinY(uvRect);
-	vert_p[2].textureHandle = textureHandle;
-	vert_p[3].pos = V3(MinXMaxY);
-	vert_p[3].color = color;
-	vert_p[3].uv = RectMinXMaxY(uvRect);
-	vert_p[3].textureHandle = textureHandle;
-
-	U16 baseIndex = renderCmds_p->vertexCount;
-	U16* index_p = &renderCmds_p->indexArray[renderCmds_p->indexCount];
-	index_p[0] = baseIndex + 0;
-	index_p[1] = baseIndex + 1;
-	index_p[2] = baseIndex + 3;
-	index_p[3] = baseIndex + 1;
-	index_p[4] = baseIndex + 2;
-	index_p[5] = baseIndex + 3;
+	// Streamed textures aren't in the atlas.
+	assert(textureHandle >= 0 && textureHandle < MAX_TEXTURE_HANDLES);
+	if (renderer_p->useAtlas && textureHandle < TEXTURES_COUNT)
+	{
+		uvRect = AtlasRemapUv(renderer_p->atlasUvRects[textureHandle], uvRect);
+		textureHandle = TEXTURE_ATLAS;
+	}
 
-	renderCmds_p->vertexCount += 4;
-	renderCmds_p->indexCount += 6;
+	// The quad corners are computed in the vertex shader, here we only quantize.
+	Vector2 facingN = Normalize(facingV);
+	if (facingN.x == 0.0f && facingN.y == 0.0f) facingN = VECTOR2_UP;
+	Vector2 uvMin = RectMinXMinY(uvRect);
+	Vector2 uvMax = RectMaxXMaxY(uvRect);
+
+	SpriteInstance* instance_p = &renderCmds_p->instanceArray[renderCmds_p->instanceCount];
+	instance_p->pos = pos;
+	instance_p->halfSize = 0.5f * size;
+	instance_p->facing[0] = PackSnorm16(facingN.x);
+	instance_p->facing[1] = PackSnorm16(facingN.y);
+	instance_p->color = ToColor32(color);
+	instance_p->uv[0] = PackUnorm16(uvMin.x);
+	instance_p->uv[1] = PackUnorm16(uvMin.y);
+	instance_p->uv[2] = PackUnorm16(uvMax.x);
+	instance_p->uv[3] = PackUnorm16(uvMax.y);
+
+	PushRenderEntry(renderCmds_p, layer, textureHandle, renderCmds_p->instanceCount, 1);
+
+	renderCmds_p->instanceCount++;
 }
 
 void PushUiRect(Renderer* renderer_p, Rect rect, Color color)
@@ -149,9 +525,8 @@ void PushUiRect(Renderer* renderer_p, Rect rect, Color color)
 	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_UI);
 	assert(rendGrp_p);
 
+	if (!ReserveRenderCommands(rendGrp_p, 4, 6, 1)) return;
 	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
-	assert(renderCmds_p->vertexCount < renderCmds_p->maxVertexCount);
-	assert(renderCmds_p->indexCount < renderCmds_p->maxIndexCount);
 
 	Vector2 facingV = VECTOR2_UP; //@nocommit
 
@@ -162,18 +537,14 @@ void PushUiRect(Renderer* renderer_p, Rect rect, Color color)
 	Vector2 MinXMinY = rectCenter + RotateRad(V2(-0.5f * rect.size.x, -0.5f * rect.size.y), angleRad);
 	Vector2 MinXMaxY = rectCenter + RotateRad(V2(-0.5f * rect.size.x, 0.5f * rect.size.y), angleRad);
 
-	ColoredVertex* vert_p = &renderCmds_p->onlyColoredVertexArray[renderCmds_p->vertexCount];
-	vert_p[0].pos = V3(MaxXMaxY);
-	vert_p[0].color = color;
-	vert_p[1].pos = V3(MaxXMinY);
-	vert_p[1].color = color;
-	vert_p[2].pos = V3(MinXMinY);
-	vert_p[2].color = color;
-	vert_p[3].pos = V3(MinXMaxY);
-	vert_p[3].color = color;
-
-	U16 baseIndex = renderCmds_p->vertexCount;
-	U16* index_p = &renderCmds_p->indexArray[renderCmds_p->indexCount];
+	U32 vertex = renderCmds_p->vertexCount;
+	SetColoredVertex(renderCmds_p, vertex + 0, MaxXMaxY, color);
+	SetColoredVertex(renderCmds_p, vertex + 1, MaxXMinY, color);
+	SetColoredVertex(renderCmds_p, vertex + 2, MinXMinY, color);
+	SetColoredVertex(renderCmds_p, vertex + 3, MinXMaxY, color);
+
+	U32 baseIndex = renderCmds_p->vertexCount;
+	U32* index_p = &renderCmds_p->indexArray[renderCmds_p->indexCount];
 	index_p[0] = baseIndex + 0;
 	index_p[1] = baseIndex + 1;
 	index_p[2] = baseIndex + 3;
@@ -181,6 +552,8 @@ void PushUiRect(Renderer* renderer_p, Rect rect, Color color)
 	index_p[4] = baseIndex + 2;
 	index_p[5] = baseIndex + 3;
 
+	PushRenderEntry(renderCmds_p, RENDER_LAYER_DEFAULT, 0, renderCmds_p->indexCount, 6);
+
 	renderCmds_p->vertexCount += 4;
 	renderCmds_p->indexCount += 6;
 }
@@ -191,7 +564,7 @@ void PushUiRect01(Renderer* renderer_p, Rect rect01, Color color)
 	PushUiRect(renderer_p, rect, color);
 }
 
-float GetCharPosX(stbtt_bakedchar* bakedCharData_p, float startPosX, const char* text, int charIdx)
+float GetCharPosX(const Font* font_p, float startPosX, const char* text, int charIdx)
 {
 	float posX = startPosX;
 	float posY = 0; // Doesn't matter.
@@ -201,7 +574,7 @@ float GetCharPosX(stbtt_bakedchar* bakedCharData_p, float startPosX, const char*
 		if (*text >= 32 && *text < 128)
 		{
 			stbtt_aligned_quad q;
-			stbtt_GetBakedQuad(bakedCharData_p, 512, 512, *text - 32, &posX, &posY, &q, 1);//1=opengl & d3d10+,0=d3d9
+			FontGetQuad(font_p, FONT_SIZE, *text - FONT_FIRST_CHAR, &posX, &posY, &q);
 			if ((idx == (charIdx - 1))) return posX;
 		}
 		++idx;
@@ -211,62 +584,89 @@ float GetCharPosX(stbtt_bakedchar* bakedCharData_p, float startPosX, const char*
 	return posX;
 }
 
-float GetTextWidth(Renderer* renderer_p, const char* text)
+static const TextRun* GetTextLayout(Renderer* renderer_p, const char* text, float fontSize)
 {
-	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_TEXT_DEFAULT);
-	stbtt_bakedchar* bakedCharData_p = renderer_p->textRendering.charUvData;
-	return GetCharPosX(bakedCharData_p, 0, text, strlen(text));
+	TextRendering* textRendering_p = &renderer_p->textRendering;
+	if (!textRendering_p->useLayoutCache) return nullptr;
+	return TextLayoutGet(&textRendering_p->layoutCache, &textRendering_p->font, fontSize, text);
 }
 
-void PushText(Renderer* renderer_p, const char* text, Vector2 pos, Color color, float maxX)
+float GetTextWidth(Renderer* renderer_p, const char* text, float fontSize)
+{
+	const TextRun* run_p = GetTextLayout(renderer_p, text, fontSize);
+	if (run_p) return run_p->width;
+
+	float posX = 0;
+	float posY = 0;
+	for (; *text; text++)
+	{
+		stbtt_aligned_quad quad;
+		if (*text >= 32 && *text < 128) FontGetQuad(&renderer_p->textRendering.font, fontSize, *text - FONT_FIRST_CHAR, &posX, &posY, &quad);
+	}
+	return posX;
+}
+
+static inline void PushGlyphQuad(RenderCommands* renderCmds_p, float x0, float y0, float x1, float y1, float s0, float t0, float s1, float t1, Color color)
+{
+	// Note this is flipped but we fix it in the shader.
+	U32 vertex = renderCmds_p->vertexCount;
+	SetTexturedVertex(renderCmds_p, vertex + 0, V2(x0, y0), V2(s0, t0), color);
+	SetTexturedVertex(renderCmds_p, vertex + 1, V2(x1, y0), V2(s1, t0), color);
+	SetTexturedVertex(renderCmds_p, vertex + 2, V2(x1, y1), V2(s1, t1), color);
+	SetTexturedVertex(renderCmds_p, vertex + 3, V2(x0, y1), V2(s0, t1), color);
+
+	U32 baseIndex = renderCmds_p->vertexCount;
+	U32* index_p = &renderCmds_p->indexArray[renderCmds_p->indexCount];
+	index_p[0] = baseIndex + 0;
+	index_p[1] = baseIndex + 1;
+	index_p[2] = baseIndex + 3;
+	index_p[3] = baseIndex + 1;
+	index_p[4] = baseIndex + 2;
+	index_p[5] = baseIndex + 3;
+
+	renderCmds_p->vertexCount += 4;
+	renderCmds_p->indexCount += 6;
+}
+
+void PushText(Renderer* renderer_p, const char* text, Vector2 pos, Color color, float maxX, float fontSize)
 {
 	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_TEXT_DEFAULT);
 	assert(rendGrp_p);
 
-	stbtt_bakedchar* bakedCharData_p = renderer_p->textRendering.charUvData;
+	const Font* font_p = &renderer_p->textRendering.font;
+	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
+	U32 firstIndex = renderCmds_p->indexCount;
+
+	// Cached runs are laid out at the origin and only need to be moved to pos.
+	const TextRun* run_p = GetTextLayout(renderer_p, text, fontSize);
+	U32 maxGlyphs = run_p ? run_p->glyphCount : (U32)strlen(text);
+	if (!ReserveRenderCommands(rendGrp_p, 4 * maxGlyphs, 6 * maxGlyphs, 1)) return;
+	if (run_p)
+	{
+		for (int i = 0; i < run_p->glyphCount && (pos.x + run_p->glyphs[i].penX) < maxX; i++)
+		{
+			const TextGlyph* glyph_p = &run_p->glyphs[i];
+			PushGlyphQuad(renderCmds_p, pos.x + glyph_p->x0, pos.y + glyph_p->y0, pos.x + glyph_p->x1, pos.y + glyph_p->y1,
+				glyph_p->s0, glyph_p->t0, glyph_p->s1, glyph_p->t1, color);
+		}
+		if (renderCmds_p->indexCount > firstIndex) PushRenderEntry(renderCmds_p, RENDER_LAYER_DEFAULT, 0, firstIndex, renderCmds_p->indexCount - firstIndex);
+		return;
+	}
 
 	int idx = 0;
 	while (*text && (pos.x < maxX))
 	{
 		if (*text >= 32 && *text < 128) 
 		{
-			RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
-			assert(renderCmds_p->vertexCount < renderCmds_p->maxVertexCount);
-			assert(renderCmds_p->indexCount < renderCmds_p->maxIndexCount);
-
 			stbtt_aligned_quad quad;
-			stbtt_GetBakedQuad(bakedCharData_p, 512, 512, *text - 32, &pos.x, &pos.y, &quad, 1);//1=opengl & d3d10+,0=d3d9
-			TexturedVertex* vert_p = &renderCmds_p->vertexArray[renderCmds_p->vertexCount];
-	
-			// Note this is flipped but we fix it in the shader.
-			vert_p[0].pos = V3(quad.x0, quad.y0, 0.0f);
- 			vert_p[0].color = color;
-			vert_p[0].uv = V2(quad.s0, quad.t0);
-			vert_p[1].pos = V3(quad.x1, quad.y0, 0.0f);
-			vert_p[1].color = color;
-			vert_p[1].uv = V2(quad.s1, quad.t0);
-			vert_p[2].pos = V3(quad.x1, quad.y1, 0.0f);
-			vert_p[2].color = color;
-			vert_p[2].uv = V2(quad.s1, quad.t1);
-			vert_p[3].pos = V3(quad.x0, quad.y1, 0.0f);
-			vert_p[3].color = color;
-			vert_p[3].uv = V2(quad.s0, quad.t1);
-
-			U16 baseIndex = renderCmds_p->vertexCount;
-			U16* index_p = &renderCmds_p->indexArray[renderCmds_p->indexCount];
-			index_p[0] = baseIndex + 0;
-			index_p[1] = baseIndex + 1;
-			index_p[2] = baseIndex + 3;
-			index_p[3] = baseIndex + 1;
-			index_p[4] = baseIndex + 2;
-			index_p[5] = baseIndex + 3;
-
-			renderCmds_p->vertexCount += 4;
-			renderCmds_p->indexCount += 6;
+			FontGetQuad(font_p, fontSize, *text - FONT_FIRST_CHAR, &pos.x, &pos.y, &quad);
+			PushGlyphQuad(renderCmds_p, quad.x0, quad.y0, quad.x1, quad.y1, quad.s0, quad.t0, quad.s1, quad.t1, color);
 		}
 		++idx;
 		++text;
 	}
+
+	if (renderCmds_p->indexCount > firstIndex) PushRenderEntry(renderCmds_p, RENDER_LAYER_DEFAULT, 0, firstIndex, renderCmds_p->indexCount - firstIndex);
 }
 
 void PushText01(Renderer* renderer_p, const char* text, Vector2 pos01, Color color)
@@ -279,10 +679,10 @@ void PushRect(Renderer* renderer_p, Rect rect, Color color, Vector2 facingV)
 {
 	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_WIREFRAME);
 	assert(rendGrp_p);
+	if (CullCircle(rendGrp_p, GetRectCenter(rect), Magnitude(0.5f * rect.size))) return;
 
+	if (!ReserveRenderCommands(rendGrp_p, 4, 6, 1)) return;
 	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
-	assert(renderCmds_p->vertexCount < renderCmds_p->maxVertexCount);
-	assert(renderCmds_p->indexCount < renderCmds_p->maxIndexCount);
 
 	float angleRad = atan2(-facingV.x, facingV.y);
 	Vector2 rectCenter = GetRectCenter(rect); // Rotates around center
@@ -291,18 +691,14 @@ void PushRect(Renderer* renderer_p, Rect rect, Color color, Vector2 facingV)
 	Vector2 MinXMinY = rectCenter + RotateRad(V2(-0.5f * rect.size.x, -0.5f * rect.size.y), angleRad);
 	Vector2 MinXMaxY = rectCenter + RotateRad(V2(-0.5f * rect.size.x, 0.5f * rect.size.y), angleRad);
 
-	ColoredVertex* vert_p = &renderCmds_p->onlyColoredVertexArray[renderCmds_p->vertexCount];
-	vert_p[0].pos = V3(MaxXMaxY);
-	vert_p[0].color = color;
-	vert_p[1].pos = V3(MaxXMinY);
-	vert_p[1].color = color;
-	vert_p[2].pos = V3(MinXMinY);
-	vert_p[2].color = color; 
-	vert_p[3].pos = V3(MinXMaxY);
-	vert_p[3].color = color; 
-
-	U16 baseIndex = renderCmds_p->vertexCount;
-	U16* index_p = &renderCmds_p->indexArray[renderCmds_p->indexCount];
+	U32 vertex = renderCmds_p->vertexCount;
+	SetColoredVertex(renderCmds_p, vertex + 0, MaxXMaxY, color);
+	SetColoredVertex(renderCmds_p, vertex + 1, MaxXMinY, color);
+	SetColoredVertex(renderCmds_p, vertex + 2, MinXMinY, color);
+	SetColoredVertex(renderCmds_p, vertex + 3, MinXMaxY, color);
+
+	U32 baseIndex = renderCmds_p->vertexCount;
+	U32* index_p = &renderCmds_p->indexArray[renderCmds_p->indexCount];
 	index_p[0] = baseIndex + 0;
 	index_p[1] = baseIndex + 1;
 	index_p[2] = baseIndex + 3;
@@ -310,6 +706,8 @@ void PushRect(Renderer* renderer_p, Rect rect, Color color, Vector2 facingV)
 	index_p[4] = baseIndex + 2;
 	index_p[5] = baseIndex + 3;
 
+	PushRenderEntry(renderCmds_p, RENDER_LAYER_DEFAULT, 0, renderCmds_p->indexCount, 6);
+
 	renderCmds_p->vertexCount += 4;
 	renderCmds_p->indexCount += 6;
 }
@@ -318,10 +716,12 @@ void PushLine(Renderer* renderer_p, Vector2 startPos, Vector2 endPos, Color colo
 {
 	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_WIREFRAME);
 	assert(rendGrp_p);
+	Vector2 lineMin = V2(__min(startPos.x, endPos.x) - thickness, __min(startPos.y, endPos.y) - thickness);
+	Vector2 lineMax = V2(__max(startPos.x, endPos.x) + thickness, __max(startPos.y, endPos.y) + thickness);
+	if (CullBox(rendGrp_p, lineMin, lineMax)) return;
 
+	if (!ReserveRenderCommands(rendGrp_p, 4, 6, 1)) return;
 	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
-	assert(renderCmds_p->vertexCount < renderCmds_p->maxVertexCount);
-	assert(renderCmds_p->indexCount < renderCmds_p->maxIndexCount);
 
 	Vector2 v = Normalize(endPos - startPos);
 	Vector2 MaxXMaxY = endPos   + thickness * RotateDeg(v, +90);
@@ -329,18 +729,14 @@ void PushLine(Renderer* renderer_p, Vector2 startPos, Vector2 endPos, Color colo
 	Vector2 MinXMinY = startPos + thickness * RotateDeg(-v, +90);
 	Vector2 MinXMaxY = startPos + thickness * RotateDeg(-v, -90);
 
-	ColoredVertex* vert_p = &renderCmds_p->onlyColoredVertexArray[renderCmds_p->vertexCount];
-	vert_p[0].pos = V3(MaxXMaxY);
-	vert_p[0].color = color; 
-	vert_p[1].pos = V3(MaxXMinY);
-	vert_p[1].color = color; 
-	vert_p[2].pos = V3(MinXMinY);
-	vert_p[2].color = color; 
-	vert_p[3].pos = V3(MinXMaxY);
-	vert_p[3].color = color; 
-
-	U16 baseIndex = renderCmds_p->vertexCount;
-	U16* index_p = &renderCmds_p->indexArray[renderCmds_p->indexCount];
+	U32 vertex = renderCmds_p->vertexCount;
+	SetColoredVertex(renderCmds_p, vertex + 0, MaxXMaxY, color);
+	SetColoredVertex(renderCmds_p, vertex + 1, MaxXMinY, color);
+	SetColoredVertex(renderCmds_p, vertex + 2, MinXMinY, color);
+	SetColoredVertex(renderCmds_p, vertex + 3, MinXMaxY, color);
+
+	U32 baseIndex = renderCmds_p->vertexCount;
+	U32* index_p = &renderCmds_p->indexArray[renderCmds_p->indexCount];
 	index_p[0] = baseIndex + 0;
 	index_p[1] = baseIndex + 1;
 	index_p[2] = baseIndex + 3;
@@ -348,6 +744,8 @@ void PushLine(Renderer* renderer_p, Vector2 startPos, Vector2 endPos, Color colo
 	index_p[4] = baseIndex + 2;
 	index_p[5] = baseIndex + 3;
 
+	PushRenderEntry(renderCmds_p, RENDER_LAYER_DEFAULT, 0, renderCmds_p->indexCount, 6);
+
 	renderCmds_p->vertexCount += 4;
 	renderCmds_p->indexCount += 6;
 }
@@ -380,34 +778,135 @@ void PushXCross(Renderer* renderer_p, Vector2 pos, Color color)
 	PushLine(renderer_p, p1, p2, color);
 }
 
+void StaticMeshBegin(Renderer* renderer_p)
+{
+	StaticMeshCapture* capture_p = &renderer_p->staticMeshCapture;
+	assert(!capture_p->active);
+	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_WIREFRAME);
+	assert(rendGrp_p);
+
+	capture_p->active = true;
+	capture_p->firstVertex = rendGrp_p->renderCommands.vertexCount;
+	capture_p->firstIndex = rendGrp_p->renderCommands.indexCount;
+	capture_p->firstEntry = rendGrp_p->renderCommands.entryCount;
+	capture_p->ortoProj = rendGrp_p->ortoProj;
+	rendGrp_p->ortoProj = {0};
+}
+
+StaticMeshHandleT StaticMeshEnd(Renderer* renderer_p)
+{
+	StaticMeshCapture* capture_p = &renderer_p->staticMeshCapture;
+	assert(capture_p->active);
+	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_WIREFRAME);
+	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
+
+	StaticMeshHandleT handle = STATIC_MESH_NONE;
+	U32 vertexCount = renderCmds_p->vertexCount - capture_p->firstVertex;
+	U32 indexCount = renderCmds_p->indexCount - capture_p->firstIndex;
+	if (indexCount == 0)
+	{
+		printf("WARNING: Static mesh without any geometry\n");
+	}
+	else if (renderer_p->staticMeshCount >= MAX_STATIC_MESHES)
+	{
+		printf("ERROR: Out of static meshes (%d)\n", MAX_STATIC_MESHES);
+	}
+	else
+	{
+		handle = renderer_p->staticMeshCount++;
+		StaticMesh* mesh_p = &renderer_p->staticMeshes[handle];
+		U32 vertexSize = RenderVertexSize(renderCmds_p);
+		mesh_p->vertexLayout = renderCmds_p->vertexLayout;
+		mesh_p->vertexCount = vertexCount;
+		mesh_p->indexCount = indexCount;
+		mesh_p->vertices_p = malloc(vertexCount * vertexSize);
+		mesh_p->indices_p = (U32*)malloc(indexCount * sizeof(U32));
+		memcpy(mesh_p->vertices_p, (U8*)renderCmds_p->onlyColoredVertexArray + capture_p->firstVertex * vertexSize, vertexCount * vertexSize);
+
+		// Rebased to the mesh's first vertex.
+		for (U32 i = 0; i < indexCount; i++) mesh_p->indices_p[i] = renderCmds_p->indexArray[capture_p->firstIndex + i] - capture_p->firstVertex;
+
+		mesh_p->boundsMin = V2(F32_MAX, F32_MAX);
+		mesh_p->boundsMax = V2(-F32_MAX, -F32_MAX);
+		for (U32 i = 0; i < vertexCount; i++)
+		{
+			U32 vertex = capture_p->firstVertex + i;
+			Vector2 pos = renderCmds_p->packedColoredVertexArray[vertex].pos;
+			if (mesh_p->vertexLayout == VERTEX_LAYOUT_FLOAT) pos = V2(renderCmds_p->onlyColoredVertexArray[vertex].pos.x, renderCmds_p->onlyColoredVertexArray[vertex].pos.y);
+			mesh_p->boundsMin = V2(__min(mesh_p->boundsMin.x, pos.x), __min(mesh_p->boundsMin.y, pos.y));
+			mesh_p->boundsMax = V2(__max(mesh_p->boundsMax.x, pos.x), __max(mesh_p->boundsMax.y, pos.y));
+		}
+	}
+
+	// The captured pushes never reach the frame.
+	renderCmds_p->vertexCount = capture_p->firstVertex;
+	renderCmds_p->indexCount = capture_p->firstIndex;
+	renderCmds_p->entryCount = capture_p->firstEntry;
+	rendGrp_p->ortoProj = capture_p->ortoProj;
+	capture_p->active = false;
+	return handle;
+}
+
+void PushStaticMesh(Renderer* renderer_p, StaticMeshHandleT mesh, Vector2 offset, float scale)
+{
+	assert(mesh >= 0 && mesh < renderer_p->staticMeshCount && scale > 0.0f);
+	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_WIREFRAME);
+	assert(rendGrp_p);
+
+	const StaticMesh* mesh_p = &renderer_p->staticMeshes[mesh];
+	if (CullBox(rendGrp_p, offset + scale * mesh_p->boundsMin, offset + scale * mesh_p->boundsMax)) return;
+
+	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
+	if (renderCmds_p->staticDrawCount >= MAX_STATIC_MESH_DRAWS)
+	{
+		rendGrp_p->budgetStats.dropped++;
+		return;
+	}
+
+	StaticMeshDraw* draw_p = &renderCmds_p->staticDraws[renderCmds_p->staticDrawCount++];
+	draw_p->mesh = mesh;
+	draw_p->offset = offset;
+	draw_p->scale = scale;
+}
+
+ParticleInstance* PushParticles(Renderer* renderer_p, U32 count)
+{
+	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_PARTICLES);
+	assert(rendGrp_p);
+
+	if (!ReserveRenderCommands(rendGrp_p, 0, 0, 0, count)) return nullptr;
+	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
+
+	ParticleInstance* particles_p = &renderCmds_p->particleArray[renderCmds_p->instanceCount];
+	renderCmds_p->instanceCount += count;
+	return particles_p;
+}
+
 void PushCircle(Renderer* renderer_p, Vector2 centerPos, float radius, Color color, int edges)
 {
 	RenderGroup* rendGrp_p = FindRenderGroup(renderer_p, RENDER_GROUP_WIREFRAME);
 	assert(rendGrp_p);
+	if (CullCircle(rendGrp_p, centerPos, radius)) return;
 
+	if (!ReserveRenderCommands(rendGrp_p, 3 * edges, 3 * edges, 1)) return;
 	RenderCommands* renderCmds_p = &rendGrp_p->renderCommands;
 
+	U32 firstIndex = renderCmds_p->indexCount;
 	float deltaAngle = 360.0f/edges;
 	Vector2 radialV = VECTOR2_RIGHT;
 	for (int i = 0; i < edges; i++)
 	{
-		assert(renderCmds_p->vertexCount < renderCmds_p->maxVertexCount);
-		assert(renderCmds_p->indexCount < renderCmds_p->maxIndexCount);
-
 		Vector2 pos1 = centerPos + radius * radialV;
 		radialV = RotateDeg(radialV, deltaAngle);
 		Vector2 pos2 = centerPos + radius * radialV;
 
-		ColoredVertex* vert_p = &renderCmds_p->onlyColoredVertexArray[renderCmds_p->vertexCount];
-		vert_p[0].pos = V3(centerPos);
-		vert_p[0].color = Col(color.r, color.g, color.b, 0.0f);
-		vert_p[1].pos = V3(pos1);
-		vert_p[1].color = color;
-		vert_p[2].pos = V3(pos2);
-		vert_p[2].color = color;
+		U32 vertex = renderCmds_p->vertexCount;
+		SetColoredVertex(renderCmds_p, vertex + 0, centerPos, Col(color.r, color.g, color.b, 0.0f));
+		SetColoredVertex(renderCmds_p, vertex + 1, pos1, color);
+		SetColoredVertex(renderCmds_p, vertex + 2, pos2, color);
 
-		U16 baseIndex = renderCmds_p->vertexCount;
-		U16* index_p = &renderCmds_p->indexArray[renderCmds_p->indexCount];
+		U32 baseIndex = renderCmds_p->vertexCount;
+		U32* index_p = &renderCmds_p->indexArray[renderCmds_p->indexCount];
 		index_p[0] = baseIndex + 0;
 		index_p[1] = baseIndex + 1;
 		index_p[2] = baseIndex + 2;
@@ -415,31 +914,95 @@ void PushCircle(Renderer* renderer_p, Vector2 centerPos, float radius, Color col
 		renderCmds_p->vertexCount += 3;
 		renderCmds_p->indexCount += 3;
 	}
+
+	PushRenderEntry(renderCmds_p, RENDER_LAYER_DEFAULT, 0, firstIndex, renderCmds_p->indexCount - firstIndex);
+}
+
+static void PushRenderEntry(RenderCommands* renderCmds_p, RenderLayerE layer, TextureHandleT textureHandle, U32 firstIndex, U32 indexCount)
+{
+	assert(renderCmds_p->entryCount < renderCmds_p->maxEntryCount);
+
+	RenderEntry* entry_p = &renderCmds_p->entryArray[renderCmds_p->entryCount];
+	entry_p->sortKey = ((RenderSortKeyT)layer << 56) | ((RenderSortKeyT)(U16)textureHandle << 40) | (RenderSortKeyT)renderCmds_p->entryCount;
+	entry_p->firstIndex = firstIndex;
+	entry_p->indexCount = indexCount;
+
+	renderCmds_p->entryCount++;
 }
 
-static RenderGroup CreateRendererGroup(RenderGroupTypeE rendererGroupType, int shaderProgram, int maxQuads, bool onlyColored)
+static RenderGroup CreateRendererGroup(RenderGroupTypeE rendererGroupType, int shaderProgram, int maxQuads, VertexLayoutE vertexLayout, bool onlyColored)
 {
+	int quads = maxQuads / RENDER_GROUP_INITIAL_DIV;
+
 	RenderGroup rendGrp = {0};
 	rendGrp.renderGroupType = rendererGroupType;
 	rendGrp.shaderProgram = shaderProgram;
-	rendGrp.renderCommands.maxIndexCount = maxQuads * 6;
-	rendGrp.renderCommands.indexArray = (U16*)malloc(maxQuads * 6 * sizeof(U32));
+	rendGrp.renderCommands.maxIndexCount = quads * 6;
+	rendGrp.renderCommands.indexLimit = maxQuads * 6;
+	rendGrp.renderCommands.indexArray = (U32*)malloc(quads * 6 * sizeof(U32));
 	rendGrp.renderCommands.indexCount = 0;
-
-	rendGrp.renderCommands.maxVertexCount = maxQuads * 4;
+	rendGrp.renderCommands.sortedIndexArray = malloc(quads * 6 * sizeof(U32));
+
+	// Every entry holds at least one triangle.
+	rendGrp.renderCommands.maxEntryCount = rendGrp.renderCommands.maxIndexCount / 3;
+	rendGrp.renderCommands.entryLimit = rendGrp.renderCommands.indexLimit / 3;
+	rendGrp.renderCommands.entryArray = (RenderEntry*)malloc(rendGrp.renderCommands.maxEntryCount * sizeof(RenderEntry));
+	rendGrp.renderCommands.entryCount = 0;
+	rendGrp.renderCommands.batchArray = (RenderBatch*)malloc(rendGrp.renderCommands.maxEntryCount * sizeof(RenderBatch));
+	rendGrp.renderCommands.batchCount = 0;
+
+	rendGrp.renderCommands.maxVertexCount = quads * 4;
+	rendGrp.renderCommands.vertexLimit = maxQuads * 4;
 	rendGrp.renderCommands.vertexCount = 0;
+	rendGrp.renderCommands.vertexLayout = vertexLayout;
 	if (onlyColored)
 	{
-		rendGrp.renderCommands.onlyColoredVertexArray = (ColoredVertex*)malloc(maxQuads * 4 * sizeof(ColoredVertex));
+		rendGrp.renderCommands.onlyColoredVertexArray = (ColoredVertex*)malloc(quads * 4 * sizeof(ColoredVertex));
+		rendGrp.renderCommands.packedColoredVertexArray = (PackedColoredVertex*)rendGrp.renderCommands.onlyColoredVertexArray;
 	}
 	else
 	{
-		rendGrp.renderCommands.vertexArray = (TexturedVertex*)malloc(maxQuads * 4 * sizeof(TexturedVertex));
+		rendGrp.renderCommands.vertexArray = (TexturedVertex*)malloc(quads * 4 * sizeof(TexturedVertex));
+		rendGrp.renderCommands.packedVertexArray = (PackedTexturedVertex*)rendGrp.renderCommands.vertexArray;
 	}
 
 	return rendGrp;
 }
 
+static RenderGroup CreateInstancedRendererGroup(RenderGroupTypeE rendererGroupType, int shaderProgram, int maxInstances)
+{
+	int instances = maxInstances / RENDER_GROUP_INITIAL_DIV;
+
+	RenderGroup rendGrp = {0};
+	rendGrp.renderGroupType = rendererGroupType;
+	rendGrp.shaderProgram = shaderProgram;
+	rendGrp.renderCommands.maxInstanceCount = instances;
+	rendGrp.renderCommands.instanceLimit = maxInstances;
+	rendGrp.renderCommands.instanceArray = (SpriteInstance*)malloc(instances * sizeof(SpriteInstance));
+	rendGrp.renderCommands.sortedInstanceArray = (SpriteInstance*)malloc(instances * sizeof(SpriteInstance));
+
+	rendGrp.renderCommands.maxEntryCount = instances;
+	rendGrp.renderCommands.entryLimit = maxInstances;
+	rendGrp.renderCommands.entryArray = (RenderEntry*)malloc(instances * sizeof(RenderEntry));
+	rendGrp.renderCommands.batchArray = (RenderBatch*)malloc(instances * sizeof(RenderBatch));
+
+	return rendGrp;
+}
+
+static RenderGroup CreateParticleRendererGroup(RenderGroupTypeE rendererGroupType, int shaderProgram, int maxParticles)
+{
+	int particles = maxParticles / RENDER_GROUP_INITIAL_DIV;
+
+	RenderGroup rendGrp = {0};
+	rendGrp.renderGroupType = rendererGroupType;
+	rendGrp.shaderProgram = shaderProgram;
+	rendGrp.renderCommands.maxInstanceCount = particles;
+	rendGrp.renderCommands.instanceLimit = maxParticles;
+	rendGrp.renderCommands.particleArray = (ParticleInstance*)malloc(particles * sizeof(ParticleInstance));
+
+	return rendGrp;
+}
+
 static RenderGroup* FindRenderGroup(Renderer* renderer_p, RenderGroupTypeE rendererGroupType)
 {
 	for (size_t i = 0; i < renderer_p->groupCnt; i++)
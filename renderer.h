@@ -2,13 +2,21 @@
 #include "common.h"
 #include "vector.h"
 #include "texture.h"
+#include "atlas.h"
 #include "rect.h"
 #include "color.h"
 #include <stb_truetype.h>
+#include "font.h"
+#include "textlayout.h"
 
 #define MAX_RENDER_GROUPS 16
+#define RENDER_FRAME_COUNT 3 // One frame being built, one queued for the render thread and one being drawn.
+#define MAX_STATIC_MESHES 16
+#define MAX_STATIC_MESH_DRAWS 64 // Per group and frame.
+#define STATIC_MESH_NONE -1
 
 typedef S16 TextureHandleT;
+typedef int StaticMeshHandleT;
 
 enum RenderGroupTypeE
 {
@@ -17,6 +25,18 @@ enum RenderGroupTypeE
 	RENDER_GROUP_TEXT_DEFAULT,
 	RENDER_GROUP_UI,
 	RENDER_GROUP_WIREFRAME,
+	RENDER_GROUP_PARTICLES,
+};
+
+// Draw order within a render group. Higher layers are drawn on top of lower ones.
+// The layer sits above the texture handle in the sort key, so textures are only
+// grouped together within the same layer and explicit draw order is never broken.
+enum RenderLayerE : U8
+{
+	RENDER_LAYER_BACKGROUND,
+	RENDER_LAYER_DEFAULT,
+	RENDER_LAYER_FOREGROUND,
+	RENDER_LAYER_EFFECTS,
 };
 
 struct TexturedVertex
@@ -33,6 +53,67 @@ struct ColoredVertex
 	Color color;
 };
 
+// Compact versions of the two above, 12 and 20 bytes vs 28 and 40. z was always 0 so it is dropped.
+struct PackedColoredVertex
+{
+	Vector2 pos;
+	Color32 color; // RGBA8.
+};
+
+struct PackedTexturedVertex
+{
+	Vector2 pos;
+	U16 uv[2];       // unorm16.
+	Color32 color;   // RGBA8.
+	U8 textureLayer; // Not an attribute, the texture is bound per batch like TexturedVertex::textureHandle.
+	U8 pad[3];
+};
+
+enum VertexLayoutE : U8
+{
+	VERTEX_LAYOUT_FLOAT,  // TexturedVertex / ColoredVertex.
+	VERTEX_LAYOUT_PACKED, // PackedTexturedVertex / PackedColoredVertex.
+};
+
+// One sprite, expanded into a quad by shaders/sprite_shader.vs. 32 bytes vs 4 TexturedVertex + 6 indices.
+// The texture handle is not stored, it only lives in the sort key and selects the texture per batch.
+struct SpriteInstance
+{
+	Vector2 pos;
+	Vector2 halfSize;
+	S16 facing[2]; // Normalized facing vector, snorm16.
+	Color32 color; // RGBA8.
+	U16 uv[4];     // uv of the MinXMinY and MaxXMaxY corners, unorm16.
+};
+
+// One particle, expanded into a round point sprite by shaders/particle_shader.vs.
+struct ParticleInstance
+{
+	Vector2 pos;
+	float size;    // Diameter.
+	Color32 color; // RGBA8.
+};
+
+// Wireframe geometry captured once between StaticMeshBegin and StaticMeshEnd. The backend uploads it to a
+// GL_STATIC_DRAW buffer the first time it is drawn, from then on a draw costs no vertex generation or upload.
+struct StaticMesh
+{
+	VertexLayoutE vertexLayout;
+	U32 vertexCount;
+	U32 indexCount;
+	void* vertices_p;  // ColoredVertex or PackedColoredVertex.
+	U32* indices_p;
+	Vector2 boundsMin; // Culled with these.
+	Vector2 boundsMax;
+};
+
+struct StaticMeshDraw
+{
+	StaticMeshHandleT mesh;
+	Vector2 offset; // World position = offset + scale * mesh position.
+	float scale;
+};
+
 struct OrtographicProj
 {
 	float xmin;
@@ -41,16 +122,90 @@ struct OrtographicProj
 	float ymax;
 };
 
+// Sort key layout (most significant bits first):
+//   [63..56] layer          RenderLayerE
+//   [55..40] texture handle TextureHandleT, 0 for untextured groups
+//   [39..0]  sequence       Submission order, makes the sort stable
+// Render group and shader don't need bits since every group has its own command
+// stream and groups are drawn in the order of Renderer::renderGroups.
+typedef U64 RenderSortKeyT;
+
+// For instanced groups firstIndex and indexCount refer to instances instead of indices.
+struct RenderEntry
+{
+	RenderSortKeyT sortKey;
+	U32 firstIndex;
+	U32 indexCount;
+};
+
+// Contiguous range of sorted indices (or instances) that is drawn with a single draw call.
+struct RenderBatch
+{
+	TextureHandleT textureHandle;
+	U32 firstIndex;
+	U32 indexCount;
+};
+
+// Capacities start small and double on demand up to the limits, growing only ever happens on the game thread
+// to the commands of the frame being built. Every frame keeps what it grew to and reuses it from then on.
 struct RenderCommands
 {
 	U32 maxVertexCount;
+	U32 vertexLimit;
 	U32 vertexCount;
+	VertexLayoutE vertexLayout;
 	TexturedVertex* vertexArray;
 	ColoredVertex* onlyColoredVertexArray;
+	// Alias the array above, which is sized for the float layout, so a group can switch layout between frames.
+	PackedTexturedVertex* packedVertexArray;
+	PackedColoredVertex* packedColoredVertexArray;
 
 	U32 maxIndexCount;
+	U32 indexLimit;
 	U32 indexCount;
-	U16* indexArray;
+	U32* indexArray;
+
+	U32 maxEntryCount;
+	U32 entryLimit;
+	U32 entryCount;
+	RenderEntry* entryArray;
+
+	U32 batchCount;
+	RenderBatch* batchArray;       // Same capacity as entryArray.
+	U32 sortedIndexSize;           // 2 while every vertex can be reached with 16 bits, 4 past that.
+	void* sortedIndexArray;        // indexArray reordered by sort key and narrowed to sortedIndexSize, filled by RendererSortAndBatch.
+
+	// Instanced groups only use these, no vertices or indices.
+	U32 maxInstanceCount;
+	U32 instanceLimit;
+	U32 instanceCount;
+	SpriteInstance* instanceArray;
+	SpriteInstance* sortedInstanceArray; // instanceArray reordered by sort key, filled by RendererSortAndBatch.
+
+	// The particle group is drawn unsorted with a single draw call, instanceCount counts particles.
+	ParticleInstance* particleArray;
+
+	// Drawn after the group's batches, with the same shader and state.
+	U32 staticDrawCount;
+	StaticMeshDraw staticDraws[MAX_STATIC_MESH_DRAWS];
+};
+
+// Accumulated since startup, the peaks are what the group's initial capacities and limits should be sized from.
+struct RenderBudgetStats
+{
+	U32 peakVertices;
+	U32 peakIndices;
+	U32 peakInstances;
+	U32 peakEntries;
+	U32 grows;   // Reallocations of the command buffers, in any frame.
+	U64 dropped; // Pushes refused because the group was at its limit.
+};
+
+// World space pushes tested against the group's ortoProj, accumulated since startup.
+struct RenderCullStats
+{
+	U64 visible;
+	U64 culled;
 };
 
 struct RenderGroup
@@ -58,41 +213,110 @@ struct RenderGroup
 	RenderGroupTypeE renderGroupType;
 	int shaderProgram;
 	RenderCommands renderCommands;
-	OrtographicProj ortoProj;
+	OrtographicProj ortoProj; // Also the cull rect. Until one is set (screen space groups) nothing is culled.
+	RenderCullStats cullStats;
+	RenderBudgetStats budgetStats;
 };
 
+#define FONT_SIZE 16.0f // Default text size in pixels, any other size renders from the same distance field.
+
 struct TextRendering
 {
-	Texture textTexture;
-	stbtt_bakedchar charUvData[96]; // ASCII 32..126 is 95 glyphs
+	Font font;
+
+	bool useLayoutCache; // PushText and GetTextWidth reuse laid out strings instead of walking the glyphs again.
+	TextLayoutCache layoutCache;
 };
 
-struct Renderer
+// What the backend measured while drawing a group.
+struct RenderGroupStats
+{
+	double gpuMs;       // GL_TIME_ELAPSED of this group some frames earlier, queries are read back without stalling.
+	U32 drawCalls;
+	U32 vertices;       // Indices for indexed draws, 4 per instance for instanced ones.
+	U64 bytesUploaded;
+};
+
+// Frozen copy of the groups handed to the backend. Every frame owns its own set of command buffers,
+// so the game can build the next frame while this one is drawn.
+struct RenderFrame
 {
 	int groupCnt;
 	RenderGroup renderGroups[MAX_RENDER_GROUPS];
+	Vector2 screenDim;
+	Vector2 framebufferDim;
+	RenderGroupStats groupStats[MAX_RENDER_GROUPS]; // Filled in by the backend when it draws the frame.
+	const StaticMesh* staticMeshes_p;               // Renderer::staticMeshes, never modified once created.
+};
+
+// Where the wireframe group stood when StaticMeshBegin was called, everything pushed since goes into the mesh.
+struct StaticMeshCapture
+{
+	bool active;
+	U32 firstVertex;
+	U32 firstIndex;
+	U32 firstEntry;
+	OrtographicProj ortoProj; // Cleared while capturing so nothing is culled.
+};
+
+struct Renderer
+{
+	int groupCnt;
+	RenderGroup renderGroups[MAX_RENDER_GROUPS]; // Groups being built, their commands point into frames[buildFrame].
+
+	RenderFrame frames[RENDER_FRAME_COUNT];
+	int buildFrame;
+	Vector2 screenDim;      // Set by the platform layer, copied into every frame.
+	Vector2 framebufferDim;
 
 	TextRendering textRendering;
+
+	bool useAtlas; // PushSprite remaps every sprite into TEXTURE_ATLAS.
+	Rect atlasUvRects[TEXTURES_COUNT];
+
+	int staticMeshCount;
+	StaticMesh staticMeshes[MAX_STATIC_MESHES];
+	StaticMeshCapture staticMeshCapture;
 };
 
 extern Renderer* rendererGl_p; // Used for debugging.
 
 void RendererInit(Renderer* renderer_p);
+bool RendererBakeFont(); // Rebuilds the font blob from the TTF.
+void RendererSetTextureAtlas(Renderer* renderer_p, const TextureAtlas* atlas_p);
+void RendererSortAndBatch(Renderer* renderer_p);
 void RendererEndFrame(Renderer* renderer_p);
+
+// Freezes the commands built so far into frames[buildFrame] and continues building into the buffers of
+// nextFrame, which the backend must be done with. With clear false the frozen commands are carried over.
+// Returns the frozen frame.
+RenderFrame* RendererSwapFrame(Renderer* renderer_p, int nextFrame, bool clear);
+const RenderFrame* RendererGetLastDrawnFrame(const Renderer* renderer_p); // Most recent frame the backend handed back, with its stats.
+void RendererSetVertexLayout(Renderer* renderer_p, RenderGroupTypeE renderGroupType, VertexLayoutE vertexLayout); // Only between frames, from the next one on.
+U32 RenderVertexSize(const RenderCommands* renderCmds_p); // Bytes per vertex in the group's layout.
+const char* RenderGroupName(RenderGroupTypeE renderGroupType);
 void SetSpritesOrtographicProj(Renderer* renderer_p, Rect rect);
 void SetWireframeOrtographicProj(Renderer* renderer_p, Rect rect);
-void PushSprite(Renderer* renderer_p, Vector2 pos, Vector2 size, Vector2 facingV, TextureHandleT textureHandle, Color color = COLOR_WHITE, Rect uvRect = RECT_ONE);
+void SetParticlesOrtographicProj(Renderer* renderer_p, Rect rect);
+void PushSprite(Renderer* renderer_p, Vector2 pos, Vector2 size, Vector2 facingV, TextureHandleT textureHandle, Color color = COLOR_WHITE, Rect uvRect = RECT_ONE, RenderLayerE layer = RENDER_LAYER_DEFAULT);
 void PushUiRect(Renderer* renderer_p, Rect rect, Color color);
 void PushUiRect01(Renderer* renderer_p, Rect rect01, Color color);
-void PushText(Renderer* renderer_p, const char* text, Vector2 pos, Color color, float maxX = F32_MAX);
+void PushText(Renderer* renderer_p, const char* text, Vector2 pos, Color color, float maxX = F32_MAX, float fontSize = FONT_SIZE);
 void PushText01(Renderer* renderer_p, const char* text, Vector2 pos01, Color color);
 void PushRect(Renderer* renderer_p, Rect rect, Color color, Vector2 facingV  = VECTOR2_UP);
 void PushLine(Renderer* renderer_p, Vector2 startPos, Vector2 endPos, Color color, float thickness = 0.1f);
+ParticleInstance* PushParticles(Renderer* renderer_p, U32 count); // Space for count particles, filled in by the caller. nullptr when the group is at its limit.
 void PushCircle(Renderer* renderer_p, Vector2 centerPos, float radius, Color color, int edges = 16);
 void PushVector(Renderer* renderer_p, Vector2 pos, Vector2 v, Color color = COLOR_WHITE);
 void PushXCross(Renderer* renderer_p, Vector2 pos, Color color);
-float GetCharPosX(stbtt_bakedchar* bakedCharData_p, float startPosX, const char* text, int charIdx);
-float GetTextWidth(Renderer* renderer_p, const char* text);
+
+// Wireframe pushes between these two go into a new static mesh instead of the frame. Meshes live as long as
+// the renderer, so build each one once.
+void StaticMeshBegin(Renderer* renderer_p);
+StaticMeshHandleT StaticMeshEnd(Renderer* renderer_p); // STATIC_MESH_NONE when nothing was pushed or every mesh is taken.
+void PushStaticMesh(Renderer* renderer_p, StaticMeshHandleT mesh, Vector2 offset = VECTOR2_ZERO, float scale = 1.0f);
+float GetCharPosX(const Font* font_p, float startPosX, const char* text, int charIdx);
+float GetTextWidth(Renderer* renderer_p, const char* text, float fontSize = FONT_SIZE);
 
 extern Vector2 ScreenDim;
 static inline Vector2 Coord01ToScreenCoordText(Vector2 coord01)
@@ -0,0 +1,92 @@
+#include <assert.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "timing.h"
+#include "renderthread.h"
+
+static void RenderThreadMain(RenderThread* renderThread_p)
+{
+	if (renderThread_p->window) glfwMakeContextCurrent(renderThread_p->window);
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(renderThread_p->mutex);
+			renderThread_p->frameQueued.wait(lock, [renderThread_p] {
+				return (renderThread_p->handoff.load(std::memory_order_acquire) & RENDER_FRAME_QUEUED) || renderThread_p->quit.load(std::memory_order_acquire);
+			});
+		}
+
+		// On quit a frame that is still queued gets drawn first.
+		U32 handoff = renderThread_p->handoff.load(std::memory_order_acquire);
+		if (!(handoff & RENDER_FRAME_QUEUED)) break;
+
+		// The frame drawn last goes back to the game, which builds into it next.
+		{
+			std::lock_guard<std::mutex> lock(renderThread_p->mutex);
+			renderThread_p->handoff.store((U32)renderThread_p->drawFrame, std::memory_order_release);
+		}
+		renderThread_p->frameFreed.notify_one();
+		renderThread_p->drawFrame = (int)(handoff & ~RENDER_FRAME_QUEUED);
+
+		double tStart = GetTime();
+		OpenGLEndFrame(renderThread_p->openGl_p, &renderThread_p->renderer_p->frames[renderThread_p->drawFrame]);
+		if (renderThread_p->window) glfwSwapBuffers(renderThread_p->window);
+		renderThread_p->stats.renderSeconds += GetTime() - tStart;
+		renderThread_p->stats.frames++;
+	}
+
+	if (renderThread_p->window) glfwMakeContextCurrent(nullptr);
+}
+
+void RenderThreadStart(RenderThread* renderThread_p, OpenGL* openGl_p, Renderer* renderer_p, GLFWwindow* window)
+{
+	renderThread_p->openGl_p = openGl_p;
+	renderThread_p->renderer_p = renderer_p;
+	renderThread_p->window = window;
+	renderThread_p->stats = {};
+
+	// Game builds into buildFrame, the other two start out free.
+	renderThread_p->handoff.store((U32)((renderer_p->buildFrame + 1) % RENDER_FRAME_COUNT));
+	renderThread_p->drawFrame = (renderer_p->buildFrame + 2) % RENDER_FRAME_COUNT;
+	renderThread_p->quit.store(false);
+
+	if (window) glfwMakeContextCurrent(nullptr);
+	renderThread_p->tStart = GetTime();
+	renderThread_p->thread = std::thread(RenderThreadMain, renderThread_p);
+}
+
+void RenderThreadSubmit(RenderThread* renderThread_p, bool clear)
+{
+	double tStart = GetTime();
+	U32 handoff = renderThread_p->handoff.load(std::memory_order_acquire);
+	if (handoff & RENDER_FRAME_QUEUED)
+	{
+		std::unique_lock<std::mutex> lock(renderThread_p->mutex);
+		renderThread_p->frameFreed.wait(lock, [renderThread_p] { return !(renderThread_p->handoff.load(std::memory_order_acquire) & RENDER_FRAME_QUEUED); });
+		handoff = renderThread_p->handoff.load(std::memory_order_acquire);
+	}
+	renderThread_p->stats.gameWaitSeconds += GetTime() - tStart;
+
+	int builtFrame = renderThread_p->renderer_p->buildFrame;
+	RendererSwapFrame(renderThread_p->renderer_p, (int)handoff, clear);
+	{
+		std::lock_guard<std::mutex> lock(renderThread_p->mutex);
+		renderThread_p->handoff.store((U32)builtFrame | RENDER_FRAME_QUEUED, std::memory_order_release);
+	}
+	renderThread_p->frameQueued.notify_one();
+}
+
+void RenderThreadStop(RenderThread* renderThread_p)
+{
+	assert(renderThread_p->thread.joinable());
+	{
+		std::lock_guard<std::mutex> lock(renderThread_p->mutex);
+		renderThread_p->quit.store(true, std::memory_order_release);
+	}
+	renderThread_p->frameQueued.notify_one();
+	renderThread_p->thread.join();
+	renderThread_p->stats.wallSeconds = GetTime() - renderThread_p->tStart;
+
+	if (renderThread_p->window) glfwMakeContextCurrent(renderThread_p->window);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "common.h"
+#include "renderer.h"
+#include "opengl.h"
+
+struct GLFWwindow;
+
+#define RENDER_FRAME_QUEUED 0x80000000u // Set in RenderThread.handoff while the frame there waits to be drawn.
+
+struct RenderThreadStats
+{
+	U64 frames;             // Frames drawn.
+	double renderSeconds;   // Render thread busy in OpenGLEndFrame and the buffer swap.
+	double gameWaitSeconds; // Game thread blocked in RenderThreadSubmit on a frame that was still queued.
+	double wallSeconds;     // RenderThreadStart to RenderThreadStop.
+};
+
+// Owns the GL context and draws frame N while the game thread builds frame N+1. The handoff is one atomic
+// frame index: while RENDER_FRAME_QUEUED is set it belongs to the render thread, which swaps in the frame
+// it finished drawing; otherwise it belongs to the game thread, which swaps in the frame it just built.
+// With RENDER_FRAME_COUNT frames each side always has one to itself and nothing is copied. A side with
+// nothing to do sleeps on a condition variable until the other one flips the flag.
+struct RenderThread
+{
+	OpenGL* openGl_p;
+	Renderer* renderer_p;
+	GLFWwindow* window;       // nullptr when headless.
+
+	std::atomic<U32> handoff; // Frame index, | RENDER_FRAME_QUEUED.
+	std::atomic<bool> quit;
+	std::mutex mutex;         // Only guards the wakeups.
+	std::condition_variable frameQueued; // Render thread waits for a frame or quit.
+	std::condition_variable frameFreed;  // Game thread waits for the queued frame to be taken.
+	std::thread thread;
+	int drawFrame;            // Only touched by the render thread.
+
+	double tStart;
+	RenderThreadStats stats;
+};
+
+// The calling thread must have the context current, it is released and made current on the render thread.
+void RenderThreadStart(RenderThread* renderThread_p, OpenGL* openGl_p, Renderer* renderer_p, GLFWwindow* window);
+// Called by the game thread once the frame is sorted and batched. Blocks while the previous frame is still queued.
+void RenderThreadSubmit(RenderThread* renderThread_p, bool clear);
+// Draws whatever is still queued, joins and makes the context current on the calling thread again.
+void RenderThreadStop(RenderThread* renderThread_p);
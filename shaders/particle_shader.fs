@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 color;
+
+in vec4 ourColor;
+in vec2 Local;
+
+void main()
+{
+    // Round point with a soft edge.
+    float falloff = 1.0 - smoothstep(0.5, 1.0, length(Local));
+    color = vec4(ourColor.rgb, ourColor.a * falloff);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 3) in vec2 iPos;
+layout (location = 4) in float iSize;
+layout (location = 5) in vec4 iColor;
+
+out vec4 ourColor;
+out vec2 Local;
+
+uniform mat4 transform;
+
+void main()
+{
+    // Drawn as a 4 vertex triangle strip per instance, the quad always faces the camera.
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    Local = corner * 2.0 - 1.0;
+    vec2 pos = iPos + 0.5 * iSize * Local;
+
+    gl_Position = transform * vec4(pos, 0.0, 1.0);
+    ourColor = iColor;
+}
@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 3) in vec2 iPos;
+layout (location = 4) in vec2 iHalfSize;
+layout (location = 5) in vec2 iFacing;
+layout (location = 6) in vec4 iColor;
+layout (location = 7) in vec4 iUv; // xy = uv at MinXMinY, zw = uv at MaxXMaxY
+
+out vec4 ourColor;
+out vec2 TexCoord;
+
+uniform mat4 transform;
+
+void main()
+{
+    // Drawn as a 4 vertex triangle strip per instance.
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    vec2 local = (corner * 2.0 - 1.0) * iHalfSize;
+
+    // Local up axis is the facing vector, right axis is facing rotated by -90 degrees.
+    vec2 right = vec2(iFacing.y, -iFacing.x);
+    vec2 pos = iPos + local.x * right + local.y * iFacing;
+
+    gl_Position = transform * vec4(pos, 0.0, 1.0);
+    ourColor = iColor;
+    TexCoord = mix(iUv.xy, iUv.zw, corner);
+}
\ No newline at end of file
@@ -8,6 +8,9 @@ uniform sampler2D ourTexture;
 
 void main()
 {
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(ourTexture, TexCoord).r);
-    color = ourColor * sampled;
-}
\ No newline at end of file
+    // Signed distance field, the outline sits at 0.5. fwidth keeps the edge about a pixel wide at any text size.
+    float dist = texture(ourTexture, TexCoord).r;
+    float edge = fwidth(dist);
+    float alpha = smoothstep(0.5 - edge, 0.5 + edge, dist);
+    color = vec4(ourColor.rgb, ourColor.a * alpha);
+}
@@ -1,5 +1,5 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
+layout (location = 0) in vec2 aPos;
 layout (location = 1) in vec4 aColor;
 layout (location = 2) in vec2 aTexCoord;
 
@@ -10,7 +10,7 @@ uniform mat4 transform;
 
 void main()
 {
-    gl_Position = transform * vec4(aPos, 1.0);
+    gl_Position = transform * vec4(aPos, 0.0, 1.0);
     ourColor = aColor;
     TexCoord = aTexCoord;
 }
\ No newline at end of file
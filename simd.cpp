@@ -0,0 +1,444 @@
+#include <string.h>
+#include <math.h>
+#include "simd.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+// MSVC compiles AVX2 intrinsics anywhere, gcc and clang only in functions built for the target.
+#if defined(_MSC_VER)
+#define SIMD_AVX2_TARGET
+#else
+#define SIMD_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+#define SIMD_DEG_TO_RAD  (PI / 180.0f)
+#define SIMD_INV_TWO_PI  0.159154943f
+#define SIMD_TWO_PI_HI   6.28125f       // 2 pi split in two, the high part exact in few bits so k * hi has no rounding.
+#define SIMD_TWO_PI_LO   0.00193530717f
+#define SIMD_HALF_PI     1.57079633f
+#define SIMD_PI          3.14159265f
+
+// Taylor coefficients, on [-pi/2, pi/2] they are within float precision.
+#define SIMD_S3  (-1.0f / 6.0f)
+#define SIMD_S5  (1.0f / 120.0f)
+#define SIMD_S7  (-1.0f / 5040.0f)
+#define SIMD_S9  (1.0f / 362880.0f)
+#define SIMD_S11 (-1.0f / 39916800.0f)
+#define SIMD_C2  (-1.0f / 2.0f)
+#define SIMD_C4  (1.0f / 24.0f)
+#define SIMD_C6  (-1.0f / 720.0f)
+#define SIMD_C8  (1.0f / 40320.0f)
+#define SIMD_C10 (-1.0f / 3628800.0f)
+#define SIMD_C12 (1.0f / 479001600.0f)
+
+// Scalar
+
+// Reduced to [-pi, pi] and then folded into [-pi/2, pi/2], where the polynomials hold.
+static inline void SinCos(float rad, float* sin_p, float* cos_p)
+{
+	float k = rintf(rad * SIMD_INV_TWO_PI);
+	float r = (rad - k * SIMD_TWO_PI_HI) - k * SIMD_TWO_PI_LO;
+	float cosSign = 1.0f;
+	if (r > SIMD_HALF_PI) { r = SIMD_PI - r; cosSign = -1.0f; }
+	else if (r < -SIMD_HALF_PI) { r = -SIMD_PI - r; cosSign = -1.0f; }
+
+	float r2 = r * r;
+	*sin_p = r + r * r2 * (SIMD_S3 + r2 * (SIMD_S5 + r2 * (SIMD_S7 + r2 * (SIMD_S9 + r2 * SIMD_S11))));
+	*cos_p = cosSign * (1.0f + r2 * (SIMD_C2 + r2 * (SIMD_C4 + r2 * (SIMD_C6 + r2 * (SIMD_C8 + r2 * (SIMD_C10 + r2 * SIMD_C12))))));
+}
+
+static void MulAddScalar(float* dst_p, const float* src_p, int count, float scale)
+{
+	for (int i = 0; i < count; i++) dst_p[i] += scale * src_p[i];
+}
+
+static void IntegrateIdsScalar(Vector2* pos_p, const Vector2* vel_p, const U16* ids_p, int count, float deltaT)
+{
+	for (int i = 0; i < count; i++)
+	{
+		U16 id = ids_p[i];
+		pos_p[id] += deltaT * vel_p[id];
+	}
+}
+
+static inline void RotateScalar(Vector2* v_p, float deg)
+{
+	float s, c;
+	SinCos(SIMD_DEG_TO_RAD * deg, &s, &c);
+	Vector2 v = *v_p;
+	*v_p = V2(v.x * c - v.y * s, v.y * c + v.x * s);
+}
+
+static void RotateIdsScalar(Vector2* facingV_p, const float* rotSpeed_p, const U16* ids_p, int count, float deltaT)
+{
+	for (int i = 0; i < count; i++)
+	{
+		U16 id = ids_p[i];
+		RotateScalar(&facingV_p[id], rotSpeed_p[id] * deltaT);
+	}
+}
+
+static void ExpiredIdsScalar(const double* tEnabled_p, const U16* ids_p, int count, double time, double lifetime, U32 mask_p[])
+{
+	memset(mask_p, 0, SIMD_MASK_WORDS(count) * sizeof(U32));
+	for (int i = 0; i < count; i++)
+	{
+		if ((time - tEnabled_p[ids_p[i]]) > lifetime) mask_p[i >> 5] |= 1u << (i & 31);
+	}
+}
+
+static void AtLeastScalar(const float* values_p, int count, float threshold, U32 mask_p[])
+{
+	memset(mask_p, 0, SIMD_MASK_WORDS(count) * sizeof(U32));
+	for (int i = 0; i < count; i++)
+	{
+		if (values_p[i] >= threshold) mask_p[i >> 5] |= 1u << (i & 31);
+	}
+}
+
+#if SIMD_X86
+
+// SSE2, two Vector2 per register for the entity kernels.
+
+static inline __m128 Select128(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline void SinCos128(__m128 rad, __m128* sin_p, __m128* cos_p)
+{
+	__m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(rad, _mm_set1_ps(SIMD_INV_TWO_PI))));
+	__m128 r = _mm_sub_ps(_mm_sub_ps(rad, _mm_mul_ps(k, _mm_set1_ps(SIMD_TWO_PI_HI))), _mm_mul_ps(k, _mm_set1_ps(SIMD_TWO_PI_LO)));
+	__m128 above = _mm_cmpgt_ps(r, _mm_set1_ps(SIMD_HALF_PI));
+	__m128 below = _mm_cmplt_ps(r, _mm_set1_ps(-SIMD_HALF_PI));
+	r = Select128(above, _mm_sub_ps(_mm_set1_ps(SIMD_PI), r), Select128(below, _mm_sub_ps(_mm_set1_ps(-SIMD_PI), r), r));
+	__m128 cosSign = _mm_and_ps(_mm_or_ps(above, below), _mm_set1_ps(-0.0f));
+
+	__m128 r2 = _mm_mul_ps(r, r);
+	__m128 s = _mm_add_ps(_mm_set1_ps(SIMD_S9), _mm_mul_ps(r2, _mm_set1_ps(SIMD_S11)));
+	s = _mm_add_ps(_mm_set1_ps(SIMD_S7), _mm_mul_ps(r2, s));
+	s = _mm_add_ps(_mm_set1_ps(SIMD_S5), _mm_mul_ps(r2, s));
+	s = _mm_add_ps(_mm_set1_ps(SIMD_S3), _mm_mul_ps(r2, s));
+	*sin_p = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+
+	__m128 c = _mm_add_ps(_mm_set1_ps(SIMD_C10), _mm_mul_ps(r2, _mm_set1_ps(SIMD_C12)));
+	c = _mm_add_ps(_mm_set1_ps(SIMD_C8), _mm_mul_ps(r2, c));
+	c = _mm_add_ps(_mm_set1_ps(SIMD_C6), _mm_mul_ps(r2, c));
+	c = _mm_add_ps(_mm_set1_ps(SIMD_C4), _mm_mul_ps(r2, c));
+	c = _mm_add_ps(_mm_set1_ps(SIMD_C2), _mm_mul_ps(r2, c));
+	*cos_p = _mm_xor_ps(_mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, c)), cosSign);
+}
+
+static inline __m128 LoadPair(const Vector2* a_p, const Vector2* b_p)
+{
+	return _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)a_p), (const __m64*)b_p);
+}
+
+static inline void StorePair(Vector2* a_p, Vector2* b_p, __m128 v)
+{
+	_mm_storel_pi((__m64*)a_p, v);
+	_mm_storeh_pi((__m64*)b_p, v);
+}
+
+// (x, y) pairs rotated by the angle in the matching lanes: (x c - y s, y c + x s).
+static inline __m128 RotatePairs128(__m128 v, __m128 s, __m128 c)
+{
+	__m128 swapped = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 signedS = _mm_xor_ps(s, _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f));
+	return _mm_add_ps(_mm_mul_ps(v, c), _mm_mul_ps(swapped, signedS));
+}
+
+static void MulAddSse2(float* dst_p, const float* src_p, int count, float scale)
+{
+	__m128 scale4 = _mm_set1_ps(scale);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(dst_p + i, _mm_add_ps(_mm_loadu_ps(dst_p + i), _mm_mul_ps(scale4, _mm_loadu_ps(src_p + i))));
+	}
+	MulAddScalar(dst_p + i, src_p + i, count - i, scale);
+}
+
+static void IntegrateIdsSse2(Vector2* pos_p, const Vector2* vel_p, const U16* ids_p, int count, float deltaT)
+{
+	__m128 deltaT4 = _mm_set1_ps(deltaT);
+	int i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		U16 a = ids_p[i], b = ids_p[i + 1];
+		__m128 pos = _mm_add_ps(LoadPair(&pos_p[a], &pos_p[b]), _mm_mul_ps(deltaT4, LoadPair(&vel_p[a], &vel_p[b])));
+		StorePair(&pos_p[a], &pos_p[b], pos);
+	}
+	IntegrateIdsScalar(pos_p, vel_p, ids_p + i, count - i, deltaT);
+}
+
+static void RotateIdsSse2(Vector2* facingV_p, const float* rotSpeed_p, const U16* ids_p, int count, float deltaT)
+{
+	int i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		U16 a = ids_p[i], b = ids_p[i + 1];
+		float degA = rotSpeed_p[a] * deltaT;
+		float degB = rotSpeed_p[b] * deltaT;
+		__m128 rad = _mm_mul_ps(_mm_set1_ps(SIMD_DEG_TO_RAD), _mm_setr_ps(degA, degA, degB, degB));
+		__m128 s, c;
+		SinCos128(rad, &s, &c);
+		StorePair(&facingV_p[a], &facingV_p[b], RotatePairs128(LoadPair(&facingV_p[a], &facingV_p[b]), s, c));
+	}
+	RotateIdsScalar(facingV_p, rotSpeed_p, ids_p + i, count - i, deltaT);
+}
+
+static void ExpiredIdsSse2(const double* tEnabled_p, const U16* ids_p, int count, double time, double lifetime, U32 mask_p[])
+{
+	memset(mask_p, 0, SIMD_MASK_WORDS(count) * sizeof(U32));
+	__m128d time2 = _mm_set1_pd(time);
+	__m128d lifetime2 = _mm_set1_pd(lifetime);
+	int i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128d tEnabled = _mm_setr_pd(tEnabled_p[ids_p[i]], tEnabled_p[ids_p[i + 1]]);
+		U32 bits = (U32)_mm_movemask_pd(_mm_cmpgt_pd(_mm_sub_pd(time2, tEnabled), lifetime2));
+		mask_p[i >> 5] |= bits << (i & 31);
+	}
+	for (; i < count; i++)
+	{
+		if ((time - tEnabled_p[ids_p[i]]) > lifetime) mask_p[i >> 5] |= 1u << (i & 31);
+	}
+}
+
+static void AtLeastSse2(const float* values_p, int count, float threshold, U32 mask_p[])
+{
+	memset(mask_p, 0, SIMD_MASK_WORDS(count) * sizeof(U32));
+	__m128 threshold4 = _mm_set1_ps(threshold);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		U32 bits = (U32)_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(values_p + i), threshold4));
+		mask_p[i >> 5] |= bits << (i & 31);
+	}
+	for (; i < count; i++)
+	{
+		if (values_p[i] >= threshold) mask_p[i >> 5] |= 1u << (i & 31);
+	}
+}
+
+// AVX2, four Vector2 per register. Entity data is gathered, the stores are split since there is no scatter.
+
+SIMD_AVX2_TARGET static inline void SinCos256(__m256 rad, __m256* sin_p, __m256* cos_p)
+{
+	__m256 k = _mm256_round_ps(_mm256_mul_ps(rad, _mm256_set1_ps(SIMD_INV_TWO_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m256 r = _mm256_sub_ps(_mm256_sub_ps(rad, _mm256_mul_ps(k, _mm256_set1_ps(SIMD_TWO_PI_HI))), _mm256_mul_ps(k, _mm256_set1_ps(SIMD_TWO_PI_LO)));
+	__m256 above = _mm256_cmp_ps(r, _mm256_set1_ps(SIMD_HALF_PI), _CMP_GT_OQ);
+	__m256 below = _mm256_cmp_ps(r, _mm256_set1_ps(-SIMD_HALF_PI), _CMP_LT_OQ);
+	r = _mm256_blendv_ps(_mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(-SIMD_PI), r), below), _mm256_sub_ps(_mm256_set1_ps(SIMD_PI), r), above);
+	__m256 cosSign = _mm256_and_ps(_mm256_or_ps(above, below), _mm256_set1_ps(-0.0f));
+
+	// Multiplies and adds kept apart, no fma, so the lanes round like the other versions.
+	__m256 r2 = _mm256_mul_ps(r, r);
+	__m256 s = _mm256_add_ps(_mm256_set1_ps(SIMD_S9), _mm256_mul_ps(r2, _mm256_set1_ps(SIMD_S11)));
+	s = _mm256_add_ps(_mm256_set1_ps(SIMD_S7), _mm256_mul_ps(r2, s));
+	s = _mm256_add_ps(_mm256_set1_ps(SIMD_S5), _mm256_mul_ps(r2, s));
+	s = _mm256_add_ps(_mm256_set1_ps(SIMD_S3), _mm256_mul_ps(r2, s));
+	*sin_p = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(r, r2), s));
+
+	__m256 c = _mm256_add_ps(_mm256_set1_ps(SIMD_C10), _mm256_mul_ps(r2, _mm256_set1_ps(SIMD_C12)));
+	c = _mm256_add_ps(_mm256_set1_ps(SIMD_C8), _mm256_mul_ps(r2, c));
+	c = _mm256_add_ps(_mm256_set1_ps(SIMD_C6), _mm256_mul_ps(r2, c));
+	c = _mm256_add_ps(_mm256_set1_ps(SIMD_C4), _mm256_mul_ps(r2, c));
+	c = _mm256_add_ps(_mm256_set1_ps(SIMD_C2), _mm256_mul_ps(r2, c));
+	*cos_p = _mm256_xor_ps(_mm256_add_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(r2, c)), cosSign);
+}
+
+SIMD_AVX2_TARGET static inline __m128i LoadIds4(const U16* ids_p)
+{
+	return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)ids_p), _mm_setzero_si128());
+}
+
+// Four Vector2 gathered as doubles, one per 64 bit lane.
+SIMD_AVX2_TARGET static inline __m256 GatherPairs(const Vector2* base_p, __m128i ids)
+{
+	return _mm256_castpd_ps(_mm256_i32gather_pd((const double*)base_p, ids, sizeof(Vector2)));
+}
+
+SIMD_AVX2_TARGET static inline void StoreQuad(Vector2* base_p, const U16* ids_p, __m256 v)
+{
+	StorePair(&base_p[ids_p[0]], &base_p[ids_p[1]], _mm256_castps256_ps128(v));
+	StorePair(&base_p[ids_p[2]], &base_p[ids_p[3]], _mm256_extractf128_ps(v, 1));
+}
+
+SIMD_AVX2_TARGET static void MulAddAvx2(float* dst_p, const float* src_p, int count, float scale)
+{
+	__m256 scale8 = _mm256_set1_ps(scale);
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(dst_p + i, _mm256_add_ps(_mm256_loadu_ps(dst_p + i), _mm256_mul_ps(scale8, _mm256_loadu_ps(src_p + i))));
+	}
+	MulAddScalar(dst_p + i, src_p + i, count - i, scale);
+}
+
+SIMD_AVX2_TARGET static void IntegrateIdsAvx2(Vector2* pos_p, const Vector2* vel_p, const U16* ids_p, int count, float deltaT)
+{
+	__m256 deltaT8 = _mm256_set1_ps(deltaT);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i ids = LoadIds4(ids_p + i);
+		__m256 pos = _mm256_add_ps(GatherPairs(pos_p, ids), _mm256_mul_ps(deltaT8, GatherPairs(vel_p, ids)));
+		StoreQuad(pos_p, ids_p + i, pos);
+	}
+	IntegrateIdsScalar(pos_p, vel_p, ids_p + i, count - i, deltaT);
+}
+
+SIMD_AVX2_TARGET static void RotateIdsAvx2(Vector2* facingV_p, const float* rotSpeed_p, const U16* ids_p, int count, float deltaT)
+{
+	__m128 deltaT4 = _mm_set1_ps(deltaT);
+	__m256i laneAngle = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	__m256 sign = _mm256_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i ids = LoadIds4(ids_p + i);
+		__m128 deg = _mm_mul_ps(_mm_i32gather_ps(rotSpeed_p, ids, sizeof(float)), deltaT4);
+		__m256 rad = _mm256_mul_ps(_mm256_set1_ps(SIMD_DEG_TO_RAD), _mm256_permutevar8x32_ps(_mm256_castps128_ps256(deg), laneAngle));
+		__m256 s, c;
+		SinCos256(rad, &s, &c);
+
+		__m256 v = GatherPairs(facingV_p, ids);
+		__m256 swapped = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+		__m256 rotated = _mm256_add_ps(_mm256_mul_ps(v, c), _mm256_mul_ps(swapped, _mm256_xor_ps(s, sign)));
+		StoreQuad(facingV_p, ids_p + i, rotated);
+	}
+	RotateIdsScalar(facingV_p, rotSpeed_p, ids_p + i, count - i, deltaT);
+}
+
+SIMD_AVX2_TARGET static void ExpiredIdsAvx2(const double* tEnabled_p, const U16* ids_p, int count, double time, double lifetime, U32 mask_p[])
+{
+	memset(mask_p, 0, SIMD_MASK_WORDS(count) * sizeof(U32));
+	__m256d time4 = _mm256_set1_pd(time);
+	__m256d lifetime4 = _mm256_set1_pd(lifetime);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m256d tEnabled = _mm256_i32gather_pd(tEnabled_p, LoadIds4(ids_p + i), sizeof(double));
+		U32 bits = (U32)_mm256_movemask_pd(_mm256_cmp_pd(_mm256_sub_pd(time4, tEnabled), lifetime4, _CMP_GT_OQ));
+		mask_p[i >> 5] |= bits << (i & 31);
+	}
+	for (; i < count; i++)
+	{
+		if ((time - tEnabled_p[ids_p[i]]) > lifetime) mask_p[i >> 5] |= 1u << (i & 31);
+	}
+}
+
+SIMD_AVX2_TARGET static void AtLeastAvx2(const float* values_p, int count, float threshold, U32 mask_p[])
+{
+	memset(mask_p, 0, SIMD_MASK_WORDS(count) * sizeof(U32));
+	__m256 threshold8 = _mm256_set1_ps(threshold);
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		U32 bits = (U32)_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values_p + i), threshold8, _CMP_GE_OQ));
+		mask_p[i >> 5] |= bits << (i & 31);
+	}
+	for (; i < count; i++)
+	{
+		if (values_p[i] >= threshold) mask_p[i >> 5] |= 1u << (i & 31);
+	}
+}
+
+static SimdLevelE DetectLevel()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6); // OSXSAVE, AVX, XMM and YMM state saved.
+	bool avx2 = false;
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = osAvx && (info[1] & (1 << 5));
+	}
+#else
+	__builtin_cpu_init();
+	bool sse2 = __builtin_cpu_supports("sse2");
+	bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+	if (avx2) return SIMD_AVX2;
+	if (sse2) return SIMD_SSE2;
+	return SIMD_SCALAR;
+}
+
+#else
+
+static SimdLevelE DetectLevel()
+{
+	return SIMD_SCALAR;
+}
+
+#endif
+
+static const SimdKernels SimdLevels[SIMD_LEVEL_COUNT] =
+{
+	{ MulAddScalar, IntegrateIdsScalar, RotateIdsScalar, ExpiredIdsScalar, AtLeastScalar },
+#if SIMD_X86
+	{ MulAddSse2, IntegrateIdsSse2, RotateIdsSse2, ExpiredIdsSse2, AtLeastSse2 },
+	{ MulAddAvx2, IntegrateIdsAvx2, RotateIdsAvx2, ExpiredIdsAvx2, AtLeastAvx2 },
+#endif
+};
+
+SimdKernels Simd = SimdLevels[SIMD_SCALAR];
+static SimdLevelE simdLevel = SIMD_SCALAR;
+static SimdLevelE maxLevel = SIMD_SCALAR;
+static bool detected = false;
+
+SimdLevelE SimdInit()
+{
+	return SimdSetLevel(SIMD_AVX2);
+}
+
+SimdLevelE SimdMaxLevel()
+{
+	if (!detected)
+	{
+		maxLevel = DetectLevel();
+		detected = true;
+	}
+	return maxLevel;
+}
+
+SimdLevelE SimdGetLevel()
+{
+	return simdLevel;
+}
+
+SimdLevelE SimdSetLevel(SimdLevelE level)
+{
+	if (level > SimdMaxLevel()) level = SimdMaxLevel();
+	simdLevel = level;
+	Simd = SimdLevels[level];
+	return level;
+}
+
+const SimdKernels* SimdGetKernels(SimdLevelE level)
+{
+	return (level <= SimdMaxLevel()) ? &SimdLevels[level] : nullptr;
+}
+
+const char* SimdLevelName(SimdLevelE level)
+{
+	switch (level)
+	{
+	case SIMD_SCALAR: return "scalar";
+	case SIMD_SSE2:   return "sse2";
+	case SIMD_AVX2:   return "avx2";
+	default:          return "unknown";
+	}
+}
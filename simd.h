@@ -0,0 +1,52 @@
+#pragma once
+
+#include "common.h"
+#include "vector.h"
+
+#define SIMD_MASK_WORDS(_COUNT) (((_COUNT) + 31) / 32) // U32 words of a mask with one bit per element.
+
+enum SimdLevelE
+{
+	SIMD_SCALAR,
+	SIMD_SSE2,
+	SIMD_AVX2,
+	SIMD_LEVEL_COUNT,
+};
+
+// Batch kernels of the per tick integration. Entity kernels go through a list of slot ids, the rest run
+// over packed arrays. Masks get bit i of word i / 32 set for element i, bits past count are cleared.
+// Rotation evaluates sin and cos with the same polynomial in every version, so the versions agree to
+// within rounding and don't depend on the C library.
+struct SimdKernels
+{
+	void (*mulAdd)(float* dst_p, const float* src_p, int count, float scale); // dst += scale * src
+	void (*integrateIds)(Vector2* pos_p, const Vector2* vel_p, const U16* ids_p, int count, float deltaT); // pos += deltaT * vel
+	void (*rotateIds)(Vector2* facingV_p, const float* rotSpeed_p, const U16* ids_p, int count, float deltaT); // Rotated by rotSpeed * deltaT degrees.
+	void (*expiredIds)(const double* tEnabled_p, const U16* ids_p, int count, double time, double lifetime, U32 mask_p[]); // time - tEnabled > lifetime
+	void (*atLeast)(const float* values_p, int count, float threshold, U32 mask_p[]); // value >= threshold
+};
+
+// The kernels of the selected level. Scalar until SimdInit picks the widest level the CPU runs.
+extern SimdKernels Simd;
+
+SimdLevelE SimdInit();
+SimdLevelE SimdMaxLevel();
+SimdLevelE SimdGetLevel();
+SimdLevelE SimdSetLevel(SimdLevelE level); // Clamped to SimdMaxLevel, returns the level set.
+const SimdKernels* SimdGetKernels(SimdLevelE level);
+const char* SimdLevelName(SimdLevelE level);
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+static inline int SimdLowestBit(U32 bits)
+{
+	unsigned long index;
+	_BitScanForward(&index, bits);
+	return (int)index;
+}
+#else
+static inline int SimdLowestBit(U32 bits)
+{
+	return __builtin_ctz(bits);
+}
+#endif
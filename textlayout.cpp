@@ -0,0 +1,156 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "hash.h"
+#include "textlayout.h"
+
+void TextLayoutCacheInit(TextLayoutCache* cache_p, int capacity)
+{
+	assert(capacity > 0 && capacity < TEXT_LAYOUT_NONE);
+
+	memset(cache_p, 0, sizeof(*cache_p));
+	cache_p->capacity = capacity;
+	cache_p->runs_p = (TextRun*)malloc(capacity * sizeof(TextRun));
+	cache_p->bucketCount = 1;
+	while (cache_p->bucketCount < 2 * capacity) cache_p->bucketCount *= 2;
+	cache_p->buckets_p = (U16*)malloc(cache_p->bucketCount * sizeof(U16));
+	for (int i = 0; i < cache_p->bucketCount; i++) cache_p->buckets_p[i] = TEXT_LAYOUT_NONE;
+	cache_p->seen_p = (TextLayoutSeen*)calloc(cache_p->bucketCount, sizeof(TextLayoutSeen));
+	cache_p->frame = 1; // Zeroed seen entries then never count as a miss from an earlier frame.
+	cache_p->lruHead = TEXT_LAYOUT_NONE;
+	cache_p->lruTail = TEXT_LAYOUT_NONE;
+}
+
+void TextLayoutCacheFree(TextLayoutCache* cache_p)
+{
+	free(cache_p->runs_p);
+	free(cache_p->buckets_p);
+	free(cache_p->seen_p);
+	memset(cache_p, 0, sizeof(*cache_p));
+}
+
+void TextLayoutCacheEndFrame(TextLayoutCache* cache_p)
+{
+	cache_p->frame++;
+}
+
+static inline unsigned long TextLayoutKey(unsigned long hash, const Font* font_p, float fontSize)
+{
+	return hash ^ ((unsigned long)(size_t)font_p >> 4) ^ ((unsigned long)fontSize * 2654435761u);
+}
+
+static void LruUnlink(TextLayoutCache* cache_p, U16 index)
+{
+	TextRun* run_p = &cache_p->runs_p[index];
+	if (run_p->lruPrev != TEXT_LAYOUT_NONE) cache_p->runs_p[run_p->lruPrev].lruNext = run_p->lruNext;
+	else cache_p->lruHead = run_p->lruNext;
+	if (run_p->lruNext != TEXT_LAYOUT_NONE) cache_p->runs_p[run_p->lruNext].lruPrev = run_p->lruPrev;
+	else cache_p->lruTail = run_p->lruPrev;
+}
+
+static void LruPushFront(TextLayoutCache* cache_p, U16 index)
+{
+	TextRun* run_p = &cache_p->runs_p[index];
+	run_p->lruPrev = TEXT_LAYOUT_NONE;
+	run_p->lruNext = cache_p->lruHead;
+	if (cache_p->lruHead != TEXT_LAYOUT_NONE) cache_p->runs_p[cache_p->lruHead].lruPrev = index;
+	else cache_p->lruTail = index;
+	cache_p->lruHead = index;
+}
+
+static void BucketRemove(TextLayoutCache* cache_p, U16 index)
+{
+	TextRun* run_p = &cache_p->runs_p[index];
+	U16* link_p = &cache_p->buckets_p[TextLayoutKey(run_p->hash, run_p->font_p, run_p->fontSize) & (cache_p->bucketCount - 1)];
+	while (*link_p != index)
+	{
+		assert(*link_p != TEXT_LAYOUT_NONE);
+		link_p = &cache_p->runs_p[*link_p].hashNext;
+	}
+	*link_p = run_p->hashNext;
+}
+
+// Same walk as the uncached PushText, with the pen starting at the origin.
+static void TextLayoutBuild(TextRun* run_p, const Font* font_p, float fontSize, const char* text)
+{
+	float posX = 0;
+	float posY = 0;
+	run_p->glyphCount = 0;
+	for (; *text; text++)
+	{
+		if (*text < 32 || *text >= 128) continue;
+
+		TextGlyph* glyph_p = &run_p->glyphs[run_p->glyphCount++];
+		glyph_p->penX = posX;
+		stbtt_aligned_quad quad;
+		FontGetQuad(font_p, fontSize, *text - FONT_FIRST_CHAR, &posX, &posY, &quad);
+		glyph_p->x0 = quad.x0; glyph_p->y0 = quad.y0; glyph_p->x1 = quad.x1; glyph_p->y1 = quad.y1;
+		glyph_p->s0 = quad.s0; glyph_p->t0 = quad.t0; glyph_p->s1 = quad.s1; glyph_p->t1 = quad.t1;
+	}
+	run_p->width = posX;
+}
+
+const TextRun* TextLayoutGet(TextLayoutCache* cache_p, const Font* font_p, float fontSize, const char* text)
+{
+	int textLength = (int)strlen(text);
+	if (textLength > TEXT_LAYOUT_MAX_CHARS)
+	{
+		cache_p->stats.uncached++;
+		return nullptr;
+	}
+
+	unsigned long hash = HashString((unsigned const char*)text);
+	unsigned long key = TextLayoutKey(hash, font_p, fontSize);
+	U16* bucket_p = &cache_p->buckets_p[key & (cache_p->bucketCount - 1)];
+	for (U16 index = *bucket_p; index != TEXT_LAYOUT_NONE; index = cache_p->runs_p[index].hashNext)
+	{
+		TextRun* run_p = &cache_p->runs_p[index];
+		if (run_p->hash != hash || run_p->font_p != font_p || run_p->fontSize != fontSize || run_p->textLength != textLength) continue;
+		if (memcmp(run_p->text, text, textLength) != 0) continue;
+
+		cache_p->stats.hits++;
+		if (cache_p->lruHead != index)
+		{
+			LruUnlink(cache_p, index);
+			LruPushFront(cache_p, index);
+		}
+		return run_p;
+	}
+
+	// First miss, or only missed earlier in this frame: remember it instead of evicting a run for it.
+	TextLayoutSeen* seen_p = &cache_p->seen_p[key & (cache_p->bucketCount - 1)];
+	if (seen_p->key != key || seen_p->frame == cache_p->frame)
+	{
+		seen_p->key = key;
+		seen_p->frame = cache_p->frame;
+		cache_p->stats.skipped++;
+		return nullptr;
+	}
+
+	cache_p->stats.misses++;
+	U16 index;
+	if (cache_p->count < cache_p->capacity)
+	{
+		index = (U16)cache_p->count++;
+	}
+	else
+	{
+		index = cache_p->lruTail;
+		LruUnlink(cache_p, index);
+		BucketRemove(cache_p, index);
+		cache_p->stats.evictions++;
+	}
+
+	TextRun* run_p = &cache_p->runs_p[index];
+	run_p->hash = hash;
+	run_p->font_p = font_p;
+	run_p->fontSize = fontSize;
+	run_p->textLength = textLength;
+	memcpy(run_p->text, text, textLength + 1);
+	TextLayoutBuild(run_p, font_p, fontSize, text);
+
+	run_p->hashNext = *bucket_p;
+	*bucket_p = index;
+	LruPushFront(cache_p, index);
+	return run_p;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "common.h"
+#include "font.h"
+
+#define TEXT_LAYOUT_MAX_CHARS    64  // Longer strings are laid out every time instead of cached.
+#define TEXT_LAYOUT_CACHE_SIZE   256
+#define TEXT_LAYOUT_NONE         U16_MAX
+
+// Glyph quad laid out with the pen starting at the origin.
+struct TextGlyph
+{
+	float penX;  // Pen position before this glyph, PushText clips against it.
+	float x0, y0, x1, y1;
+	float s0, t0, s1, t1;
+};
+
+// A string laid out once: its quads relative to the pen start and its total advance.
+struct TextRun
+{
+	unsigned long hash;
+	const Font* font_p;
+	float fontSize;
+	int textLength;
+	char text[TEXT_LAYOUT_MAX_CHARS + 1]; // Compared on lookup, so hash collisions never return the wrong run.
+
+	float width;
+	int glyphCount;
+	TextGlyph glyphs[TEXT_LAYOUT_MAX_CHARS];
+
+	U16 hashNext; // Next run in the same bucket.
+	U16 lruPrev;  // Towards the most recently used run.
+	U16 lruNext;  // Towards the least recently used run.
+};
+
+struct TextLayoutStats
+{
+	U64 hits;
+	U64 misses;
+	U64 evictions;
+	U64 uncached; // Lookups of strings too long to cache.
+	U64 skipped;  // Misses on strings not seen in an earlier frame, laid out without caching them.
+};
+
+// Recently missed string, a second miss in a later frame adds it to the cache.
+struct TextLayoutSeen
+{
+	unsigned long key;
+	U32 frame;
+};
+
+// Runs keyed by string hash + font + size. Lookups go through a hashed bucket table, and once every run
+// is taken the least recently used one is evicted. A string is only added when it was also missed in an
+// earlier frame, so labels that change every frame (timers, stats) never evict the runs worth keeping.
+struct TextLayoutCache
+{
+	int capacity;
+	int count;
+	TextRun* runs_p;
+	int bucketCount;     // Power of two.
+	U16* buckets_p;
+	U16 lruHead;         // Most recently used.
+	U16 lruTail;         // Least recently used, evicted next.
+	TextLayoutSeen* seen_p; // bucketCount entries, indexed like the buckets.
+	U32 frame;
+	TextLayoutStats stats;
+};
+
+void TextLayoutCacheInit(TextLayoutCache* cache_p, int capacity);
+void TextLayoutCacheFree(TextLayoutCache* cache_p);
+void TextLayoutCacheEndFrame(TextLayoutCache* cache_p);
+
+// Layout of text in the given font, nullptr when the text is longer than TEXT_LAYOUT_MAX_CHARS or
+// wasn't missed in an earlier frame yet.
+// The run stays valid until the next lookup.
+const TextRun* TextLayoutGet(TextLayoutCache* cache_p, const Font* font_p, float fontSize, const char* text);
@@ -12,6 +12,12 @@
 #define TEXTURE_EXPLOSIONSMALL 8
 #define TEXTURE_TURRET         9
 #define TEXTURES_COUNT         10
+#define TEXTURE_ATLAS          TEXTURES_COUNT       // All of the above packed into one texture, see atlas.h.
+#define TEXTURE_STREAMED_FIRST (TEXTURE_ATLAS + 1)  // Loaded while the game runs, see texturestream.h.
+#define MAX_STREAMED_TEXTURES  8
+#define MAX_TEXTURE_HANDLES    (TEXTURE_STREAMED_FIRST + MAX_STREAMED_TEXTURES)
+#define TEXTURE_HANDLE_NONE    -1
+#define MAX_TEXTURE_LOAD_THREADS 8
 
 struct Texture
 {
@@ -21,4 +27,6 @@ struct Texture
 	U8* data_p;
 };
 
-Texture LoadTexture(const char* filepath);
\ No newline at end of file
+Texture LoadTexture(const char* filepath);
+void LoadTextures(const char* const filepaths[], int count, Texture textures[]); // Decoded in parallel, flipped like LoadTexture.
+void FreeTexture(Texture* texture_p); // Only for textures from LoadTexture(s).
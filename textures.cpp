@@ -1,5 +1,7 @@
 #include <stb_image.h>
 #include <assert.h>
+#include <atomic>
+#include <thread>
 #include "texture.h"
 
 Texture LoadTexture(const char* filepath)
@@ -12,4 +14,35 @@ Texture LoadTexture(const char* filepath)
 	assert(tex.nrChannels == 3 || tex.nrChannels == 4);
 
 	return tex;
-}
\ No newline at end of file
+}
+
+static void LoadTexturesWorker(const char* const filepaths[], int count, Texture textures[], std::atomic<int>* next_p)
+{
+	stbi_set_flip_vertically_on_load_thread(true); // The global flag isn't safe to set from several threads.
+	for (int i = next_p->fetch_add(1); i < count; i = next_p->fetch_add(1))
+	{
+		Texture* tex_p = &textures[i];
+		tex_p->data_p = stbi_load(filepaths[i], &tex_p->width, &tex_p->height, &tex_p->nrChannels, 0);
+		assert(tex_p->data_p);
+		assert(tex_p->nrChannels == 3 || tex_p->nrChannels == 4);
+	}
+}
+
+void LoadTextures(const char* const filepaths[], int count, Texture textures[])
+{
+	int threadCount = (int)std::thread::hardware_concurrency();
+	if (threadCount > count) threadCount = count;
+	if (threadCount > MAX_TEXTURE_LOAD_THREADS) threadCount = MAX_TEXTURE_LOAD_THREADS;
+
+	std::atomic<int> next(0);
+	std::thread threads[MAX_TEXTURE_LOAD_THREADS];
+	for (int t = 1; t < threadCount; t++) threads[t] = std::thread(LoadTexturesWorker, filepaths, count, textures, &next);
+	LoadTexturesWorker(filepaths, count, textures, &next);
+	for (int t = 1; t < threadCount; t++) threads[t].join();
+}
+
+void FreeTexture(Texture* texture_p)
+{
+	stbi_image_free(texture_p->data_p);
+	texture_p->data_p = nullptr;
+}
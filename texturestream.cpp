@@ -0,0 +1,121 @@
+#include <stb_image.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "timing.h"
+#include "texturestream.h"
+
+// Takes whatever step is due for each texture, returns false when there was nothing to do.
+static bool LoaderStep(TextureStream* stream_p)
+{
+	bool worked = false;
+	for (int i = 0; i < MAX_STREAMED_TEXTURES; i++)
+	{
+		StreamedTexture* tex_p = &stream_p->textures[i];
+		U32 state = tex_p->state.load(std::memory_order_acquire);
+		if (state == STREAMED_TEXTURE_QUEUED)
+		{
+			int channels;
+			tex_p->pixels_p = stbi_load(tex_p->path, &tex_p->width, &tex_p->height, &channels, 4);
+			if (!tex_p->pixels_p)
+			{
+				printf("ERROR: Could not load streamed texture %s\n", tex_p->path);
+				stream_p->stats.failed++;
+			}
+			tex_p->state.store(tex_p->pixels_p ? STREAMED_TEXTURE_SIZED : STREAMED_TEXTURE_FAILED, std::memory_order_release);
+			worked = true;
+		}
+		else if (state == STREAMED_TEXTURE_MAPPED)
+		{
+			memcpy(tex_p->mapped_p, tex_p->pixels_p, (size_t)tex_p->width * tex_p->height * 4);
+			stbi_image_free(tex_p->pixels_p);
+			tex_p->pixels_p = nullptr;
+			tex_p->state.store(STREAMED_TEXTURE_FILLED, std::memory_order_release);
+			worked = true;
+		}
+	}
+	return worked;
+}
+
+static void LoaderMain(TextureStream* stream_p)
+{
+	stbi_set_flip_vertically_on_load_thread(true); // Same orientation as LoadTexture.
+	while (!stream_p->quit.load(std::memory_order_acquire))
+	{
+		if (LoaderStep(stream_p)) continue;
+
+		std::unique_lock<std::mutex> lock(stream_p->mutex);
+		stream_p->wake.wait(lock, [stream_p] { return stream_p->pending || stream_p->quit.load(std::memory_order_acquire); });
+		stream_p->pending = false;
+	}
+}
+
+void TextureStreamStart(TextureStream* stream_p)
+{
+	for (int i = 0; i < MAX_STREAMED_TEXTURES; i++)
+	{
+		StreamedTexture* tex_p = &stream_p->textures[i];
+		tex_p->state.store(STREAMED_TEXTURE_FREE);
+		tex_p->path[0] = '\0';
+		tex_p->pixels_p = nullptr;
+		tex_p->mapped_p = nullptr;
+	}
+	stream_p->stats = {};
+	stream_p->pending = false;
+	stream_p->quit.store(false);
+	stream_p->loader = std::thread(LoaderMain, stream_p);
+}
+
+void TextureStreamStop(TextureStream* stream_p)
+{
+	assert(stream_p->loader.joinable());
+	stream_p->quit.store(true, std::memory_order_release);
+	TextureStreamWake(stream_p);
+	stream_p->loader.join();
+
+	for (int i = 0; i < MAX_STREAMED_TEXTURES; i++)
+	{
+		stbi_image_free(stream_p->textures[i].pixels_p);
+		stream_p->textures[i].pixels_p = nullptr;
+	}
+}
+
+void TextureStreamWake(TextureStream* stream_p)
+{
+	{
+		std::lock_guard<std::mutex> lock(stream_p->mutex);
+		stream_p->pending = true;
+	}
+	stream_p->wake.notify_one();
+}
+
+TextureHandleT TextureStreamRequest(TextureStream* stream_p, const char* path)
+{
+	assert(strlen(path) < TEXTURE_STREAM_PATH_SIZE);
+	for (int i = 0; i < MAX_STREAMED_TEXTURES; i++)
+	{
+		StreamedTexture* tex_p = &stream_p->textures[i];
+		if (tex_p->state.load(std::memory_order_acquire) != STREAMED_TEXTURE_FREE) continue;
+
+		strcpy(tex_p->path, path);
+		tex_p->width = 0;
+		tex_p->height = 0;
+		tex_p->tRequested = GetTime();
+		tex_p->state.store(STREAMED_TEXTURE_QUEUED, std::memory_order_release);
+		stream_p->stats.requested++;
+		TextureStreamWake(stream_p);
+		return (TextureHandleT)(TEXTURE_STREAMED_FIRST + i);
+	}
+	return TEXTURE_HANDLE_NONE;
+}
+
+void TextureStreamRelease(TextureStream* stream_p, TextureHandleT textureHandle)
+{
+	assert(textureHandle >= TEXTURE_STREAMED_FIRST && textureHandle < MAX_TEXTURE_HANDLES);
+	StreamedTexture* tex_p = &stream_p->textures[textureHandle - TEXTURE_STREAMED_FIRST];
+
+	// In flight textures finish their upload first, only resident and failed ones can be released.
+	U32 state = tex_p->state.load(std::memory_order_acquire);
+	assert(state == STREAMED_TEXTURE_RESIDENT || state == STREAMED_TEXTURE_FAILED);
+	if (state == STREAMED_TEXTURE_RESIDENT || state == STREAMED_TEXTURE_FAILED) tex_p->state.store(STREAMED_TEXTURE_RELEASED, std::memory_order_release);
+}
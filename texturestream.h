@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "common.h"
+#include "renderer.h"
+
+#define TEXTURE_STREAM_PATH_SIZE 128
+
+// Where a streamed texture is on its way to the GPU. Each step is taken by one thread only:
+//   game    FREE -> QUEUED          TextureStreamRequest
+//   loader  QUEUED -> SIZED         decoded to RGBA8, waiting for a pixel buffer
+//   backend SIZED -> MAPPED         pixel buffer object created and mapped
+//   loader  MAPPED -> FILLED        pixels copied into the mapping
+//   backend FILLED -> UPLOADING     glTexSubImage2D from the buffer, fenced
+//   backend UPLOADING -> RESIDENT   fence signaled, sprites draw with it from now on
+//   game    RESIDENT -> RELEASED    TextureStreamRelease, the backend deletes it and frees the slot
+// Until a texture is resident the backend draws its sprites with a placeholder.
+enum StreamedTextureStateE : U32
+{
+	STREAMED_TEXTURE_FREE,
+	STREAMED_TEXTURE_QUEUED,
+	STREAMED_TEXTURE_SIZED,
+	STREAMED_TEXTURE_MAPPED,
+	STREAMED_TEXTURE_FILLED,
+	STREAMED_TEXTURE_UPLOADING,
+	STREAMED_TEXTURE_RESIDENT,
+	STREAMED_TEXTURE_RELEASED,
+	STREAMED_TEXTURE_FAILED,  // Couldn't be decoded, keeps drawing with the placeholder until released.
+};
+
+struct StreamedTexture
+{
+	std::atomic<U32> state;  // StreamedTextureStateE.
+	char path[TEXTURE_STREAM_PATH_SIZE];
+	int width;
+	int height;
+	U8* pixels_p;            // Decoded by the loader, freed once copied into the mapping.
+	U8* mapped_p;            // Pixel buffer mapping, set by the backend.
+	double tRequested;
+};
+
+struct TextureStreamStats
+{
+	U32 requested;
+	U32 resident;
+	U32 failed;
+	U64 bytesUploaded;
+	double residentSeconds; // Request to resident, summed over every resident texture.
+};
+
+// Textures loaded while the game runs: a loader thread decodes them, the backend uploads them through
+// pixel buffer objects without waiting on the GPU. They take the handles from TEXTURE_STREAMED_FIRST on
+// and are never packed into the atlas.
+struct TextureStream
+{
+	StreamedTexture textures[MAX_STREAMED_TEXTURES];
+	std::thread loader;
+	std::mutex mutex;            // Only guards the wakeup.
+	std::condition_variable wake;
+	bool pending;
+	std::atomic<bool> quit;
+	TextureStreamStats stats;    // Every field is only written by one of the threads.
+};
+
+void TextureStreamStart(TextureStream* stream_p);
+void TextureStreamStop(TextureStream* stream_p);
+// Game thread. TEXTURE_HANDLE_NONE when every slot is taken.
+TextureHandleT TextureStreamRequest(TextureStream* stream_p, const char* path);
+void TextureStreamRelease(TextureStream* stream_p, TextureHandleT textureHandle);
+// Wakes the loader, for the backend after it mapped a buffer.
+void TextureStreamWake(TextureStream* stream_p);
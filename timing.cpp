@@ -0,0 +1,8 @@
+#include <chrono>
+#include "timing.h"
+
+double GetTime()
+{
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
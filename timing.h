@@ -1,8 +1,4 @@
 #pragma once
 
-#include <GLFW/glfw3.h>
-
-double GetTime()
-{
-	return glfwGetTime();
-}
\ No newline at end of file
+// Seconds from a monotonic clock. Doesn't go through glfw so it also works without a window.
+double GetTime();
@@ -234,7 +234,7 @@ static int FindClosestCharIdx(char* textBuf, int textLen, float startPosX, float
 	int charIdx = 0;
 	for (int i = 0; i <= textLen; i++)
 	{
-		float xposChar = GetCharPosX(ui.renderer_p->textRendering.charUvData, startPosX, textBuf, i);
+		float xposChar = GetCharPosX(&ui.renderer_p->textRendering.font, startPosX, textBuf, i);
 		float dist = fabs(xposChar - xpos);
 		if (dist < closestDist) { closestDist = dist; charIdx = i; }
 		else break;
@@ -392,7 +392,7 @@ void UITextInput(Rect rect, char* textBuf)
 
 	// Text cursor graphics
 	int cursorPeriodInFrames = TEXT_CURSOR_BLINKING_PERIOD / ui.deltaT;
-	float xpos = GetCharPosX(ui.renderer_p->textRendering.charUvData, rect.pos.x + 6, textBuf, textInputText_p->cursorIdx);
+	float xpos = GetCharPosX(&ui.renderer_p->textRendering.font, rect.pos.x + 6, textBuf, textInputText_p->cursorIdx);
 	bool cursorMoved = prevCursorIdx != textInputText_p->cursorIdx;
 	if (ui.frameCnt % cursorPeriodInFrames < (cursorPeriodInFrames / 2) || cursorMoved)
 	{
@@ -402,7 +402,7 @@ void UITextInput(Rect rect, char* textBuf)
 	// Selection graphics
 	if (textInputText_p->cursorIdx != textInputText_p->selectionEndIdx)
 	{
-		float endxpos = GetCharPosX(ui.renderer_p->textRendering.charUvData, rect.pos.x + 6, textBuf, textInputText_p->selectionEndIdx);;
+		float endxpos = GetCharPosX(&ui.renderer_p->textRendering.font, rect.pos.x + 6, textBuf, textInputText_p->selectionEndIdx);;
 		float minx = fmin(xpos, endxpos);
 		float maxx = fmax(xpos, endxpos);
 		float xsize = maxx - minx;